@@ -1,6 +1,10 @@
 #ifndef  _MEMORY_POOL_H_
 #define  _MEMORY_POOL_H_
 
+#include <new>
+#include <vector>
+#include <iostream>
+
 namespace MeshLib
 {
 
@@ -161,6 +165,105 @@ protected:
 	std::vector<T*> m_pool;
 };
 
+/*!
+*	\brief CMArena, chunked arena for the mesh elements
+*
+*	Unlike CMPool, T does not need next()/prev(). The elements are placed one after
+*	another in chunks, in the order of allocation; a chunk is twice as large as the
+*	previous one. A delocated element is destructed and its slot is put onto a free
+*	list, the next allocate() reuses it. The destructor releases the chunks without
+*	touching the elements, the owner destructs the living elements with delocate()
+*	or destruct() beforehand.
+*/
+template<typename T>
+class CMArena
+{
+public:
+
+	CMArena<T>( size_t size=4096 )
+	{
+		m_size  = size;
+		m_used  = size;
+		m_free  = NULL;
+		m_count = 0;
+	};
+
+	~CMArena<T>()
+	{
+		for( size_t i = 0; i < m_pool.size(); i ++ )
+		{
+			::operator delete( m_pool[i] );
+		}
+		m_pool.clear();
+		m_free = NULL;
+	};
+
+	/*! construct a new element, in a recycled slot if there is one */
+	T * allocate()
+	{
+		void * p = NULL;
+
+		if( m_free != NULL )
+		{
+			p = m_free;
+			m_free = m_free->next;
+		}
+		else
+		{
+			if( m_used == m_size )
+			{
+				if( !m_pool.empty() ) m_size *= 2;
+				m_pool.push_back( (char*) ::operator new( m_size * sizeof(T) ) );
+				m_used = 0;
+			}
+			p = m_pool.back() + m_used * sizeof(T);
+			m_used ++;
+		}
+
+		m_count ++;
+		return new( p ) T();
+	};
+
+	/*! destruct an element and recycle its slot */
+	void delocate( T * t )
+	{
+		t->~T();
+		CFreeSlot * s = (CFreeSlot*) (void*) t;
+		s->next = m_free;
+		m_free  = s;
+		m_count --;
+	};
+
+	/*! destruct an element without recycling, used before the arena is released */
+	void destruct( T * t )
+	{
+		t->~T();
+		m_count --;
+	};
+
+	/*! number of living elements */
+	size_t size() { return m_count; };
+
+protected:
+
+	/*! a free slot stores the link to the next free slot */
+	struct CFreeSlot { CFreeSlot * next; };
+
+	CMArena<T>( const CMArena<T> & );
+	CMArena<T> & operator=( const CMArena<T> & );
+
+	/*! list of the free slots */
+	CFreeSlot * m_free;
+	/*! size of the last chunk */
+	size_t m_size;
+	/*! number of used slots in the last chunk */
+	size_t m_used;
+	/*! number of living elements */
+	size_t m_count;
+	/*! the chunks */
+	std::vector<char*> m_pool;
+};
+
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,202 @@
+/*!
+*      \file SimdMath.h
+*      \brief Batched arc cosine and cosine law, with SSE2 or AVX
+*
+*		acos is reduced to asin on [0, 1/2]: acos(x) = pi/2 - asin(x) for |x| <= 1/2,
+*		and acos(x) = 2 asin( sqrt( (1-|x|)/2 ) ), reflected for x < 0, otherwise.
+*		asin(t) = t + t z p(z), z = t^2, with p a degree 11 polynomial fitted at the
+*		Chebyshev nodes of [0, 1/4] and evaluated with the Estrin scheme. The fit
+*		error is below 3e-17, the absolute error of acosFast is below 1e-15.
+*
+*		The kernel is written once for a value type V: double, CSimd2 ( SSE2, two
+*		doubles ) or CSimd4 ( AVX, four doubles ). All the paths evaluate the same
+*		operations in the same order, so they give the same results.
+*/
+
+#ifndef _MESHLIB_SIMD_MATH_H_
+#define _MESHLIB_SIMD_MATH_H_
+
+#include <math.h>
+#include <stddef.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#define MESHLIB_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX__)
+#define MESHLIB_AVX
+#include <immintrin.h>
+#endif
+
+namespace MeshLib{
+
+/*! coefficients of p(z), asin(t) = t + t z p(z), constant term first */
+static const double ASIN_COEF[12] = {
+	0.1666666666666665,    0.07500000000020764,  0.044642857103423646, 0.03038194736709848,
+	0.02237204763174451,   0.017355259955786323, 0.013929652902326633, 0.011875494382636922,
+	0.0078029494773533175, 0.01603551434914882, -0.010749050339697808, 0.028169218060881414 };
+
+/*! pi/2 */
+static const double HALF_PI = 1.57079632679489661923;
+
+/*
+*	scalar operations of the kernel
+*/
+
+/*! value c in all the lanes */
+template<typename V> V simdSet( double c );
+template<> inline double simdSet<double>( double c )		{ return c; };
+/*! a > b ? a : b, b if a is NaN */
+inline double simdMax( double a, double b )				{ return ( a > b )? a : b; };
+/*! a < b ? a : b, b if a is NaN */
+inline double simdMin( double a, double b )				{ return ( a < b )? a : b; };
+/*! |a| */
+inline double simdAbs( double a )						{ return fabs( a ); };
+/*! square root */
+inline double simdSqrt( double a )						{ return sqrt( a ); };
+/*! a < b */
+inline bool   simdLess( double a, double b )			{ return a < b; };
+/*! mask ? a : b */
+inline double simdSelect( bool mask, double a, double b )	{ return mask ? a : b; };
+
+#ifdef MESHLIB_SSE2
+/*!
+*	\brief CSimd2, two doubles in an SSE2 register
+*/
+struct CSimd2
+{
+	/*! the lanes */
+	__m128d v;
+	/*! CSimd2 constructor */
+	CSimd2() {};
+	/*! CSimd2 constructor */
+	CSimd2( __m128d x ) : v( x ) {};
+	/*! load two doubles */
+	static CSimd2 load( const double * p )	{ return _mm_loadu_pd( p ); };
+	/*! store two doubles */
+	void store( double * p ) const			{ _mm_storeu_pd( p, v ); };
+};
+
+inline CSimd2 operator+( CSimd2 a, CSimd2 b )	{ return _mm_add_pd( a.v, b.v ); };
+inline CSimd2 operator-( CSimd2 a, CSimd2 b )	{ return _mm_sub_pd( a.v, b.v ); };
+inline CSimd2 operator*( CSimd2 a, CSimd2 b )	{ return _mm_mul_pd( a.v, b.v ); };
+inline CSimd2 operator/( CSimd2 a, CSimd2 b )	{ return _mm_div_pd( a.v, b.v ); };
+template<> inline CSimd2 simdSet<CSimd2>( double c )	{ return _mm_set1_pd( c ); };
+inline CSimd2 simdMax( CSimd2 a, CSimd2 b )		{ return _mm_max_pd( a.v, b.v ); };
+inline CSimd2 simdMin( CSimd2 a, CSimd2 b )		{ return _mm_min_pd( a.v, b.v ); };
+inline CSimd2 simdAbs( CSimd2 a )				{ return _mm_andnot_pd( _mm_set1_pd( -0.0 ), a.v ); };
+inline CSimd2 simdSqrt( CSimd2 a )				{ return _mm_sqrt_pd( a.v ); };
+inline CSimd2 simdLess( CSimd2 a, CSimd2 b )	{ return _mm_cmplt_pd( a.v, b.v ); };
+inline CSimd2 simdSelect( CSimd2 mask, CSimd2 a, CSimd2 b )	{ return _mm_or_pd( _mm_and_pd( mask.v, a.v ), _mm_andnot_pd( mask.v, b.v ) ); };
+#endif
+
+#ifdef MESHLIB_AVX
+/*!
+*	\brief CSimd4, four doubles in an AVX register
+*/
+struct CSimd4
+{
+	/*! the lanes */
+	__m256d v;
+	/*! CSimd4 constructor */
+	CSimd4() {};
+	/*! CSimd4 constructor */
+	CSimd4( __m256d x ) : v( x ) {};
+	/*! load four doubles */
+	static CSimd4 load( const double * p )	{ return _mm256_loadu_pd( p ); };
+	/*! store four doubles */
+	void store( double * p ) const			{ _mm256_storeu_pd( p, v ); };
+};
+
+inline CSimd4 operator+( CSimd4 a, CSimd4 b )	{ return _mm256_add_pd( a.v, b.v ); };
+inline CSimd4 operator-( CSimd4 a, CSimd4 b )	{ return _mm256_sub_pd( a.v, b.v ); };
+inline CSimd4 operator*( CSimd4 a, CSimd4 b )	{ return _mm256_mul_pd( a.v, b.v ); };
+inline CSimd4 operator/( CSimd4 a, CSimd4 b )	{ return _mm256_div_pd( a.v, b.v ); };
+template<> inline CSimd4 simdSet<CSimd4>( double c )	{ return _mm256_set1_pd( c ); };
+inline CSimd4 simdMax( CSimd4 a, CSimd4 b )		{ return _mm256_max_pd( a.v, b.v ); };
+inline CSimd4 simdMin( CSimd4 a, CSimd4 b )		{ return _mm256_min_pd( a.v, b.v ); };
+inline CSimd4 simdAbs( CSimd4 a )				{ return _mm256_andnot_pd( _mm256_set1_pd( -0.0 ), a.v ); };
+inline CSimd4 simdSqrt( CSimd4 a )				{ return _mm256_sqrt_pd( a.v ); };
+inline CSimd4 simdLess( CSimd4 a, CSimd4 b )	{ return _mm256_cmp_pd( a.v, b.v, _CMP_LT_OQ ); };
+inline CSimd4 simdSelect( CSimd4 mask, CSimd4 a, CSimd4 b )	{ return _mm256_blendv_pd( b.v, a.v, mask.v ); };
+#endif
+
+/*! arc cosine, x is clamped to [-1,1] */
+template<typename V>
+inline V acosFast( V x )
+{
+	const V one  = simdSet<V>( 1.0 );
+	const V half = simdSet<V>( 0.5 );
+	const V hpi  = simdSet<V>( HALF_PI );
+
+	x = simdMax( x, simdSet<V>( -1.0 ) );
+	x = simdMin( x, one );
+
+	V ax = simdAbs( x );
+	V z  = simdSelect( simdLess( half, ax ), ( one - ax ) * half, ax * ax );
+	V t  = simdSelect( simdLess( half, ax ), simdSqrt( z ), ax );
+
+	//Estrin scheme
+	V z2 = z * z;
+	V z4 = z2 * z2;
+	V c[6];
+	for( int k = 0; k < 6; k ++ ) c[k] = simdSet<V>( ASIN_COEF[2*k] ) + simdSet<V>( ASIN_COEF[2*k+1] ) * z;
+	V p = ( c[0] + c[1] * z2 ) + ( c[2] + c[3] * z2 ) * z4 + ( c[4] + c[5] * z2 ) * ( z4 * z4 );
+
+	V a  = t + t * z * p;
+	V a2 = a + a;
+	V rb = simdSelect( simdLess( x, simdSet<V>( 0.0 ) ), ( hpi + hpi ) - a2, a2 );
+	V rs = simdSelect( simdLess( x, simdSet<V>( 0.0 ) ), hpi + a, hpi - a );
+	return simdSelect( simdLess( half, ax ), rb, rs );
+};
+
+/*!
+	angle opposite to c in the triangle with edge lengths a, b, c; if a or b is zero
+	the angle is pi/2, the limit of the two angles at a vanishing edge
+*/
+template<typename V>
+inline V cosineLawFast( V a, V b, V c )
+{
+	V d = simdSet<V>( 2.0 ) * ( a * b );
+	V x = ( a * a + b * b - c * c ) / d;
+	return acosFast( simdSelect( simdLess( simdSet<V>( 0.0 ), d ), x, simdSet<V>( 0.0 ) ) );
+};
+
+/*!
+	Arc cosines of n values.
+	\param x the values, clamped to [-1,1]
+	\param y the angles, may be x
+*/
+inline void acosBatch( const double * x, double * y, size_t n )
+{
+	size_t i = 0;
+#ifdef MESHLIB_AVX
+	for( ; i + 4 <= n; i += 4 ) acosFast( CSimd4::load( x + i ) ).store( y + i );
+#endif
+#ifdef MESHLIB_SSE2
+	for( ; i + 2 <= n; i += 2 ) acosFast( CSimd2::load( x + i ) ).store( y + i );
+#endif
+	for( ; i < n; i ++ ) y[i] = acosFast( x[i] );
+};
+
+/*!
+	Angles of n triangles by the cosine law.
+	\param a,b,c edge lengths of the triangles
+	\param angle the angles opposite to c, the cosine is clamped to [-1,1], pi/2 if a or b is zero
+*/
+inline void cosineLawBatch( const double * a, const double * b, const double * c, double * angle, size_t n )
+{
+	size_t i = 0;
+#ifdef MESHLIB_AVX
+	for( ; i + 4 <= n; i += 4 ) cosineLawFast( CSimd4::load( a + i ), CSimd4::load( b + i ), CSimd4::load( c + i ) ).store( angle + i );
+#endif
+#ifdef MESHLIB_SSE2
+	for( ; i + 2 <= n; i += 2 ) cosineLawFast( CSimd2::load( a + i ), CSimd2::load( b + i ), CSimd2::load( c + i ) ).store( angle + i );
+#endif
+	for( ; i < n; i ++ ) angle[i] = cosineLawFast( a[i], b[i], c[i] );
+};
+
+}//name space MeshLib
+
+#endif //_MESHLIB_SIMD_MATH_H_ defined
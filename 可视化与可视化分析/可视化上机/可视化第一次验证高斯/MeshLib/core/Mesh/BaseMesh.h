@@ -23,7 +23,17 @@
 
 #include "../Geometry/Point.h"
 #include "../Geometry/Point2.h"
+#include "../Geometry/MemoryPool.h"
 #include "../Parser/StrUtil.h"
+#include "../Parser/MappedFile.h"
+#include "../Parser/MeshRecord.h"
+#include "../Parser/BinaryFormat.h"
+#include "../Parser/TextWriter.h"
+#include "../Parallel/Parallel.h"
+#include "../Spatial/Weld.h"
+#include "IdIndex.h"
+#include "EdgeTable.h"
+#include "TraitColumns.h"
 
 namespace MeshLib{
 
@@ -55,7 +65,7 @@ public:
 	/*!
 	CBaseMesh constructor.
 	*/
-	CBaseMesh(){};
+	CBaseMesh(){ m_keep_edge_table = false; m_load_threads = 0; m_write_threads = 0; m_weld_epsilon = -1; m_parallel_traits = false; m_trait_strings = true; m_edge_table_active = true; };
 	/*!
 	CBasemesh destructor
 	*/
@@ -90,6 +100,18 @@ public:
 	*/
 	void write_m( const char * output);
 	/*!
+	Read a binary .mb file, see Parser/BinaryFormat.h.
+	\param input the input .mb file name
+	*/
+	void read_mb( const char * input );
+	/*!
+	Write a binary .mb file, the same content as an .m file with exact coordinates.
+	\param output the output .mb file name
+	\param uv     whether to write the vertex uv column
+	\param normal whether to write the vertex normal column
+	*/
+	void write_mb( const char * output, bool uv = false, bool normal = false );
+	/*!
 	Write an .g file.
 	\param output the output .g file name
 	*/
@@ -419,9 +441,157 @@ protected:
   //maps
 
   /*! map between vetex and its id*/
-  std::map<int, tVertex>                    m_map_vert;
+  CIdIndex<CVertex>                         m_map_vert;
   /*! map between face and its id*/
-  std::map<int, tFace>						m_map_face;
+  CIdIndex<CFace>							m_map_face;
+  /*! hash table between the end vertex ids and the edge */
+  CEdgeTable<CEdge>							m_edge_table;
+  /*! whether m_edge_table is up to date, otherwise the vertex edge lists are scanned */
+  bool										m_edge_table_active;
+
+  /*! arena of the vertices */
+  CMArena<CVertex>							m_vertex_pool;
+  /*! arena of the edges */
+  CMArena<CEdge>							m_edge_pool;
+  /*! arena of the faces */
+  CMArena<CFace>							m_face_pool;
+  /*! arena of the halfedges */
+  CMArena<CHalfEdge>						m_halfedge_pool;
+
+  /*! trait columns of the vertices */
+  CTraitColumns								m_vertex_traits;
+  /*! trait columns of the edges */
+  CTraitColumns								m_edge_traits;
+  /*! trait columns of the faces */
+  CTraitColumns								m_face_traits;
+  /*! trait columns of the halfedges */
+  CTraitColumns								m_halfedge_traits;
+
+  /*! allocate a vertex, recycled if a vertex has been deleted */
+  tVertex   _new_vertex()					{ tVertex v = m_vertex_pool.allocate(); v->slot() = m_vertex_traits.acquire(); return v; };
+  /*! allocate an edge, recycled if an edge has been deleted */
+  tEdge     _new_edge()						{ tEdge e = m_edge_pool.allocate(); e->slot() = m_edge_traits.acquire(); return e; };
+  /*! allocate a face, recycled if a face has been deleted */
+  tFace     _new_face()						{ tFace f = m_face_pool.allocate(); f->slot() = m_face_traits.acquire(); return f; };
+  /*! allocate a halfedge, recycled if a halfedge has been deleted */
+  tHalfEdge _new_halfedge()					{ tHalfEdge h = m_halfedge_pool.allocate(); h->slot() = m_halfedge_traits.acquire(); return h; };
+  /*! delete a vertex, its memory goes to the free list */
+  void      _delete_vertex( tVertex v )		{ m_vertex_traits.release( v->slot() ); m_vertex_pool.delocate( v ); };
+  /*! delete an edge, its memory goes to the free list */
+  void      _delete_edge( tEdge e )			{ m_edge_traits.release( e->slot() ); m_edge_pool.delocate( e ); };
+  /*! delete a face, its memory goes to the free list */
+  void      _delete_face( tFace f )			{ m_face_traits.release( f->slot() ); m_face_pool.delocate( f ); };
+  /*! delete a halfedge, its memory goes to the free list */
+  void      _delete_halfedge( tHalfEdge h )	{ m_halfedge_traits.release( h->slot() ); m_halfedge_pool.delocate( h ); };
+
+  /*! set the trait string of an element, the tokens of the trait columns go to the columns,
+   *  the other ones are dropped unless m_trait_strings is set */
+  template<typename E>
+  void _read_string( CTraitColumns & traits, E * e, const strutil::StrRef & str )
+  {
+	  e->string().clear();
+	  if( traits.empty() )
+	  {
+		  if( m_trait_strings ) e->string().assign( str.begin(), str.end() );
+	  }
+	  else traits.read( e->slot(), str, m_trait_strings ? &e->string() : NULL );
+  };
+  /*!
+  Append the traits of an element, the tokens of its trait string which have no column and
+  then the tokens of its trait columns.
+  \param braces enclose the traits in " {" and "}"
+  \return false if the element has no trait, nothing is appended
+  */
+  template<typename E>
+  bool _write_string( CTraitColumns & traits, E * e, CTextBuffer & out, bool braces )
+  {
+	  size_t size = out.size();
+	  if( braces ) out << " {";
+	  bool written = traits.writeString( e->string(), out );
+
+	  size_t mark = out.size();
+	  if( written ) out << ' ';
+	  if( traits.write( e->slot(), out ) ) written = true;
+	  else out.resize( mark );
+
+	  if( !written )
+	  {
+		  out.resize( size );
+		  return false;
+	  }
+	  if( braces ) out << '}';
+	  return true;
+  };
+
+  /*! renumber the slots of the elements of a kind in [0,n), in the order of the old slots */
+  template<typename C>
+  void _compact_slots( CTraitColumns & traits, C & elements, std::vector<int> & remap );
+
+  /*! release the edge table after loading, unless m_keep_edge_table is set */
+  void _finish_loading();
+  /*! rebuild the id index and the edge table after the vertex ids are changed */
+  void _rebuild_id_tables();
+
+  /*!
+  *	\brief state of a loader while the records are applied in the file order
+  *
+  *	A serial loader creates each face at once. A parallel loader only creates the face
+  *	objects and collects their vertices, the halfedges are built for all the faces at the
+  *	end; the Edge and Corner traits wait for that.
+  */
+  struct CLoadState
+  {
+	  CLoadState( bool defer ) : defer( defer ), vid( 1 ), fid( 1 ), with_uv( false ), with_normal( false ), start( 1, 0 ) {};
+
+	  /*! whether the halfedges are built at the end */
+	  bool                    defer;
+	  /*! next .obj vertex id and face id */
+	  int                     vid, fid;
+	  /*! whether the .obj file has uvs and normals */
+	  bool                    with_uv, with_normal;
+	  /*! .obj uvs and normals */
+	  std::vector<CPoint2>    uvs;
+	  std::vector<CPoint>     normals;
+	  /*! vertices of the current face */
+	  std::vector<tVertex>    fv;
+	  /*! faces waiting for their halfedges */
+	  std::vector<tFace>      faces;
+	  /*! vertices of faces[k] are verts[start[k]] ... verts[start[k+1]-1] */
+	  std::vector<size_t>     start;
+	  std::vector<tVertex>    verts;
+	  /*! Edge records waiting for the edges, their end vertices and the number of faces before them */
+	  std::vector<CMRecord*>  edges;
+	  std::vector<tVertex>    edge_verts;
+	  std::vector<size_t>     edge_time;
+	  /*! Corner records waiting for the halfedges, their vertices and faces */
+	  std::vector<CMRecord*>  corners;
+	  std::vector<tVertex>    corner_verts;
+	  std::vector<tFace>      corner_faces;
+  };
+
+  /*! apply one record of an .m file */
+  void _apply_m_record( CMRecord & r, std::vector<int> & ids, CLoadState & state );
+  /*! apply one record of an .obj file */
+  void _apply_obj_record( CObjRecord & r, CLoadState & state );
+  /*! weld the vertices of the .obj records, the faces are moved to the welded vertices */
+  void _weld_obj_records( std::vector< std::vector<CObjRecord> > & records, int threads );
+  /*! create a face object, its halfedges are built later by _create_faces */
+  tFace _defer_face( std::vector<tVertex> & v, int id, CLoadState & state );
+  /*! parse the lines of a mapped file on several threads */
+  template<typename CRecord>
+  void _parse_records( CMappedFile & file, int threads, std::vector< std::vector<CRecord> > & records, std::vector< std::vector<int> > & ids );
+  /*! build the halfedges and edges of the deferred faces, then apply the waiting traits */
+  void _finish_deferred( CLoadState & state, bool report, int threads );
+  /*! build the halfedges and edges of faces created without connectivity, same result as createFace */
+  void _create_faces( std::vector<tFace> & faces, std::vector<size_t> & start, std::vector<tVertex> & verts, bool report, std::vector<size_t> & edge_first, int threads );
+  /*! orient the edges from the smaller vertex id and label the boundary vertices */
+  void _label_boundary_edges( int threads );
+  /*! read the traits of all the elements from their strings */
+  void _read_traits( int threads );
+  /*! write the traits of all the elements to their strings */
+  void _write_traits( int threads );
+  /*! label the boundary, remove the dangling vertices and read the traits, the end of read_m and read_mb */
+  void _finish_m( int threads );
 
 
 public:
@@ -453,15 +623,70 @@ public:
 	\param pFace the face to be deleted
 	*/
 	void      deleteFace( tFace  pFace );
-	
+
+	/*!
+	*	\brief CSlotRemap, the new slot of every old slot after a compaction, -1 for a deleted element
+	*/
+	struct CSlotRemap
+	{
+		/*! vertex slots */
+		std::vector<int> vertex;
+		/*! edge slots */
+		std::vector<int> edge;
+		/*! face slots */
+		std::vector<int> face;
+		/*! halfedge slots */
+		std::vector<int> halfedge;
+	};
+	/*! delete a batch of faces, with the edges and the vertices left without a face, in one
+	linear pass; then the slots of all the elements are compacted, see Mesh/TraitColumns.h
+	\param faces the faces to be deleted
+	\return the new slots, to move the data indexed by the slots
+	*/
+	CSlotRemap deleteFaces( const std::vector<tFace> & faces );
+
 	/*! whether the vertex is with texture coordinates */
 	bool      m_with_texture;
 	/*! whether the mesh is with normal */
 	bool      m_with_normal;
+	/*! load option, keep the edge hash table after read_m/read_obj/read_off for fast vertexEdge queries, set by CDynamicMesh */
+	bool      m_keep_edge_table;
+	/*! load option, number of threads used by read_m/read_obj, 1 loads serially, 0 uses all the cores.
+	 *  The mesh is the same for any number of threads. */
+	int       m_load_threads;
+	/*! load option, read_obj/read_off weld the vertices closer than this distance, see Spatial/Weld.h.
+	 *  0 welds the equal vertices only, negative keeps every vertex of the file. The faces made
+	 *  degenerate by the welding are dropped, the vertices welded away are removed. */
+	double    m_weld_epsilon;
+	/*! save option, number of threads used by write_m/write_mb/write_obj/write_off/write_g, 1 writes
+	 *  serially, 0 uses all the cores. The file is the same for any number of threads. */
+	int       m_write_threads;
+	/*! load and save option, run the _from_string/_to_string hooks of the elements on the load/save
+	 *  threads, and CVertex::_mix on the subdivide threads. Off by default, the hooks are called
+	 *  serially; set it only if the hooks of the element classes are thread safe, i.e. each one
+	 *  touches only its own element. */
+	bool      m_parallel_traits;
+	/*! load and save option, keep the trait tokens without a trait column in the trait strings of
+	 *  the elements and run the _from_string/_to_string hooks. Without it the traits are the trait
+	 *  columns only: the other tokens are dropped on loading, the hooks are not called and the
+	 *  trait strings stay empty. */
+	bool      m_trait_strings;
 
 	/*! label boundary vertices, edges, faces */
 	void labelBoundary( void );
 
+	/*! trait columns of the vertices, see Mesh/TraitColumns.h */
+	CTraitColumns & vertexTraits()   { return m_vertex_traits; };
+	/*! trait columns of the edges */
+	CTraitColumns & edgeTraits()     { return m_edge_traits; };
+	/*! trait columns of the faces */
+	CTraitColumns & faceTraits()     { return m_face_traits; };
+	/*! trait columns of the halfedges */
+	CTraitColumns & halfedgeTraits() { return m_halfedge_traits; };
+	/*! move the tokens of the trait columns from the trait strings into the columns,
+	 *  for the columns registered after the mesh has been loaded */
+	void readTraitColumns();
+
  public:
 	 /*!
 	  *   the input traits of the mesh, there are 64 bits in total
@@ -855,12 +1080,14 @@ inline CHalfEdge * CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::faceMostClwHalfEdge
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::~CBaseMesh()
 {
+	//destruct the elements, the arenas release the memory chunk by chunk afterwards
+
 	//remove vertices
 
   for( std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter ++ )
   {
       CVertex * pV = *viter;
-      delete pV;
+      m_vertex_pool.destruct( pV );
   }
   m_verts.clear();
 
@@ -870,22 +1097,15 @@ CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::~CBaseMesh()
   {
       CFace * pF = *fiter;
 
-      tHalfEdge he = faceHalfedge( pF );
- 
-      std::list<CHalfEdge*> hes;
+      tHalfEdge start = faceHalfedge( pF );
+      tHalfEdge he = start;
       do{
-        he = halfedgeNext( he );
-        hes.push_back( he );
-      }while( he != pF->halfedge() );
-
-      for( std::list<CHalfEdge*>::iterator hiter = hes.begin(); hiter != hes.end(); hiter ++)
-      {
-          CHalfEdge * pH = *hiter;
-          delete pH;
-      }
-      hes.clear();
-
-      delete pF;
+        tHalfEdge next = halfedgeNext( he );
+        m_halfedge_pool.destruct( he );
+        he = next;
+      }while( he != start );
+
+      m_face_pool.destruct( pF );
   }
   m_faces.clear();
 	
@@ -893,7 +1113,7 @@ CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::~CBaseMesh()
   for( std::list<CEdge*>::iterator eiter = m_edges.begin(); eiter != m_edges.end(); eiter ++ )
   {
       CEdge * pE = *eiter;
-      delete pE;
+      m_edge_pool.destruct( pE );
   }
 
   m_edges.clear();
@@ -926,11 +1146,11 @@ double CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::edgeLength( tEdge  e )
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 CVertex * CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::createVertex( int id )
 {
-	CVertex * v = new CVertex();
+	CVertex * v = _new_vertex();
 	assert( v != NULL );
 	v->id() = id;
 	m_verts.push_back( v );
-	m_map_vert.insert( std::pair<int,CVertex*>(id,v));
+	m_map_vert.insert( id, v );
 	return v;
 };
 
@@ -938,121 +1158,54 @@ CVertex * CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::createVertex( int id )
 /*!
 Read an .obj file.
 \param filename the filename .obj file name
+
+With m_load_threads other than 1 the lines are parsed in parallel, the vertex and face
+ids are given in the file order and the halfedges are built in parallel.
+With m_weld_epsilon >= 0 all the lines are parsed first, and the faces are moved to the
+welded vertices before their halfedges are built.
 */
 
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::read_obj( const char * filename )
 {
+	CMappedFile file;
+	if( !file.open( filename ) ) return;
 
-	std::fstream f(filename, std::fstream::in);
-	if( f.fail() ) return;
-
-	char cmd[1024];
-
-	int  vid = 1;
-	int  fid = 1;
-	
-	bool with_uv = false;
-	bool with_normal = false;
-
-	std::vector<CPoint2> uvs;
-	std::vector<CPoint> normals;
-
-
-	while ( f.getline( cmd, 1024) )
-    {
-		std::string line( cmd );
-		line = strutil::trim( line );
-
-		strutil::Tokenizer stokenizer( line, " \t\r\n" );
-
-		stokenizer.nextToken();
-		std::string token = stokenizer.getToken();
-		
-		if( token == "v" )
-		{
-			CPoint p;
-			for( int i = 0; i < 3; i ++ )
-			{
-				stokenizer.nextToken();
-				token = stokenizer.getToken();
-				p[i] = strutil::parseString<float>(token);
-			}
-			
-			CVertex * v = createVertex( vid);
-			v->point() = p;
-			vid ++;
-			continue;
-		}
-
-
-		if( token == "vt" )
-		{
-			with_uv = true;
-			CPoint2 uv;
-			for( int i = 0; i < 2; i ++ )
-			{
-				stokenizer.nextToken();
-				token = stokenizer.getToken();
-				uv[i] = strutil::parseString<float>(token);
-			}
-			uvs.push_back( uv );
-			continue;
-		}
-
+	int threads = parallelThreads( m_load_threads );
+	//the parallel build assumes an empty mesh
+	bool parallel = threads > 1 && m_verts.empty() && m_faces.empty();
+	if( parallel || m_weld_epsilon >= 0 )
+	{
+		std::vector< std::vector<CObjRecord> > records;
+		std::vector< std::vector<int> >        ids;
+		_parse_records( file, threads, records, ids );
+		if( m_weld_epsilon >= 0 ) _weld_obj_records( records, threads );
 
-		if ( token ==  "vn" )
+		CLoadState state( parallel );
+		for( size_t t = 0; t < records.size(); t ++ )
 		{
-			with_normal = true;
-
-			CPoint n;
-			for( int i = 0; i < 3; i ++ )
-			{
-				stokenizer.nextToken();
-				token = stokenizer.getToken();
-				n[i] = strutil::parseString<float>(token);
-			}
-			normals.push_back( n );
-			continue;
+			for( size_t i = 0; i < records[t].size(); i ++ ) _apply_obj_record( records[t][i], state );
 		}
+		if( parallel ) _finish_deferred( state, false, threads );
+	}
+	else
+	{
+		CLoadState state( false );
+		CObjRecord r;
 
-
-
-
-		if ( token == "f" )
+		const char * pos = file.begin();
+		while( pos < file.end() )
 		{
-			CVertex* v[3];
-			for( int i = 0 ; i < 3; i ++ )
-			{
-				stokenizer.nextToken();
-				token = stokenizer.getToken();
-				
-				
-				strutil::Tokenizer tokenizer( token, " /\t\r\n" );
-				
-				int ids[3];
-				int k = 0;
-				while( tokenizer.nextToken() )
-				{
-					std::string token = tokenizer.getToken();
-					ids[k] = strutil::parseString<int>(token);
-					k ++;
-				}
-
-				
-				v[i] = m_map_vert[ ids[0] ];
-				if( with_uv )
-					v[i]->uv() = uvs[ ids[1]-1 ];
-				if( with_normal )
-					v[i]->normal() = normals[ ids[2]-1 ];
-			}
-			createFace( v, fid++ );
+			strutil::StrRef line;
+			pos = strutil::getLine( pos, file.end(), line );
+			if( r.parse( strutil::trim( line ) ) ) _apply_obj_record( r, state );
 		}
 	}
 
-	f.close();
+	file.close();
 
 	labelBoundary();
+	_finish_loading();
 }
 
 /*! Create a face
@@ -1064,18 +1217,18 @@ void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::read_obj( const char * filename )
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 CFace * CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::createFace( tVertex  v[] , int id )
 {
-	  CFace * f = new CFace();
+	  CFace * f = _new_face();
 	  assert( f != NULL );
 	  f->id() = id;
 	  m_faces.push_back( f );
-	  m_map_face.insert( std::pair<int,tFace>(id,f) );
+	  m_map_face.insert( id, f );
 
 		//create halfedges
 		tHalfEdge hes[3];
 
 		for(int i = 0; i < 3; i ++ )
 		{
-			hes[i] = new CHalfEdge;
+			hes[i] = _new_halfedge();
 			assert( hes[i] );
 			CVertex * vert =  v[i];
 			hes[i]->vertex() = vert;
@@ -1125,7 +1278,7 @@ Access a vertex by its id
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 CVertex * CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::idVertex( int id ) 
 {
-	return m_map_vert[id];
+	return m_map_vert.find( id );
 };
 
 //access v->id
@@ -1149,7 +1302,7 @@ inline int CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::vertexId( tVertex   v )
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 CFace * CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::idFace( int id )
 {
-	return m_map_face[id];
+	return m_map_face.find( id );
 };
 
 //acess f->id
@@ -1176,28 +1329,40 @@ CEdge * CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::createEdge( tVertex  v1, tVert
 	tVertex pV = ( v1->id()<v2->id())?v1:v2;
 	std::list<CEdge*> & ledges = (std::list<CEdge*> &) pV->edges();
 
-	
-	for( std::list<CEdge*>::iterator te = ledges.begin(); te != ledges.end(); te ++ )
+	if( m_edge_table_active )
 	{
-		CEdge	  * pE = *te;
-		CHalfEdge * pH = (CHalfEdge*) pE->halfedge(0);
-	
-		if( pH->source() == v1 && pH->target() == v2 ) 
-		{
-			return pE;		
-		}
-		if( pH->source() == v2 && pH->target() == v1 )
+		CEdge * pE = m_edge_table.find( v1->id(), v2->id() );
+		if( pE != NULL ) return pE;
+	}
+	else
+	{
+		for( std::list<CEdge*>::iterator te = ledges.begin(); te != ledges.end(); te ++ )
 		{
-			return pE;
+			CEdge	  * pE = *te;
+			CHalfEdge * pH = (CHalfEdge*) pE->halfedge(0);
+		
+			if( pH->source() == v1 && pH->target() == v2 ) 
+			{
+				return pE;		
+			}
+			if( pH->source() == v2 && pH->target() == v1 )
+			{
+				return pE;
+			}
 		}
 	}
 
 	//new edge
-	CEdge * e = new CEdge;
+	CEdge * e = _new_edge();
 	assert( e != NULL );
 	m_edges.push_back( e );
 	e->id() = (int)m_edges.size();
 	ledges.push_back( e );
+	e->position() = -- pV->edges().end();
+	if( m_edge_table_active )
+	{
+		m_edge_table.insert( v1->id(), v2->id(), e );
+	}
 
 
 	return e;
@@ -1218,6 +1383,11 @@ Access an edge by its two end vertices
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 inline CEdge * CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::vertexEdge( tVertex  v0, tVertex  v1 )
 {
+	if( m_edge_table_active )
+	{
+		return m_edge_table.find( v0->id(), v1->id() );
+	}
+
 	CVertex * pV = (v0->id() < v1->id() )? v0: v1;
 	std::list<CEdge*> & ledges = vertexEdges( pV );
 
@@ -1280,226 +1450,258 @@ inline CHalfEdge * CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::vertexHalfedge( tVe
 /*!
 	Read an .m file.
 	\param input the input obj file name
+
+	The file is memory mapped and the lines are tokenized in place, only the
+	trait strings are copied. With m_load_threads other than 1 the lines are parsed
+	in parallel and the halfedges are built in parallel, the mesh is the same as the
+	serial one.
 	*/
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::read_m( const char * input )
 {
-	std::fstream is( input, std::fstream::in );
+	CMappedFile file;
 
-	if( is.fail() )
+	if( !file.open( input ) )
 	{
 		fprintf(stderr,"Error in opening file %s\n", input );
 		return;
 	}
 
-	char buffer[MAX_LINE];
-	int id;
-
-	while( is.getline(buffer, MAX_LINE )  )
-	{		
-	
-		std::string line( buffer );
-		line = strutil::trim( line );
-
-		strutil::Tokenizer stokenizer( line, " \r\n" );
+	int threads = parallelThreads( m_load_threads );
+	//the parallel build assumes an empty mesh
+	if( threads > 1 && m_verts.empty() && m_faces.empty() )
+	{
+		std::vector< std::vector<CMRecord> > records;
+		std::vector< std::vector<int> >      ids;
+		_parse_records( file, threads, records, ids );
 
-		stokenizer.nextToken();
-		std::string token = stokenizer.getToken();
-	
-		if( token == "Vertex"  ) 
+		CLoadState state( true );
+		for( size_t t = 0; t < records.size(); t ++ )
 		{
-			stokenizer.nextToken();
-			token = stokenizer.getToken();
-			id = strutil::parseString<int>(token);
-
-			CPoint p;
-			for( int i = 0 ; i < 3; i ++ )
-			{
-				stokenizer.nextToken();
-				token = stokenizer.getToken();
-				p[i] = strutil::parseString<float>(token);
-			}
-		
-			tVertex v  = createVertex( id );
-			v->point() = p;
-			v->id()    = id;
-
-			if( ! stokenizer.nextToken("\t\r\n") ) continue;
-			token = stokenizer.getToken();
-
-			int sp = (int) token.find("{");
-			int ep = (int) token.find("}");
-
-			if( sp >= 0 && ep >= 0 )
-			{
-				v->string() = token.substr( sp+1, ep-sp-1 );
-			}
-			continue;
+			for( size_t i = 0; i < records[t].size(); i ++ ) _apply_m_record( records[t][i], ids[t], state );
 		}
-		
+		_finish_deferred( state, true, threads );
+	}
+	else
+	{
+		CLoadState state( false );
+		CMRecord r;
+		std::vector<int> ids;
 
-		if( token == "Face" ) 
+		const char * pos = file.begin();
+		while( pos < file.end() )
 		{
-
-			stokenizer.nextToken();
-			token = stokenizer.getToken();
-			id = strutil::parseString<int>(token);
+			strutil::StrRef line;
+			pos = strutil::getLine( pos, file.end(), line );
+			ids.clear();
+			if( r.parse( strutil::trim( line ), ids ) ) _apply_m_record( r, ids, state );
+		}
+	}
 	
-			std::vector<CVertex*> v;
+	_finish_m( threads );
 
-			//assume each face is a triangle
-			/*			
-			for( int i = 0;i < 3; i ++ )
-			{
-				stokenizer.nextToken();
-				token = stokenizer.getToken();
-				int vid = strutil::parseString<int>(token);
-				v.push_back( idVertex( vid ) );
-			}
-			*/
+};
 
-			while( stokenizer.nextToken() )
-			{
-				token = stokenizer.getToken();
-				if( strutil::startsWith( token, "{" ) ) break;
-				int vid = strutil::parseString<int>(token);
-				v.push_back( idVertex( vid ) );
-			}
+/*!
+	Write an .m file.
+	\param output the output .m file name
+
+	The coordinates are written with the shortest text which reads back the same
+	double. With m_write_threads other than 1 the traits and the lines are formatted
+	in parallel, the file is the same.
+	*/
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::write_m( const char * output )
+{
+	int threads = parallelThreads( m_write_threads );
 
-			tFace f = createFace( v, id );
+	//write traits to string
+	_write_traits( threads );
 
-			if( ! stokenizer.nextToken("\t\r\n") ) continue;
-			token = stokenizer.getToken();
+	FILE * _os = fopen( output, "w" );
+	if( _os == NULL )
+	{
+		fprintf(stderr,"Error is opening file %s\n", output );
+		return;
+	}
 
-			//stokenizer.reset();
-			token = line;
-			int sp = (int) token.find("{");
-			int ep = (int) token.find("}");
+	std::vector<tVertex> verts( m_verts.begin(), m_verts.end() );
+	std::vector<tEdge>   edges( m_edges.begin(), m_edges.end() );
+	std::vector<tFace>   faces( m_faces.begin(), m_faces.end() );
 
-			if( sp >= 0 && ep >= 0 )
-			{
-				f->string() = token.substr( sp+1, ep-sp-1 );
-			}
-/*
-			if( strutil::startsWith( token, "{" ) )
-			{
+	bool ok = parallelWrite( _os, verts.size(), threads, [&]( size_t i, CTextBuffer & buffer )
+	{
+		tVertex v = verts[i];
 
-				f->string() = strutil::trim( token, "{}" );
-			}
-*/
-			continue;
+		buffer << "Vertex " << v->id();
+		for( int k = 0; k < 3; k ++ )
+		{
+			buffer << ' ' << v->point()[k];
 		}
+		_write_string( m_vertex_traits, v, buffer, true );
+		buffer << '\n';
+	});
 
-		//read in edge attributes
-		if( token == "Edge" )
-		{
-			stokenizer.nextToken();
-			token = stokenizer.getToken();
-			int id0 = strutil::parseString<int>( token );
+	ok = ok && parallelWrite( _os, faces.size(), threads, [&]( size_t i, CTextBuffer & buffer )
+	{
+		tFace f = faces[i];
 
-			stokenizer.nextToken();
-			token = stokenizer.getToken();
-			int id1 = strutil::parseString<int>( token );
+		buffer << "Face " << f->id();
+		tHalfEdge he = faceHalfedge( f );
+		do{
+			buffer << ' ' << he->target()->id();
+			he = halfedgeNext( he );
+		}while( he != f->halfedge() );
 
+		_write_string( m_face_traits, f, buffer, true );
+		buffer << '\n';
+	});
 
-			CVertex * v0 = idVertex( id0 );
-			CVertex * v1 = idVertex( id1 );
+	ok = ok && parallelWrite( _os, edges.size(), threads, [&]( size_t i, CTextBuffer & buffer )
+	{
+		tEdge e = edges[i];
+		size_t size = buffer.size();
+		buffer << "Edge " << edgeVertex1(e)->id() << ' ' << edgeVertex2(e)->id();
+		if( _write_string( m_edge_traits, e, buffer, true ) ) buffer << '\n';
+		else buffer.resize( size );
+	});
+
+	ok = ok && parallelWrite( _os, faces.size(), threads, [&]( size_t i, CTextBuffer & buffer )
+	{
+		tFace f = faces[i];
 
-			tEdge edge = vertexEdge( v0, v1 );
+		tHalfEdge he = faceHalfedge( f );
+		do{
+			size_t size = buffer.size();
+			buffer << "Corner " << he->vertex()->id() << ' ' << f->id();
+			if( _write_string( m_halfedge_traits, he, buffer, true ) ) buffer << '\n';
+			else buffer.resize( size );
+			he = halfedgeNext( he );
+		}while( he != f->halfedge() );
+	});
 
-			if( !stokenizer.nextToken("\t\r\n") ) continue;
-			token = stokenizer.getToken();	
-			
-			int sp = (int) token.find("{");
-			int ep = (int) token.find("}");
+	if( fclose( _os ) != 0 || !ok )
+	{
+		fprintf(stderr,"Error in writing file %s\n", output );
+	}
+};
 
-			if( sp >= 0 && ep >= 0 )
-			{
-				  edge->string() = token.substr( sp+1, ep-sp-1 );
-			}
-			continue;
-		}
 
-		//read in edge attributes
-		if( token == "Corner" ) 
-		{
-			stokenizer.nextToken();
-			token = stokenizer.getToken();
-			int vid = strutil::parseString<int>( token );
+/*!
+	Write the traits of the vertices, edges, faces and halfedges to their strings.
+	The hooks are called serially unless m_parallel_traits is set, and not at all
+	without m_trait_strings.
+	\param threads number of threads
+*/
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::_write_traits( int threads )
+{
+	if( !m_trait_strings ) return;
+	if( !m_parallel_traits ) threads = 1;
 
-			stokenizer.nextToken();
-			token = stokenizer.getToken();
-			int fid = strutil::parseString<int>( token );
+	std::vector<tVertex> verts( m_verts.begin(), m_verts.end() );
+	parallelFor( verts.size(), threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ ) verts[i]->_to_string();
+	});
 
+	std::vector<tEdge> edges( m_edges.begin(), m_edges.end() );
+	parallelFor( edges.size(), threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ ) edges[i]->_to_string();
+	});
 
-			CVertex * v = idVertex( vid );
-			CFace   * f = idFace( fid );
-			tHalfEdge he = corner( v, f );
+	std::vector<tFace> faces( m_faces.begin(), m_faces.end() );
+	parallelFor( faces.size(), threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ ) faces[i]->_to_string();
+	});
 
+	parallelFor( faces.size(), threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ )
+		{
+			CFace * pF = faces[i];
 
-			if( !stokenizer.nextToken("\t\r\n") ) continue;
-			token = stokenizer.getToken();	
+			CHalfEdge * pH  = faceMostCcwHalfEdge( pF );
+			do{
+				pH->_to_string();
+				pH = faceNextCcwHalfEdge( pH );
+			}while( pH != faceMostCcwHalfEdge(pF ) );
+		}
+	});
+};
 
-			int sp = (int) token.find("{");
-			int ep = (int) token.find("}");
+/*!
+	Move the tokens of the trait columns from the trait strings of all the elements
+	into the columns. The loaders already do it for the columns registered before
+	loading, this is for the columns registered afterwards.
+*/
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::readTraitColumns()
+{
+	int threads = parallelThreads( m_load_threads );
 
-			if( sp >= 0 && ep >= 0 )
-			{
-				he->string() = token.substr( sp+1, ep-sp-1 );
-			}
-			continue;
+	std::vector<tVertex> verts( m_verts.begin(), m_verts.end() );
+	parallelFor( verts.size(), threads, [&]( size_t b, size_t e, int )
+	{
+		std::string str;
+		for( size_t i = b; i < e; i ++ )
+		{
+			str.swap( verts[i]->string() );
+			_read_string( m_vertex_traits, verts[i], strutil::StrRef( str.data(), str.data() + str.size() ) );
 		}
-	}
-	
-	//labelBoundary();
+	});
 
-	//Label boundary edges
-	for(std::list<CEdge*>::iterator eiter= m_edges.begin() ; eiter != m_edges.end() ; ++ eiter )
+	std::vector<tEdge> edges( m_edges.begin(), m_edges.end() );
+	parallelFor( edges.size(), threads, [&]( size_t b, size_t e, int )
 	{
-		CEdge *     edge = *eiter;
-		CHalfEdge * he[2];
-
-		he[0] = edgeHalfedge( edge, 0 );
-		he[1] = edgeHalfedge( edge, 1 );
-		
-		assert( he[0] != NULL );
-		
-
-		if( he[1] != NULL )
+		std::string str;
+		for( size_t i = b; i < e; i ++ )
 		{
-			assert( he[0]->target() == he[1]->source() && he[0]->source() == he[1]->target() );
-
-			if( he[0]->target()->id() < he[0]->source()->id() )
-			{
-				edge->halfedge(0 ) = he[1];
-				edge->halfedge(1 ) = he[0];
-			}
-
-			assert( edgeVertex1(edge)->id() < edgeVertex2(edge)->id() );
+			str.swap( edges[i]->string() );
+			_read_string( m_edge_traits, edges[i], strutil::StrRef( str.data(), str.data() + str.size() ) );
 		}
-		else
+	});
+
+	std::vector<tFace> faces( m_faces.begin(), m_faces.end() );
+	parallelFor( faces.size(), threads, [&]( size_t b, size_t e, int )
+	{
+		std::string str;
+		for( size_t i = b; i < e; i ++ )
 		{
-			he[0]->vertex()->boundary() = true;
-			he[0]->he_prev()->vertex()->boundary()  = true;
+			str.swap( faces[i]->string() );
+			_read_string( m_face_traits, faces[i], strutil::StrRef( str.data(), str.data() + str.size() ) );
+
+			CHalfEdge * pH  = faceMostCcwHalfEdge( faces[i] );
+			do{
+				str.swap( pH->string() );
+				_read_string( m_halfedge_traits, pH, strutil::StrRef( str.data(), str.data() + str.size() ) );
+				pH = faceNextCcwHalfEdge( pH );
+			}while( pH != faceMostCcwHalfEdge( faces[i] ) );
 		}
+	});
+};
 
-	}
-
-	std::list<CVertex*> dangling_verts;
+/*!
+	The common end of read_m and read_mb: label the boundary, remove the dangling
+	vertices, arrange the boundary halfedges and read the traits.
+	\param threads number of threads
+*/
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::_finish_m( int threads )
+{
 	//Label boundary edges
-	for(std::list<CVertex*>::iterator viter = m_verts.begin();  viter != m_verts.end() ; ++ viter )
-	{
-		CVertex *     v = *viter;
-		if( v->halfedge() != NULL ) continue;
-		dangling_verts.push_back( v );
-	}
+	_label_boundary_edges( threads );
 
-	for( std::list<CVertex*>::iterator  viter = dangling_verts.begin() ; viter != dangling_verts.end(); ++ viter )
+	//remove the dangling vertices
+	for(std::list<CVertex*>::iterator viter = m_verts.begin();  viter != m_verts.end() ; )
 	{
-		CVertex * v = *viter;
-		m_verts.remove( v );
-		delete v;
-		v = NULL;
+		CVertex *     v = *viter;
+		if( v->halfedge() != NULL ) { ++ viter; continue; }
+		viter = m_verts.erase( viter );
+		m_map_vert.erase( v->id() );
+		_delete_vertex( v );
 	}
 
 	//Arrange the boundary half_edge of boundary vertices, to make its halfedge
@@ -1518,150 +1720,249 @@ void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::read_m( const char * input )
 		v->halfedge() = he;
 	}
 
+	_finish_loading();
+
 	//read in the traits
+	_read_traits( threads );
+};
 
-	for(std::list<CVertex*>::iterator viter = m_verts.begin();  viter != m_verts.end() ; ++ viter )
-	{
-		CVertex *     v = *viter;
-		v->_from_string();
-	}
+/*!
+	Write a binary .mb file. The content is the one of write_m, the coordinates are
+	written exactly; the layout is described in Parser/BinaryFormat.h.
+	\param output the output .mb file name
+	\param uv     whether to write the vertex uv column
+	\param normal whether to write the vertex normal column
+	*/
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::write_mb( const char * output, bool uv, bool normal )
+{
+	int threads = parallelThreads( m_write_threads );
 
-	for(std::list<CEdge*>::iterator eiter = m_edges.begin();  eiter != m_edges.end() ; ++ eiter )
-	{
-		CEdge *     e = *eiter;
-		e->_from_string();
-	}
+	//write traits to string
+	_write_traits( threads );
 
-	for(std::list<CFace*>::iterator fiter = m_faces.begin();  fiter != m_faces.end() ; ++ fiter )
+	std::fstream _os( output, std::fstream::out | std::fstream::binary );
+	if( _os.fail() )
 	{
-		CFace *     f = *fiter;
-		f->_from_string();
+		fprintf(stderr,"Error is opening file %s\n", output );
+		return;
 	}
 
-	for( std::list<CFace*>::iterator fiter=m_faces.begin(); fiter != m_faces.end(); fiter ++ )
-	{
-		CFace * pF = *fiter;
-
-		CHalfEdge * pH  = faceMostCcwHalfEdge( pF );
-		do{
-			pH->_from_string();
-			pH = faceNextCcwHalfEdge( pH );
-		}while( pH != faceMostCcwHalfEdge(pF ) );
-	}
+	CMBHeader header;
+	if( uv )     header.flags |= CMBHeader::UV;
+	if( normal ) header.flags |= CMBHeader::NORMAL;
 
-};
+	std::vector<int>    vids, fids, fverts, everts, cverts, cfaces;
+	std::vector<double> points, uvs, normals;
+	std::vector<unsigned long long> fstart( 1, 0 ), sstart( 1, 0 );
+	CTextBuffer pool;
 
-/*!
-	Write an .m file.
-	\param output the output .m file name
-	*/template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
-void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::write_m( const char * output )
-{
-	//write traits to string
-	for( std::list<CVertex*>::iterator viter=m_verts.begin(); viter != m_verts.end(); viter ++ )
+	for( std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter ++ )
 	{
-		CVertex * pV = *viter;
-		pV->_to_string();
+		tVertex v = *viter;
+		vids.push_back( v->id() );
+		for( int i = 0; i < 3; i ++ ) points.push_back( v->point()[i] );
+		if( uv )     for( int i = 0; i < 2; i ++ ) uvs.push_back( v->uv()[i] );
+		if( normal ) for( int i = 0; i < 3; i ++ ) normals.push_back( v->normal()[i] );
+		_write_string( m_vertex_traits, v, pool, false );
+		sstart.push_back( pool.size() );
 	}
 
-	for( std::list<CEdge*>::iterator eiter=m_edges.begin(); eiter != m_edges.end(); eiter ++ )
+	for( std::list<CFace*>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter ++ )
 	{
-		CEdge * pE = *eiter;
-		pE->_to_string();
+		tFace f = *fiter;
+		fids.push_back( f->id() );
+		//start after f->halfedge(), so that read_mb rebuilds the same halfedge of the face
+		tHalfEdge he = faceHalfedge( f );
+		do{
+			he = halfedgeNext( he );
+			fverts.push_back( he->target()->id() );
+		}while( he != f->halfedge() );
+		fstart.push_back( fverts.size() );
+		_write_string( m_face_traits, f, pool, false );
+		sstart.push_back( pool.size() );
 	}
 
-	for( std::list<CFace*>::iterator fiter=m_faces.begin(); fiter != m_faces.end(); fiter ++ )
+	for( std::list<CEdge*>::iterator eiter = m_edges.begin(); eiter != m_edges.end(); eiter ++ )
 	{
-		CFace * pF = *fiter;
-		pF->_to_string();
+		tEdge e = *eiter;
+		if( !_write_string( m_edge_traits, e, pool, false ) ) continue;
+		everts.push_back( edgeVertex1(e)->id() );
+		everts.push_back( edgeVertex2(e)->id() );
+		sstart.push_back( pool.size() );
 	}
 
-	for( std::list<CFace*>::iterator fiter=m_faces.begin(); fiter != m_faces.end(); fiter ++ )
+	for( std::list<CFace*>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter ++ )
 	{
-		CFace * pF = *fiter;
-		CHalfEdge * pH  = faceMostCcwHalfEdge( pF );
+		tFace f = *fiter;
+		tHalfEdge he = faceHalfedge( f );
 		do{
-			pH->_to_string();
-			pH = faceNextCcwHalfEdge( pH );
-		}while( pH != faceMostCcwHalfEdge(pF ) );
+			if( _write_string( m_halfedge_traits, he, pool, false ) )
+			{
+				cverts.push_back( he->vertex()->id() );
+				cfaces.push_back( f->id() );
+				sstart.push_back( pool.size() );
+			}
+			he = halfedgeNext( he );
+		}while( he != f->halfedge() );
 	}
 
+	header.nv     = vids.size();
+	header.nf     = fids.size();
+	header.nc     = fverts.size();
+	header.ne     = everts.size() / 2;
+	header.nh     = cverts.size();
+	header.nbytes = pool.size();
 
-	std::fstream _os( output, std::fstream::out );
-	if( _os.fail() )
+	unsigned long long offset[CMBHeader::END+1];
+	header.layout( offset );
+
+	const void * data[CMBHeader::END] = {
+		vids.data(), points.data(), uvs.data(), normals.data(), fids.data(), fstart.data(), fverts.data(),
+		everts.data(), cverts.data(), cfaces.data(), sstart.data(), pool.str().data() };
+
+	_os.write( (const char*) &header, sizeof( CMBHeader ) );
+	unsigned long long pos = sizeof( CMBHeader );
+	for( int i = 0; i < CMBHeader::END; i ++ )
 	{
-		fprintf(stderr,"Error is opening file %s\n", output );
+		//zero padding up to the 8 byte boundary
+		while( pos < offset[i] ) { _os.put( 0 ); pos ++; }
+		size_t bytes = (size_t) header.size( i );
+		_os.write( (const char*) data[i], bytes );
+		pos += bytes;
+	}
+
+	_os.close();
+};
+
+/*!
+	Read a binary .mb file, written by write_mb. The file is memory mapped and checked
+	before the mesh is touched; the faces are built as in read_m.
+	\param input the input .mb file name
+	*/
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::read_mb( const char * input )
+{
+	CMappedFile file;
+
+	if( !file.open( input ) )
+	{
+		fprintf(stderr,"Error in opening file %s\n", input );
 		return;
 	}
 
+	CMBHeader header;
+	unsigned long long offset[CMBHeader::END+1];
+	unsigned long long size = file.size();
+	bool valid = size >= sizeof( CMBHeader );
 
-	//remove vertices
-  for( std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter ++)
-  {
-		tVertex v = *viter;
+	if( valid )
+	{
+		memcpy( &header, file.begin(), sizeof( CMBHeader ) );
+		//every count is bounded by the file size, so the layout does not overflow
+		valid = header.valid() && header.nv <= size && header.nf <= size && header.nc <= size
+			&& header.ne <= size && header.nh <= size && header.nbytes <= size;
+	}
+	if( valid )
+	{
+		header.layout( offset );
+		valid = offset[CMBHeader::END] <= size;
+	}
 
-		_os << "Vertex " << v->id();
-		
-		for( int i = 0; i < 3; i ++ )
-		{
-			_os << " " << v->point()[i];
-		}
-		if( v->string().size() > 0 )
-		{
-			_os << " " <<"{"<< v->string() << "}";
-		}
-		_os << std::endl;
+	const char * base = file.begin();
+	const unsigned long long * fstart = (const unsigned long long*)( base + ( valid ? offset[CMBHeader::F_START] : 0 ) );
+	const unsigned long long * sstart = (const unsigned long long*)( base + ( valid ? offset[CMBHeader::S_START] : 0 ) );
+	unsigned long long nstrings = header.nv + header.nf + header.ne + header.nh;
+
+	if( valid )
+	{
+		valid = fstart[0] == 0 && fstart[header.nf] == header.nc && sstart[0] == 0 && sstart[nstrings] == header.nbytes;
+		for( unsigned long long i = 0; valid && i < header.nf; i ++ ) valid = fstart[i] <= fstart[i+1];
+		for( unsigned long long i = 0; valid && i < nstrings; i ++ )  valid = sstart[i] <= sstart[i+1];
+	}
+	if( !valid )
+	{
+		fprintf(stderr,"Error: %s is not a valid .mb file\n", input );
+		return;
 	}
 
-  for( std::list<CFace*>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter ++ )
+	const int    * vids    = (const int*)   ( base + offset[CMBHeader::V_ID] );
+	const double * points  = (const double*)( base + offset[CMBHeader::V_POINT] );
+	const double * uvs     = (const double*)( base + offset[CMBHeader::V_UV] );
+	const double * normals = (const double*)( base + offset[CMBHeader::V_NORMAL] );
+	const int    * fids    = (const int*)   ( base + offset[CMBHeader::F_ID] );
+	const int    * fverts  = (const int*)   ( base + offset[CMBHeader::F_VERT] );
+	const int    * everts  = (const int*)   ( base + offset[CMBHeader::E_VERT] );
+	const int    * cverts  = (const int*)   ( base + offset[CMBHeader::C_VERT] );
+	const int    * cfaces  = (const int*)   ( base + offset[CMBHeader::C_FACE] );
+	const char   * pool    = base + offset[CMBHeader::S_POOL];
+	size_t s = 0;
+	//the deferred build assumes an empty mesh, checked before the vertices of the file are added
+	bool empty = m_verts.empty() && m_faces.empty();
+
+	for( size_t i = 0; i < header.nv; i ++, s ++ )
 	{
-		tFace f = *fiter;
+		tVertex v  = createVertex( vids[i] );
+		v->point() = CPoint( points[3*i], points[3*i+1], points[3*i+2] );
+		if( header.flags & CMBHeader::UV )     v->uv()     = CPoint2( uvs[2*i], uvs[2*i+1] );
+		if( header.flags & CMBHeader::NORMAL ) v->normal() = CPoint( normals[3*i], normals[3*i+1], normals[3*i+2] );
+		_read_string( m_vertex_traits, v, strutil::StrRef( pool + sstart[s], pool + sstart[s+1] ) );
+	}
 
-		_os << "Face " << f->id();
-		tHalfEdge he = faceHalfedge( f );
-		do{
-			_os << " " <<  he->target()->id();
-			he = halfedgeNext( he );
-		}while( he != f->halfedge() );
+	int threads = parallelThreads( m_load_threads );
+	CLoadState state( empty );
+	std::vector<tVertex> & v = state.fv;
+
+	for( size_t i = 0; i < header.nf; i ++, s ++ )
+	{
+		bool missing = false;
 
-		if( f->string().size() > 0 )
+		v.clear();
+		for( unsigned long long k = fstart[i]; k < fstart[i+1]; k ++ )
 		{
-			_os << " " << "{"<< f->string() << "}";
+			CVertex * pV = idVertex( fverts[k] );
+			if( pV == NULL )
+			{
+				fprintf(stderr,"Error: face %d refers to a missing vertex %d\n", fids[i], fverts[k] );
+				missing = true;
+			}
+			v.push_back( pV );
 		}
-		_os << std::endl;
+		if( missing ) continue;
+
+		tFace f = state.defer ? _defer_face( v, fids[i], state ) : createFace( v, fids[i] );
+		_read_string( m_face_traits, f, strutil::StrRef( pool + sstart[s], pool + sstart[s+1] ) );
 	}
 
-  for( std::list<CEdge*>::iterator eiter = m_edges.begin(); eiter != m_edges.end(); eiter ++ )
+	if( state.defer )
 	{
-		tEdge e = *eiter;
-		if( e->string().size() > 0 )
-		{
-			_os << "Edge "<<  edgeVertex1(e)->id() <<" " << edgeVertex2(e)->id() << " ";
-			_os << "{" << e->string() << "}" << std::endl;
-		}
+		std::vector<size_t> edge_first;
+		_create_faces( state.faces, state.start, state.verts, true, edge_first, threads );
 	}
 
-  for( std::list<CFace*>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter ++  )
+	for( size_t i = 0; i < header.ne; i ++, s ++ )
 	{
-		tFace f = *fiter;
+		CVertex * v0 = idVertex( everts[2*i] );
+		CVertex * v1 = idVertex( everts[2*i+1] );
+		if( v0 == NULL || v1 == NULL ) continue;
 
-		tHalfEdge he = faceHalfedge( f );
+		tEdge edge = vertexEdge( v0, v1 );
+		if( edge != NULL ) _read_string( m_edge_traits, edge, strutil::StrRef( pool + sstart[s], pool + sstart[s+1] ) );
+	}
 
-    do{
-  			if( he->string().size() > 0 )
-			  {
-				  _os << "Corner "<< he->vertex()->id() << " " << f->id() << " ";
-				  _os << "{" << he->string() << "}" << std::endl;
-			  }
-			  he = halfedgeNext( he );
-		}while( he != f->halfedge() );
+	for( size_t i = 0; i < header.nh; i ++, s ++ )
+	{
+		CVertex * pV = idVertex( cverts[i] );
+		CFace   * pF = idFace( cfaces[i] );
+		if( pV == NULL || pF == NULL ) continue;
 
-  }
+		tHalfEdge he = corner( pV, pF );
+		if( he != NULL ) _read_string( m_halfedge_traits, he, strutil::StrRef( pool + sstart[s], pool + sstart[s+1] ) );
+	}
 
-	_os.close();
+	_finish_m( threads );
 };
 
-
 //assume the mesh is with uv coordinates and normal vector for each vertex
 /*!
 	Write an .obj file.
@@ -1670,8 +1971,8 @@ void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::write_m( const char * output )
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::write_obj( const char * output )
 {
-	std::fstream _os( output, std::fstream::out );
-	if( _os.fail() )
+	FILE * _os = fopen( output, "w" );
+	if( _os == NULL )
 	{
 		fprintf(stderr,"Error is opening file %s\n", output );
 		return;
@@ -1683,64 +1984,49 @@ void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::write_obj( const char * output )
 		tVertex v = *viter;
 		v->id() = vid ++;
 	}
+	_rebuild_id_tables();
 
-	for( std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter ++)
-	{
-		tVertex v = *viter;
-
-		_os << "v";
-		
-		for( int i = 0; i < 3; i ++ )
-		{
-			_os << " " << v->point()[i];
-		}
-		_os << std::endl;
-	}
+	int threads = parallelThreads( m_write_threads );
+	std::vector<tVertex> verts( m_verts.begin(), m_verts.end() );
+	std::vector<tFace>   faces( m_faces.begin(), m_faces.end() );
 
-	for( std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter ++)
+	bool ok = parallelWrite( _os, verts.size(), threads, [&]( size_t i, CTextBuffer & buffer )
 	{
-		tVertex v = *viter;
-
-		_os << "vt";
-		
-		for( int i = 0; i < 2; i ++ )
-		{
-			_os << " " << v->uv()[i];
-		}
-		_os << std::endl;
-	}
+		CPoint & p = verts[i]->point();
+		buffer << 'v' << ' ' << p[0] << ' ' << p[1] << ' ' << p[2] << '\n';
+	});
 
-	for( std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter ++)
+	ok = ok && parallelWrite( _os, verts.size(), threads, [&]( size_t i, CTextBuffer & buffer )
 	{
-		tVertex v = *viter;
-
-		_os << "vn";
-		
-		for( int i = 0; i < 3; i ++ )
-		{
-			_os << " " << v->normal()[i];
-		}
-		_os << std::endl;
-	}
+		CPoint2 & uv = verts[i]->uv();
+		buffer << "vt " << uv[0] << ' ' << uv[1] << '\n';
+	});
 
+	ok = ok && parallelWrite( _os, verts.size(), threads, [&]( size_t i, CTextBuffer & buffer )
+	{
+		CPoint & n = verts[i]->normal();
+		buffer << "vn " << n[0] << ' ' << n[1] << ' ' << n[2] << '\n';
+	});
 
-  for( std::list<CFace*>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter ++ )
+	ok = ok && parallelWrite( _os, faces.size(), threads, [&]( size_t i, CTextBuffer & buffer )
 	{
-		tFace f = *fiter;
+		tFace f = faces[i];
 
-		_os << "f";
+		buffer << 'f';
 
 		tHalfEdge he = faceHalfedge( f );
-		
 		do{
 			int vid = he->target()->id();
-			_os << " " <<  vid << "/" << vid << "/" << vid;
+			buffer << ' ' << vid << '/' << vid << '/' << vid;
 			he = halfedgeNext( he );
 		}while( he != f->halfedge() );
-		_os << std::endl;
-	}
+		buffer << '\n';
+	});
 
-	_os.close();
+	if( fclose( _os ) != 0 || !ok )
+	{
+		fprintf(stderr,"Error in writing file %s\n", output );
+	}
 };
 
 /*!
@@ -1750,16 +2036,17 @@ void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::write_obj( const char * output )
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::write_off( const char * output )
 {
-	std::fstream _os( output, std::fstream::out );
-	if( _os.fail() )
+	FILE * _os = fopen( output, "w" );
+	if( _os == NULL )
 	{
 		fprintf(stderr,"Error is opening file %s\n", output );
 		return;
 	}
 
-	_os << "OFF" << std::endl;
-	_os << m_verts.size() << " " << m_faces.size() << " " << m_edges.size() << std::endl;
-
+	CTextBuffer header;
+	header << "OFF\n";
+	header << (unsigned long long) m_verts.size() << ' ' << (unsigned long long) m_faces.size() << ' ' << (unsigned long long) m_edges.size() << '\n';
+	bool ok = header.write( _os );
 
 	int vid = 0;
 	for( std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter ++)
@@ -1767,32 +2054,36 @@ void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::write_off( const char * output )
 		tVertex v = *viter;
 		v->id() = vid ++;
 	}
+	_rebuild_id_tables();
 
-	for( std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter ++)
-	{
-		tVertex v = *viter;
-		_os << v->point()[0]  << " " << v->point()[1] << " " << v->point()[2]<< std::endl;
-		//_os << v->normal()[0] << " " << v->normal()[1]<< " " << v->normal()[2]<< std::endl;
-	}
+	int threads = parallelThreads( m_write_threads );
+	std::vector<tVertex> verts( m_verts.begin(), m_verts.end() );
+	std::vector<tFace>   faces( m_faces.begin(), m_faces.end() );
 
+	ok = ok && parallelWrite( _os, verts.size(), threads, [&]( size_t i, CTextBuffer & buffer )
+	{
+		CPoint & p = verts[i]->point();
+		buffer << p[0] << ' ' << p[1] << ' ' << p[2] << '\n';
+	});
 
-	for( std::list<CFace*>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter ++ )
+	ok = ok && parallelWrite( _os, faces.size(), threads, [&]( size_t i, CTextBuffer & buffer )
 	{
-		tFace f = *fiter;
+		tFace f = faces[i];
 
-		_os << "3";
+		buffer << '3';
 
 		tHalfEdge he = faceHalfedge( f );
-		
 		do{
-			int vid = he->target()->id();
-			_os << " " <<  vid;
+			buffer << ' ' << he->target()->id();
 			he = halfedgeNext( he );
 		}while( he != f->halfedge() );
-		_os << std::endl;
-	}
+		buffer << '\n';
+	});
 
-	_os.close();
+	if( fclose( _os ) != 0 || !ok )
+	{
+		fprintf(stderr,"Error in writing file %s\n", output );
+	}
 };
 
 
@@ -1805,11 +2096,7 @@ void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::write_off( const char * output )
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::deleteFace( tFace  pFace )
 {  	  
-	  std::map<int,tFace>::iterator fiter = m_map_face.find( pFace->id() );
-	  if( fiter != m_map_face.end() )
-	  {
-		  m_map_face.erase( fiter );
-	  }	
+	  m_map_face.erase( pFace->id() );
 	  m_faces.remove( pFace );
 
 		
@@ -1855,6 +2142,10 @@ void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::deleteFace( tFace  pFace )
 				m_edges.remove( pE );
 				CVertex * v0 = halfedgeSource( pH );
 				CVertex * v1 = halfedgeTarget( pH );
+				if( m_edge_table_active )
+				{
+					m_edge_table.erase( v0->id(), v1->id() );
+				}
 
 				// modified by Jerome
 				std::list<CEdge*> & ledges0 = (std::list<CEdge*> &) v0->edges();
@@ -1869,7 +2160,7 @@ void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::deleteFace( tFace  pFace )
 					ledges1.remove(pE);
 				}
 
-				delete pE;
+				_delete_edge( pE );
 			}
 
 			
@@ -1878,10 +2169,176 @@ void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::deleteFace( tFace  pFace )
 		//remove half edges
 		for(int i = 0; i < 3; i ++ )
 		{
-			delete hes[i];
+			_delete_halfedge( hes[i] );
 		}
 		
-		delete pFace;
+		_delete_face( pFace );
+};
+
+/*!
+	Delete a batch of faces. The faces, edges, vertices and halfedges to delete are marked
+	by slot, the lists and the id maps are swept once, so the cost is linear in the size
+	of the mesh instead of a list scan per face. An edge is deleted with its last face,
+	a vertex with its last face; the surviving vertices around the holes become boundary
+	vertices, with their most ccw in-halfedge.
+	\param faces the faces to be deleted, duplicates are ignored
+	\return the new slots, the element slots and the trait columns are already compacted
+*/
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+typename CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::CSlotRemap CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::deleteFaces( const std::vector<tFace> & faces )
+{
+	std::vector<char>    face_dead( m_face_traits.size(), 0 );
+	std::vector<char>    edge_dead( m_edge_traits.size(), 0 );
+	std::vector<char>    vertex_dead( m_vertex_traits.size(), 0 );
+	std::vector<tFace>   dead;
+	std::vector<tVertex> ring;
+
+	for( size_t i = 0; i < faces.size(); i ++ )
+	{
+		tFace f = faces[i];
+		if( face_dead[f->slot()] ) continue;
+		face_dead[f->slot()] = 1;
+		dead.push_back( f );
+	}
+
+	//the vertices of the dead faces, once each, dead unless one of their in-halfedges survives
+	for( size_t i = 0; i < dead.size(); i ++ )
+	{
+		tHalfEdge h = faceHalfedge( dead[i] );
+		for( int k = 0; k < 3; k ++, h = faceNextCcwHalfEdge( h ) )
+		{
+			tVertex v = halfedgeTarget( h );
+			if( vertex_dead[v->slot()] ) continue;
+			vertex_dead[v->slot()] = 1;
+			ring.push_back( v );
+		}
+	}
+	//a sweep over the faces rather than a rotation, which would miss the other fans of a pinched vertex
+	std::vector<tHalfEdge> keep( m_vertex_traits.size(), (tHalfEdge) NULL );
+	for( typename std::list<CFace*>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); ++ fiter )
+	{
+		if( face_dead[(*fiter)->slot()] ) continue;
+		tHalfEdge h = faceHalfedge( *fiter );
+		for( int k = 0; k < 3; k ++, h = faceNextCcwHalfEdge( h ) )
+		{
+			tVertex v = halfedgeTarget( h );
+			if( !vertex_dead[v->slot()] ) continue;
+			vertex_dead[v->slot()] = 0;
+			keep[v->slot()] = h;
+		}
+	}
+
+	//an edge loses the halfedge of a dead face, or dies with its last face
+	for( size_t i = 0; i < dead.size(); i ++ )
+	{
+		tHalfEdge h = faceHalfedge( dead[i] );
+		for( int k = 0; k < 3; k ++, h = faceNextCcwHalfEdge( h ) )
+		{
+			tEdge     e   = halfedgeEdge( h );
+			tHalfEdge sym = halfedgeSym( h );
+			if( sym == NULL || face_dead[halfedgeFace( sym )->slot()] )
+			{
+				if( edge_dead[e->slot()] ) continue;
+				edge_dead[e->slot()] = 1;
+				if( m_edge_table_active ) m_edge_table.erase( halfedgeSource( h )->id(), halfedgeTarget( h )->id() );
+				continue;
+			}
+			e->halfedge(0) = sym;
+			e->halfedge(1) = NULL;
+		}
+	}
+
+	//the surviving vertices around the holes
+	for( size_t i = 0; i < ring.size(); i ++ )
+	{
+		tVertex   v     = ring[i];
+		tHalfEdge start = keep[v->slot()];
+		if( start == NULL ) continue;
+
+		std::list<CEdge*> & ledges = vertexEdges( v );
+		for( typename std::list<CEdge*>::iterator eiter = ledges.begin(); eiter != ledges.end(); )
+		{
+			if( edge_dead[(*eiter)->slot()] ) eiter = ledges.erase( eiter );
+			else ++ eiter;
+		}
+
+		tHalfEdge h = start;
+		while( h->he_sym() != NULL )
+		{
+			h = (tHalfEdge) h->ccw_rotate_about_target();
+			if( h == start ) break;
+		}
+		v->halfedge() = h;
+		if( h->he_sym() == NULL ) v->boundary() = true;
+	}
+
+	//sweep the lists
+	for( typename std::list<CFace*>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); )
+	{
+		tFace f = *fiter;
+		if( !face_dead[f->slot()] ) { ++ fiter; continue; }
+		fiter = m_faces.erase( fiter );
+		m_map_face.erase( f->id() );
+		tHalfEdge h = faceHalfedge( f );
+		for( int k = 0; k < 3; k ++ )
+		{
+			tHalfEdge n = faceNextCcwHalfEdge( h );
+			_delete_halfedge( h );
+			h = n;
+		}
+		_delete_face( f );
+	}
+	for( typename std::list<CEdge*>::iterator eiter = m_edges.begin(); eiter != m_edges.end(); )
+	{
+		tEdge e = *eiter;
+		if( !edge_dead[e->slot()] ) { ++ eiter; continue; }
+		eiter = m_edges.erase( eiter );
+		_delete_edge( e );
+	}
+	for( typename std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); )
+	{
+		tVertex v = *viter;
+		if( !vertex_dead[v->slot()] ) { ++ viter; continue; }
+		viter = m_verts.erase( viter );
+		m_map_vert.erase( v->id() );
+		_delete_vertex( v );
+	}
+
+	//compact the slots
+	CSlotRemap remap;
+	std::vector<tHalfEdge> hes;
+	hes.reserve( 3 * m_faces.size() );
+	for( typename std::list<CFace*>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); ++ fiter )
+	{
+		tHalfEdge h = faceHalfedge( *fiter );
+		for( int k = 0; k < 3; k ++, h = faceNextCcwHalfEdge( h ) ) hes.push_back( h );
+	}
+	_compact_slots( m_vertex_traits,   m_verts, remap.vertex );
+	_compact_slots( m_edge_traits,     m_edges, remap.edge );
+	_compact_slots( m_face_traits,     m_faces, remap.face );
+	_compact_slots( m_halfedge_traits, hes,     remap.halfedge );
+	return remap;
+};
+
+/*!
+	Renumber the slots of the live elements in the order of their old slots, so that
+	a new slot is never larger than the old one and the columns move in place.
+	\param traits   the trait columns of the kind
+	\param elements all the live elements of the kind
+	\param remap    the new slot of each old slot, -1 for a free slot
+*/
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+template<typename C>
+void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::_compact_slots( CTraitColumns & traits, C & elements, std::vector<int> & remap )
+{
+	remap.assign( traits.size(), -1 );
+	for( typename C::iterator iter = elements.begin(); iter != elements.end(); ++ iter ) remap[(*iter)->slot()] = 0;
+
+	int n = 0;
+	for( size_t s = 0; s < remap.size(); s ++ ) if( remap[s] == 0 ) remap[s] = n ++;
+
+	for( typename C::iterator iter = elements.begin(); iter != elements.end(); ++ iter ) (*iter)->slot() = remap[(*iter)->slot()];
+	traits.compact( remap, n );
 };
 
 /*!
@@ -1937,6 +2394,7 @@ void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::read_off( const char * input )
 
 		//printf("V %d F %d E %d\n" , nVertices, nFaces, nEdges);
 	
+	std::vector<CPoint> points;
 
 	for( int id = 0; id < nVertices; id ++ )
 	{
@@ -1954,8 +2412,14 @@ void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::read_off( const char * input )
 
 			CVertex * v = createVertex( id + 1 );
 			v->point() = p;
+			if( m_weld_epsilon >= 0 ) points.push_back( p );
 	}
 
+	//the faces go to the first vertex of each welded cluster
+	std::vector<int> weld;
+	if( m_weld_epsilon >= 0 ) weldPoints( points, m_weld_epsilon, m_load_threads, weld );
+	int degenerate = 0;
+
 
 	for( int id = 0; id < nFaces; id ++ )
 	{
@@ -1971,20 +2435,31 @@ void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::read_off( const char * input )
 		assert( n == 3 );
 
 		CVertex * v[3];
+		bool missing = false;
 		for( int j = 0; j < 3; j ++ )
 		{
 			stokenizer.nextToken();
 			std::string token = stokenizer.getToken();
 			int vid = strutil::parseString<int>( token );
+			if( vid >= 0 && vid < (int) weld.size() ) vid = weld[vid];
 			v[j] = idVertex( vid + 1);
+			if( v[j] == NULL )
+			{
+				fprintf(stderr,"Error: face %d refers to a missing vertex %d\n", id + 1, vid );
+				missing = true;
+			}
 		}
 		
+		if( missing ) continue;
+		if( v[0] == v[1] || v[1] == v[2] || v[2] == v[0] ) { degenerate ++; continue; }
 		createFace( v, id + 1 );
 	}
 
 	is.close();
+	if( degenerate > 0 ) fprintf(stderr,"Warning: welding removed %d degenerate faces\n", degenerate );
 
 	labelBoundary();
+	_finish_loading();
 
 };
 
@@ -1997,71 +2472,646 @@ void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::labelBoundary( void )
 {
 	
 	//Label boundary edges
-	for(std::list<CEdge*>::iterator eiter= m_edges.begin() ; eiter != m_edges.end() ; ++ eiter )
+	_label_boundary_edges( parallelThreads( m_load_threads ) );
+
+	//remove the dangling vertices
+	for(std::list<CVertex*>::iterator viter = m_verts.begin();  viter != m_verts.end() ; )
 	{
-		CEdge *     edge = *eiter;
-		CHalfEdge * he[2];
+		tVertex     v = *viter;
+		if( v->halfedge() != NULL ) { ++ viter; continue; }
+		viter = m_verts.erase( viter );
+		m_map_vert.erase( v->id() );
+		_delete_vertex( v );
+	}
 
-		he[0] = (CHalfEdge*)edge->halfedge(0);
-		he[1] = (CHalfEdge*)edge->halfedge(1);
-		
-		assert( he[0] != NULL );
-		
+	//Arrange the boundary half_edge of boundary vertices, to make its halfedge
+	//to be the most ccw in half_edge
+
+	for(std::list<CVertex*>::iterator viter = m_verts.begin();  viter != m_verts.end() ; ++ viter )
+	{
+		tVertex     v = *viter;
+		if( !v->boundary() ) continue;
+
+		CHalfEdge * he = (CHalfEdge*)v->halfedge();
+		while( he->he_sym() != NULL )
+		{
+			he = (CHalfEdge*)he->ccw_rotate_about_target();
+		}
+		v->halfedge() = he;
+	}
+
+
+};
+
+/*!
+	Release the edge hash table after loading, unless m_keep_edge_table is set.
+	Afterwards createEdge/vertexEdge fall back to the vertex edge lists.
+*/
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::_finish_loading()
+{
+	if( m_keep_edge_table ) return;
+	m_edge_table.clear();
+	m_edge_table_active = false;
+};
 
-		if( he[1] != NULL )
+/*!
+	Rebuild the vertex id index, and the edge hash table if it is in use,
+	after the vertex ids are renumbered.
+*/
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::_rebuild_id_tables()
+{
+	m_map_vert.clear();
+	for( std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter ++ )
+	{
+		tVertex v = *viter;
+		m_map_vert.insert( v->id(), v );
+	}
+
+	if( !m_edge_table_active ) return;
+	m_edge_table.clear();
+	m_edge_table.reserve( m_edges.size() );
+	for( std::list<CEdge*>::iterator eiter = m_edges.begin(); eiter != m_edges.end(); eiter ++ )
+	{
+		tEdge e = *eiter;
+		m_edge_table.insert( edgeVertex1( e )->id(), edgeVertex2( e )->id(), e );
+	}
+};
+
+/*!
+	Apply one record of an .m file, in the file order.
+	\param r     the record
+	\param ids   the id buffer of the record
+	\param state the loader state
+*/
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::_apply_m_record( CMRecord & r, std::vector<int> & ids, CLoadState & state )
+{
+	switch( r.type )
+	{
+	case CMRecord::VERTEX:
 		{
-			assert( he[0]->target() == he[1]->source() && he[0]->source() == he[1]->target() );
+			CPoint p( r.point[0], r.point[1], r.point[2] );
+			tVertex v  = createVertex( r.id[0] );
+			v->point() = p;
+			if( r.has_string ) _read_string( m_vertex_traits, v, r.string );
+		}
+		break;
 
-			if( he[0]->target()->id() < he[0]->source()->id() )
+	case CMRecord::FACE:
+		{
+			std::vector<tVertex> & v = state.fv;
+			bool missing = false;
+
+			v.clear();
+			for( size_t i = 0; i < r.count; i ++ )
 			{
-				edge->halfedge(0 ) = he[1];
-				edge->halfedge(1 ) = he[0];
+				int vid = ids[r.first + i];
+				CVertex * pV = idVertex( vid );
+				if( pV == NULL )
+				{
+					fprintf(stderr,"Error: face %d refers to a missing vertex %d\n", r.id[0], vid );
+					missing = true;
+				}
+				v.push_back( pV );
 			}
+			if( missing ) break;
 
-			assert( edgeVertex1(edge)->id() < edgeVertex2(edge)->id() );
+			tFace f = state.defer ? _defer_face( v, r.id[0], state ) : createFace( v, r.id[0] );
+			if( r.has_string ) _read_string( m_face_traits, f, r.string );
 		}
-		else
+		break;
+
+	case CMRecord::EDGE:
 		{
-			he[0]->vertex()->boundary() = true;
-			he[0]->he_prev()->vertex()->boundary()  = true;
+			CVertex * v0 = idVertex( r.id[0] );
+			CVertex * v1 = idVertex( r.id[1] );
+			if( v0 == NULL || v1 == NULL || !r.has_string ) break;
+
+			if( state.defer )
+			{
+				state.edges.push_back( &r );
+				state.edge_verts.push_back( v0 );
+				state.edge_verts.push_back( v1 );
+				state.edge_time.push_back( state.faces.size() );
+				break;
+			}
+			tEdge edge = vertexEdge( v0, v1 );
+			if( edge != NULL ) _read_string( m_edge_traits, edge, r.string );
 		}
+		break;
+
+	case CMRecord::CORNER:
+		{
+			CVertex * v = idVertex( r.id[0] );
+			CFace   * f = idFace( r.id[1] );
+			if( v == NULL || f == NULL || !r.has_string ) break;
 
+			if( state.defer )
+			{
+				state.corners.push_back( &r );
+				state.corner_verts.push_back( v );
+				state.corner_faces.push_back( f );
+				break;
+			}
+			tHalfEdge he = corner( v, f );
+			if( he != NULL ) _read_string( m_halfedge_traits, he, r.string );
+		}
+		break;
 	}
+};
 
-	std::list<CVertex*> dangling_verts;
-	//Label boundary edges
-	for(std::list<CVertex*>::iterator viter = m_verts.begin();  viter != m_verts.end() ; ++ viter )
+/*!
+	Apply one record of an .obj file, in the file order.
+	\param r     the record
+	\param state the loader state
+*/
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::_apply_obj_record( CObjRecord & r, CLoadState & state )
+{
+	switch( r.type )
 	{
-		tVertex     v = *viter;
-		if( v->halfedge() != NULL ) continue;
-		dangling_verts.push_back( v );
+	case CObjRecord::VERTEX:
+		{
+			CPoint p( r.value[0], r.value[1], r.value[2] );
+			CVertex * v = createVertex( state.vid ++ );
+			v->point() = p;
+		}
+		break;
+
+	case CObjRecord::UV:
+		state.with_uv = true;
+		state.uvs.push_back( CPoint2( r.value[0], r.value[1] ) );
+		break;
+
+	case CObjRecord::NORMAL:
+		state.with_normal = true;
+		state.normals.push_back( CPoint( r.value[0], r.value[1], r.value[2] ) );
+		break;
+
+	case CObjRecord::FACE:
+		{
+			CVertex* v[3];
+			bool missing = false;
+			for( int i = 0 ; i < 3; i ++ )
+			{
+				v[i] = idVertex( r.corner[i][0] );
+				if( v[i] == NULL )
+				{
+					fprintf(stderr,"Error: face %d refers to a missing vertex %d\n", state.fid, r.corner[i][0] );
+					missing = true;
+					continue;
+				}
+				int t = r.corner[i][1], n = r.corner[i][2];
+				if( state.with_uv && t >= 1 && t <= (int) state.uvs.size() )
+					v[i]->uv() = state.uvs[ t-1 ];
+				if( state.with_normal && n >= 1 && n <= (int) state.normals.size() )
+					v[i]->normal() = state.normals[ n-1 ];
+			}
+			if( missing ) break;
+
+			if( state.defer )
+			{
+				state.fv.assign( v, v + 3 );
+				_defer_face( state.fv, state.fid ++, state );
+			}
+			else
+			{
+				createFace( v, state.fid ++ );
+			}
+		}
+		break;
 	}
+};
 
-	for( std::list<CVertex*>::iterator  viter = dangling_verts.begin() ; viter != dangling_verts.end(); ++ viter )
+/*!
+	Weld the vertices of the .obj records, see Spatial/Weld.h. The vertex records stay,
+	the vertices welded away dangle and are removed by labelBoundary; the face corners
+	go to the first vertex of their cluster, the faces made degenerate are dropped.
+	\param records the records of each part, in the file order
+	\param threads number of threads
+*/
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::_weld_obj_records( std::vector< std::vector<CObjRecord> > & records, int threads )
+{
+	std::vector<CPoint> points;
+	for( size_t t = 0; t < records.size(); t ++ )
 	{
-		tVertex v = *viter;
-		m_verts.remove( v );
-		delete v;
-		v = NULL;
+		for( size_t i = 0; i < records[t].size(); i ++ )
+		{
+			CObjRecord & r = records[t][i];
+			if( r.type == CObjRecord::VERTEX ) points.push_back( CPoint( r.value[0], r.value[1], r.value[2] ) );
+		}
 	}
 
-	//Arrange the boundary half_edge of boundary vertices, to make its halfedge
-	//to be the most ccw in half_edge
+	std::vector<int> weld;
+	weldPoints( points, m_weld_epsilon, threads, weld );
 
-	for(std::list<CVertex*>::iterator viter = m_verts.begin();  viter != m_verts.end() ; ++ viter )
+	int degenerate = 0;
+	for( size_t t = 0; t < records.size(); t ++ )
 	{
-		tVertex     v = *viter;
-		if( !v->boundary() ) continue;
+		for( size_t i = 0; i < records[t].size(); i ++ )
+		{
+			CObjRecord & r = records[t][i];
+			if( r.type != CObjRecord::FACE ) continue;
+			for( int k = 0; k < 3; k ++ )
+			{
+				int & c = r.corner[k][0];
+				if( c >= 1 && c <= (int) weld.size() ) c = weld[c-1] + 1;
+			}
+			if( r.corner[0][0] == r.corner[1][0] || r.corner[1][0] == r.corner[2][0] || r.corner[2][0] == r.corner[0][0] )
+			{
+				r.type = CObjRecord::NONE;
+				degenerate ++;
+			}
+		}
+	}
+	if( degenerate > 0 ) fprintf(stderr,"Warning: welding removed %d degenerate faces\n", degenerate );
+};
 
-		CHalfEdge * he = (CHalfEdge*)v->halfedge();
-		while( he->he_sym() != NULL )
+/*!
+	Create a face without halfedges, its vertices wait in the loader state.
+	\param v     the face vertices
+	\param id    face id
+	\param state the loader state
+	\return the new face
+*/
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+CFace * CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::_defer_face( std::vector<tVertex> & v, int id, CLoadState & state )
+{
+	CFace * f = _new_face();
+	assert( f != NULL );
+	f->id() = id;
+	m_faces.push_back( f );
+	m_map_face.insert( id, f );
+
+	state.faces.push_back( f );
+	state.verts.insert( state.verts.end(), v.begin(), v.end() );
+	state.start.push_back( state.verts.size() );
+	return f;
+};
+
+/*!
+	Split a mapped file at line boundaries and parse the parts on their own threads.
+	\param file    the mapped file
+	\param threads number of parts
+	\param records records of each part, in the file order
+	\param ids     id buffers of each part
+*/
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+template<typename CRecord>
+void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::_parse_records( CMappedFile & file, int threads, std::vector< std::vector<CRecord> > & records, std::vector< std::vector<int> > & ids )
+{
+	std::vector<const char*> bounds;
+	file.split( threads, bounds );
+
+	records.assign( threads, std::vector<CRecord>() );
+	ids.assign( threads, std::vector<int>() );
+
+	parallelFor( (size_t) threads, threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t t = b; t < e; t ++ )
 		{
-			he = (CHalfEdge*)he->ccw_rotate_about_target();
+			CRecord r;
+			const char * pos = bounds[t];
+			while( pos < bounds[t+1] )
+			{
+				strutil::StrRef line;
+				pos = strutil::getLine( pos, bounds[t+1], line );
+				if( r.parse( strutil::trim( line ), ids[t] ) ) records[t].push_back( r );
+			}
+		}
+	});
+};
+
+/*!
+	Build the halfedges of the deferred faces, then apply the Edge and Corner traits.
+	An Edge record only applies to an edge which exists at its line, i.e. whose first
+	face comes before the record, as in the serial loader.
+	\param state   the loader state
+	\param report  print the faces whose edge has more than two halfedges
+	\param threads number of threads
+*/
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::_finish_deferred( CLoadState & state, bool report, int threads )
+{
+	std::vector<size_t> edge_first;
+	int base = (int) m_edges.size();
+	_create_faces( state.faces, state.start, state.verts, report, edge_first, threads );
+
+	for( size_t k = 0; k < state.edges.size(); k ++ )
+	{
+		tEdge edge = vertexEdge( state.edge_verts[2*k], state.edge_verts[2*k+1] );
+		if( edge == NULL || edge->id() <= base ) continue;
+
+		size_t g = edge_first[ edge->id() - base - 1 ];
+		size_t f = std::upper_bound( state.start.begin(), state.start.end(), g ) - state.start.begin() - 1;
+		if( f >= state.edge_time[k] ) continue;
+
+		_read_string( m_edge_traits, edge, state.edges[k]->string );
+	}
+
+	for( size_t k = 0; k < state.corners.size(); k ++ )
+	{
+		tHalfEdge he = corner( state.corner_verts[k], state.corner_faces[k] );
+		if( he != NULL ) _read_string( m_halfedge_traits, he, state.corners[k]->string );
+	}
+};
+
+/*!
+	Build the halfedges and the edges of faces which have been created without them.
+	The result is the same as calling createFace on the faces in order: the halfedges
+	are sorted by the ids of their end vertices to find the pairs, and each edge is
+	created at the first halfedge of its pair, so the edges keep the serial order, ids,
+	halfedge(0)/halfedge(1) and vertex edge lists.
+	\param faces      the faces, in creation order
+	\param start      the vertices of faces[k] are verts[start[k]] ... verts[start[k+1]-1]
+	\param verts      the face vertices
+	\param report     print the faces whose edge has more than two halfedges
+	\param edge_first index of the first halfedge of each new edge
+	\param threads    number of threads
+*/
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::_create_faces( std::vector<tFace> & faces, std::vector<size_t> & start, std::vector<tVertex> & verts, bool report, std::vector<size_t> & edge_first, int threads )
+{
+	typedef std::pair<unsigned long long, size_t> tKey;
+
+	size_t nf = faces.size();
+	size_t nh = verts.size();
+
+	//halfedges, the last halfedge pointing to a vertex becomes its halfedge
+	std::vector<tHalfEdge> hes( nh );
+	for( size_t g = 0; g < nh; g ++ )
+	{
+		tHalfEdge pH = _new_halfedge();
+		assert( pH );
+		pH->vertex() = verts[g];
+		verts[g]->halfedge() = pH;
+		hes[g] = pH;
+	}
+
+	//link the halfedges of each face; halfedge g goes from the previous face vertex to verts[g]
+	std::vector<tKey> keys( nh );
+	parallelFor( nf, threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t k = b; k < e; k ++ )
+		{
+			size_t s = start[k];
+			size_t n = start[k+1] - s;
+			for( size_t i = 0; i < n; i ++ )
+			{
+				size_t g = s + i;
+				size_t h = s + ( i + n - 1 ) % n;
+				hes[g]->he_next() = hes[ s + ( i + 1 ) % n ];
+				hes[g]->he_prev() = hes[h];
+				hes[g]->face()    = faces[k];
+				keys[g] = tKey( CEdgeTable<CEdge>::pack( verts[g]->id(), verts[h]->id() ), g );
+			}
+			if( n > 0 ) faces[k]->halfedge() = hes[ s + n - 1 ];
+		}
+	});
+
+	parallelSort( keys, threads, std::less<tKey>() );
+
+	//an edge starts at the first halfedge of each run of equal keys, number them in halfedge order
+	const size_t none = (size_t) -1;
+	std::vector<size_t> rank( nh, none );
+	parallelFor( nh, threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ )
+		{
+			if( i == 0 || keys[i].first != keys[i-1].first ) rank[ keys[i].second ] = 0;
+		}
+	});
+
+	std::vector<size_t> offset( threads + 1, 0 );
+	parallelFor( nh, threads, [&]( size_t b, size_t e, int t )
+	{
+		size_t c = 0;
+		for( size_t g = b; g < e; g ++ ) if( rank[g] != none ) c ++;
+		offset[t+1] = c;
+	});
+	for( int t = 0; t < threads; t ++ ) offset[t+1] += offset[t];
+
+	size_t ne = offset[threads];
+	edge_first.resize( ne );
+	parallelFor( nh, threads, [&]( size_t b, size_t e, int t )
+	{
+		size_t r = offset[t];
+		for( size_t g = b; g < e; g ++ )
+		{
+			if( rank[g] == none ) continue;
+			rank[g] = r;
+			edge_first[r ++] = g;
+		}
+	});
+
+	//edges, in creation order
+	std::vector<tEdge> edges( ne );
+	for( size_t r = 0; r < ne; r ++ )
+	{
+		CEdge * e = _new_edge();
+		assert( e != NULL );
+		m_edges.push_back( e );
+		e->id() = (int)m_edges.size();
+		edges[r] = e;
+	}
+
+	//connect each run of halfedges to its edge, the last halfedge of a run becomes halfedge(1)
+	std::vector<char> illegal( threads, 0 );
+	parallelFor( nh, threads, [&]( size_t b, size_t e, int t )
+	{
+		size_t i = b;
+		while( i < e && i > 0 && keys[i].first == keys[i-1].first ) i ++;
+		while( i < e )
+		{
+			size_t j = i + 1;
+			while( j < nh && keys[j].first == keys[i].first ) j ++;
+
+			CEdge * pE = edges[ rank[ keys[i].second ] ];
+			pE->halfedge(0) = hes[ keys[i].second ];
+			if( j - i > 1 ) pE->halfedge(1) = hes[ keys[j-1].second ];
+			if( j - i > 2 ) illegal[t] = 1;
+
+			for( size_t m = i; m < j; m ++ ) hes[ keys[m].second ]->edge() = pE;
+			i = j;
+		}
+	});
+
+	if( report && std::find( illegal.begin(), illegal.end(), 1 ) != illegal.end() )
+	{
+		std::vector<size_t> extra;
+		for( size_t i = 0, j; i < nh; i = j )
+		{
+			for( j = i + 1; j < nh && keys[j].first == keys[i].first; j ++ )
+			{
+				if( j - i >= 2 ) extra.push_back( keys[j].second );
+			}
+		}
+		std::sort( extra.begin(), extra.end() );
+		for( size_t k = 0; k < extra.size(); k ++ )
+		{
+			size_t f = std::upper_bound( start.begin(), start.end(), extra[k] ) - start.begin() - 1;
+			std::cout << "Illegal Face Construction " << faces[f]->id() << std::endl;
 		}
-		v->halfedge() = he;
 	}
 
+	//vertex edge lists, the edges go to the end vertex with the smaller id, in creation order;
+	//a vertex belongs to thread id % threads, the edges are grouped by that thread once, stably
+	std::vector<tVertex> lower( ne );
+	std::vector<size_t>  count( (size_t) threads * threads, 0 );
+	parallelFor( ne, threads, [&]( size_t b, size_t e, int c )
+	{
+		for( size_t r = b; r < e; r ++ )
+		{
+			tHalfEdge pH = hes[ edge_first[r] ];
+			tVertex   v1 = (tVertex) pH->vertex();
+			tVertex   v2 = (tVertex) pH->he_prev()->vertex();
+			lower[r] = ( v1->id() < v2->id() )? v1 : v2;
+			count[ c * threads + (unsigned int) lower[r]->id() % (unsigned int) threads ] ++;
+		}
+	});
 
+	//count[c*threads+o] becomes the position of the first edge of chunk c owned by thread o
+	std::vector<size_t> owned( threads + 1, 0 );
+	for( int o = 0; o < threads; o ++ )
+	{
+		owned[o+1] = owned[o];
+		for( int c = 0; c < threads; c ++ )
+		{
+			size_t n = count[ c * threads + o ];
+			count[ c * threads + o ] = owned[o+1];
+			owned[o+1] += n;
+		}
+	}
+
+	std::vector<size_t> order( ne );
+	parallelFor( ne, threads, [&]( size_t b, size_t e, int c )
+	{
+		for( size_t r = b; r < e; r ++ ) order[ count[ c * threads + (unsigned int) lower[r]->id() % (unsigned int) threads ] ++ ] = r;
+	});
+
+	parallelFor( (size_t) threads, threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t k = owned[b]; k < owned[e]; k ++ )
+		{
+			size_t  r  = order[k];
+			tVertex pV = lower[r];
+			std::list<CEdge*> & ledges = (std::list<CEdge*> &) pV->edges();
+			ledges.push_back( edges[r] );
+			edges[r]->position() = -- pV->edges().end();
+		}
+	});
+
+	if( m_edge_table_active )
+	{
+		m_edge_table.reserve( m_edge_table.size() + ne );
+		for( size_t r = 0; r < ne; r ++ )
+		{
+			tHalfEdge pH = hes[ edge_first[r] ];
+			m_edge_table.insert( pH->vertex()->id(), pH->he_prev()->vertex()->id(), edges[r] );
+		}
+	}
+};
+
+/*!
+	Let halfedge(0) of every interior edge start from the end vertex with the smaller id,
+	and label the end vertices of the boundary edges. The edges are independent, they
+	are split among the threads.
+	\param threads number of threads
+*/
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::_label_boundary_edges( int threads )
+{
+	std::vector<tEdge> edges( m_edges.begin(), m_edges.end() );
+	std::vector< std::vector<tHalfEdge> > boundary( threads );
+
+	parallelFor( edges.size(), threads, [&]( size_t b, size_t e, int t )
+	{
+		for( size_t i = b; i < e; i ++ )
+		{
+			CEdge *     edge = edges[i];
+			CHalfEdge * he[2];
+
+			he[0] = (CHalfEdge*)edge->halfedge(0);
+			he[1] = (CHalfEdge*)edge->halfedge(1);
+
+			assert( he[0] != NULL );
+
+			if( he[1] != NULL )
+			{
+				assert( he[0]->target() == he[1]->source() && he[0]->source() == he[1]->target() );
+
+				if( he[0]->target()->id() < he[0]->source()->id() )
+				{
+					edge->halfedge(0 ) = he[1];
+					edge->halfedge(1 ) = he[0];
+				}
+
+				assert( edgeVertex1(edge)->id() < edgeVertex2(edge)->id() );
+			}
+			else
+			{
+				boundary[t].push_back( he[0] );
+			}
+		}
+	});
+
+	for( int t = 0; t < threads; t ++ )
+	{
+		for( size_t i = 0; i < boundary[t].size(); i ++ )
+		{
+			CHalfEdge * he = boundary[t][i];
+			he->vertex()->boundary() = true;
+			he->he_prev()->vertex()->boundary()  = true;
+		}
+	}
+};
+
+/*!
+	Read the traits of the vertices, edges, faces and halfedges from their strings.
+	The hooks are called serially unless m_parallel_traits is set, and not at all
+	without m_trait_strings.
+	\param threads number of threads
+*/
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::_read_traits( int threads )
+{
+	if( !m_trait_strings ) return;
+	if( !m_parallel_traits ) threads = 1;
+
+	std::vector<tVertex> verts( m_verts.begin(), m_verts.end() );
+	parallelFor( verts.size(), threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ ) verts[i]->_from_string();
+	});
+
+	std::vector<tEdge> edges( m_edges.begin(), m_edges.end() );
+	parallelFor( edges.size(), threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ ) edges[i]->_from_string();
+	});
+
+	std::vector<tFace> faces( m_faces.begin(), m_faces.end() );
+	parallelFor( faces.size(), threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ ) faces[i]->_from_string();
+	});
+
+	parallelFor( faces.size(), threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ )
+		{
+			CFace * pF = faces[i];
+
+			CHalfEdge * pH  = faceMostCcwHalfEdge( pF );
+			do{
+				pH->_from_string();
+				pH = faceNextCcwHalfEdge( pH );
+			}while( pH != faceMostCcwHalfEdge(pF ) );
+		}
+	});
 };
 
 /*! Create a face
@@ -2073,18 +3123,18 @@ void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::labelBoundary( void )
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 CFace * CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::createFace( std::vector<tVertex> &  v, int id )
 {
-	  CFace * f = new CFace();
+	  CFace * f = _new_face();
 	  assert( f != NULL );
 	  f->id() = id;
 	  m_faces.push_back( f );
-	  m_map_face.insert( std::pair<int,tFace>(id,f) );
+	  m_map_face.insert( id, f );
 
 		//create halfedges
 	  std::vector<tHalfEdge> hes;
 
 		for(size_t i = 0; i < v.size(); i ++ )
 		{
-			tHalfEdge pH = new CHalfEdge;
+			tHalfEdge pH = _new_halfedge();
 			assert( pH );
 			CVertex * vert =  v[i];
 			pH->vertex() = vert;
@@ -2135,61 +3185,56 @@ CFace * CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::createFace( std::vector<tVerte
 	*/template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 void CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::write_g( const char * output )
 {
-
-	std::fstream _os( output, std::fstream::out );
-	if( _os.fail() )
+	FILE * _os = fopen( output, "w" );
+	if( _os == NULL )
 	{
 		fprintf(stderr,"Error is opening file %s\n", output );
 		return;
 	}
 
+	int threads = parallelThreads( m_write_threads );
+	std::vector<tVertex> verts( m_verts.begin(), m_verts.end() );
+	std::vector<tEdge>   edges( m_edges.begin(), m_edges.end() );
+	std::vector<tFace>   faces( m_faces.begin(), m_faces.end() );
 
-	//remove vertices
-  for( std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter ++)
-  {
-		tVertex v = *viter;
+	bool ok = parallelWrite( _os, verts.size(), threads, [&]( size_t i, CTextBuffer & buffer )
+	{
+		tVertex v = verts[i];
 
-		_os << "Vertex " << v->id();
-		
-		for( int i = 0; i < 3; i ++ )
+		buffer << "Vertex " << v->id();
+		for( int k = 0; k < 3; k ++ )
 		{
-			_os << " " << v->point()[i];
+			buffer << ' ' << v->point()[k];
 		}
-		if( v->string().size() > 0 )
-		{
-			_os << " " <<"{"<< v->string() << "}";
-		}
-		_os << std::endl;
-	}
+		_write_string( m_vertex_traits, v, buffer, true );
+		buffer << '\n';
+	});
 
-  for( std::list<CEdge*>::iterator eiter = m_edges.begin(); eiter != m_edges.end(); eiter ++ )
-  {
-		tEdge e = *eiter;
+	ok = ok && parallelWrite( _os, edges.size(), threads, [&]( size_t i, CTextBuffer & buffer )
+	{
+		tEdge e = edges[i];
+		buffer << "Edge " << e->id() << ' ' << edgeVertex1( e )->id() << ' ' << edgeVertex2( e )->id() << '\n';
+	});
 
-		_os << "Edge " << e->id() << " ";
-		tVertex v1 = edgeVertex1( e );
-		tVertex v2 = edgeVertex2( e );
-		_os << v1->id() << " " << v2->id() << std::endl;
-  }
-  for( std::list<CFace*>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter ++ )
+	ok = ok && parallelWrite( _os, faces.size(), threads, [&]( size_t i, CTextBuffer & buffer )
 	{
-		tFace f = *fiter;
+		tFace f = faces[i];
 
-		_os << "Face " << f->id();
+		buffer << "Face " << f->id();
 		tHalfEdge he = faceHalfedge( f );
 		do{
-			_os << " " <<  he->edge()->id();
+			buffer << ' ' << he->edge()->id();
 			he = halfedgeNext( he );
 		}while( he != f->halfedge() );
 
-		if( f->string().size() > 0 )
-		{
-			_os << " " << "{"<< f->string() << "}";
-		}
-		_os << std::endl;
-	}
+		_write_string( m_face_traits, f, buffer, true );
+		buffer << '\n';
+	});
 
-	_os.close();
+	if( fclose( _os ) != 0 || !ok )
+	{
+		fprintf(stderr,"Error in writing file %s\n", output );
+	}
 };
 
 
@@ -11,9 +11,11 @@
 #ifndef  _DYNAMIC_MESH_H_
 #define  _DYNAMIC_MESH_H_
 
+#include <math.h>
 #include <map>
 #include <vector>
 #include <queue>
+#include <algorithm>
 
 #include "Mesh/BaseMesh.h"
 #include "Mesh/boundary.h"
@@ -30,14 +32,19 @@ namespace MeshLib
 --------------------------------------------------------------------------------------------------------------------------------------*/
 /*! \brief CDynamicMesh class : Dynamic mesh
 * 
-*  Mesh supports FaceSlit, EdgeSlit, EdgeSwap operations
+*  Mesh supports FaceSlit, EdgeSlit, EdgeSwap operations. The edits mark the
+*  edges and the faces whose geometry changed, see dirtyEdges() and dirtyFaces(),
+*  so that the lengths, angles, curvatures and weights are updated locally.
 */
 template<typename V, typename E, typename F, typename H>
 class CDynamicMesh : public CBaseMesh<V,E,F,H>
 {
 public:
-	/*! CDynamicMesh constructor */
-	CDynamicMesh(){ m_vertex_id = 0; m_face_id = 0; };
+	/*! subdivision schemes, see subdivide() */
+	enum { LOOP, MIDPOINT };
+
+	/*! CDynamicMesh constructor, the edge table is kept after loading for swapEdge */
+	CDynamicMesh(){ m_vertex_id = 0; m_face_id = 0; m_edge_id = -1; m_keep_edge_table = true; };
 	/*! CDynamicMesh destructor */
 	~CDynamicMesh();
 
@@ -50,10 +57,75 @@ public:
 	 * \param pEdge the edge to be split
 	 */
 	V *  splitEdge( E * pEdge );
-	/*! Swap an edge
+	/*! Swap an edge, refused with a warning on the boundary or if the two opposite vertices are already joined.
+	* O(1): the opposite vertices are looked up in the edge table; if m_keep_edge_table was cleared
+	* before loading, the lookup scans an edge list instead, O(valence) of the opposite vertex
 	* \param edge the edge to be swapped
 	*/
 	void swapEdge( E * edge );
+	/*! Whether an edge can be collapsed without changing the topology: the common neighbors
+	 * of its end vertices are the opposite vertices of its faces ( the link condition ), an
+	 * interior edge does not join two boundary vertices, and no vertex is left without a face
+	 * \param pEdge the edge
+	 */
+	bool collapsible( E * pEdge );
+	/*! Collapse an edge to one of its end vertices, the faces of the edge are removed. The
+	 * uv, the normal and the vertex trait columns of the kept vertex are interpolated at p,
+	 * the traits in the members of the vertex class by its _mix hook, see CVertex::_mix.
+	 * \param pEdge the edge to be collapsed
+	 * \param pV    the end vertex which is kept, the other one is removed
+	 * \param p     the new position of pV
+	 * \param sweep remove the deleted elements from the lists now, a scan of the element lists
+	 *              which makes the collapse O(n); otherwise they stay in the lists, unlinked and
+	 *              not freed, until sweep(), so that collapses in a row cost O(1) each
+	 * \return pV, NULL if the edge is not collapsible
+	 */
+	V *  collapseEdge( E * pEdge, V * pV, const CPoint & p, bool sweep = true );
+	/*! Remove the elements deleted by the collapses from the lists and the dirty lists and free them, O(n);
+	 * a CGeometryCache of the mesh has to drop them too, see CGeometryCache::prune */
+	void sweep();
+	/*! Delete a batch of faces and compact the slots, see CBaseMesh::deleteFaces; the dirty
+	 * flags move with the slots and the vertices around the holes are marked dirty, a
+	 * CGeometryCache of the mesh is moved to the new slots by CGeometryCache::remap
+	 * \param dead the faces to be deleted
+	 */
+	typename CBaseMesh<V,E,F,H>::CSlotRemap deleteFaces( const std::vector<F*> & dead );
+	/*! Subdivide a triangle mesh, every face is split into four at the midpoints of its edges.
+	 * The old vertices keep their ids, the edge vertices are numbered after them. With LOOP the
+	 * vertices move by Loop's masks, the boundary by the cubic B-spline mask; with MIDPOINT
+	 * they stay put. The uv, the normal and the vertex trait columns are interpolated with the
+	 * same masks, and the traits in the members of the vertex class by its _mix hook; the edges
+	 * and the faces inherit the trait columns of their parents.
+	 * \param fine    an empty mesh which receives the subdivided mesh
+	 * \param scheme  LOOP or MIDPOINT
+	 * \param levels  number of subdivisions, at least 1
+	 * \param threads number of threads, 0 for all the hardware threads
+	 */
+	void subdivide( CDynamicMesh<V,E,F,H> & fine, int scheme = LOOP, int levels = 1, int threads = 0 );
+
+	//dirty tracking, the edits mark the elements whose geometry changed
+	/*! Mark the edges and the faces around a vertex as changed, e.g. after moving the vertex
+	 * \param pV the vertex
+	 */
+	void markDirty( V * pV );
+	/*! Mark an edge and its faces as changed
+	 * \param pE the edge
+	 */
+	void markDirty( E * pE );
+	/*! Mark a face as changed
+	 * \param pF the face
+	 */
+	void markDirty( F * pF );
+	/*! edges whose length may have changed since the last clearDirty() */
+	std::vector<E*> & dirtyEdges() { return m_dirty_edges; };
+	/*! faces whose angles may have changed since the last clearDirty() */
+	std::vector<F*> & dirtyFaces() { return m_dirty_faces; };
+	/*! vertices of the dirty faces, whose curvature may have changed */
+	std::vector<V*> & dirtyVertices() { return m_dirty_vertices; };
+	/*! true if the face is in dirtyFaces() */
+	bool isDirty( F * pF ) { return (size_t) pF->slot() < m_face_dirty.size() && m_face_dirty[pF->slot()]; };
+	/*! Forget the dirty elements, once the geometry has been updated */
+	void clearDirty();
 
 
 protected:
@@ -62,13 +134,51 @@ protected:
 	* \param e edge
 	*/
 	void __attach_halfedge_to_edge( H * he0, H * he1, E * e );
-	/*! next vertex id */
+	/*! the in-halfedges and the edges around a vertex */
+	void _vertex_ring( V * pV, std::vector<H*> & in, std::vector<E*> & edges );
+	/*! remove an edge from the edge list of its end vertex with the smaller id, and from the edge table, in O(1) */
+	void _unlist_edge( E * pE );
+	/*! add an edge to the edge list of its end vertex with the smaller id, and to the edge table */
+	void _list_edge( E * pE );
+	/*! one level of subdivide(), false if the mesh is not a triangle mesh */
+	bool _subdivide( CDynamicMesh<V,E,F,H> & fine, int scheme, int threads );
+	/*! an unused vertex id, larger than the ones handed out before */
+	int  _new_vertex_id();
+	/*! an unused face id, larger than the ones handed out before */
+	int  _new_face_id();
+	/*! a new edge id, larger than the ids of the loaded edges and the ones handed out before */
+	int  _new_edge_id();
+	/*! move flags indexed by the slots to the new slots */
+	static void _remap_flags( std::vector<bool> & flags, const std::vector<int> & remap, int n );
+	/*! last vertex id handed out */
 	int  m_vertex_id;
-	/*! next face id */
+	/*! last face id handed out */
 	int  m_face_id;
-	/*! next edge id */
+	/*! last edge id handed out, -1 until the ids of the loaded edges are scanned */
 	int  m_edge_id;
 
+	/*! dirty edges */
+	std::vector<E*>    m_dirty_edges;
+	/*! dirty faces */
+	std::vector<F*>    m_dirty_faces;
+	/*! vertices of the dirty faces */
+	std::vector<V*>    m_dirty_vertices;
+	/*! by edge slot, true if the edge is in m_dirty_edges */
+	std::vector<bool>  m_edge_dirty;
+	/*! by face slot, true if the face is in m_dirty_faces */
+	std::vector<bool>  m_face_dirty;
+	/*! by vertex slot, true if the vertex is in m_dirty_vertices */
+	std::vector<bool>  m_vertex_dirty;
+
+	/*! faces removed by collapseEdge, still in the list until sweep() */
+	std::vector<F*>    m_removed_faces;
+	/*! edges removed by collapseEdge, still in the list until sweep() */
+	std::vector<E*>    m_removed_edges;
+	/*! vertices removed by collapseEdge, still in the list until sweep() */
+	std::vector<V*>    m_removed_vertices;
+	/*! halfedges of the removed faces, freed by sweep() */
+	std::vector<H*>    m_removed_halfedges;
+
 public:		/// added by YY
 
 	/*!
@@ -98,24 +208,7 @@ CDynamicMesh<V,E,F,H>::~CDynamicMesh()
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 CVertex * CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::splitFace( CFace * pFace )
 {
-
-	m_vertex_id = 0;
-
-	for( std::list<tVertex>::iterator viter =m_verts.begin(); viter != m_verts.end(); viter ++ )
-	{
-		tVertex  pV = *viter;
-		m_vertex_id = ( m_vertex_id > pV->id() )?m_vertex_id:pV->id();
-	}
-
-	m_face_id   = 0;
-	for( std::list<tFace>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); fiter ++ )
-	{
-		tFace  pF = *fiter;
-		m_face_id = ( m_face_id > pF->id() )?m_face_id:pF->id();
-	}
-
-
-	CVertex * pV = createVertex( ++m_vertex_id );
+	CVertex * pV = createVertex( _new_vertex_id() );
 	
 	CVertex   *  v[3];
     CHalfEdge *  h[3];
@@ -135,16 +228,17 @@ CVertex * CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::splitFace( CFace * pFace
 	}
 	
 
-	CFace * f = new CFace();
+	CFace * f = _new_face();
 	assert( f != NULL );
-	f->id() = ++m_face_id;
+	f->id() = _new_face_id();
 	m_faces.push_back( f );
+	m_map_face.insert( f->id(), f );
 
 	//create halfedges
 	tHalfEdge hes[3];
 	for(int i = 0; i < 3; i ++ )
 	{
-		hes[i] = new CHalfEdge;
+		hes[i] = _new_halfedge();
 		assert( hes[i] );
 	}
 
@@ -163,17 +257,18 @@ CVertex * CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::splitFace( CFace * pFace
 	}
 
 
-	f = new CFace();
+	f = _new_face();
 	assert( f != NULL );
-	f->id() = ++m_face_id;
+	f->id() = _new_face_id();
 	m_faces.push_back( f );
+	m_map_face.insert( f->id(), f );
 
 	//create halfedges
 	tHalfEdge hes2[3];
 
 	for(int i = 0; i < 3; i ++ )
 	{
-		hes2[i] = new CHalfEdge;
+		hes2[i] = _new_halfedge();
 		assert( hes2[i] );
 	}
 
@@ -194,8 +289,9 @@ CVertex * CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::splitFace( CFace * pFace
 	CEdge * e[3];
 	for( int i = 0; i < 3; i ++ )
 	{
-		e[i] = new CEdge();
+		e[i] = _new_edge();
 		assert( e[i] );
+		e[i]->id() = _new_edge_id();
 		m_edges.push_back( e[i] );
 	}
 
@@ -225,12 +321,15 @@ CVertex * CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::splitFace( CFace * pFace
 	v[0]->halfedge() = h[0];
 	v[1]->halfedge() = hes[1];
 	v[2]->halfedge() = hes2[2];
+
+	for( int i = 0; i < 3; i ++ ) _list_edge( e[i] );
 /*
 	for( int i = 0; i < 3; i ++ )
 	{
 		v[i]->halfedge() = hs[i]->he_sym();
 	}
 */
+	markDirty( pV );
 	return pV;
 
 };
@@ -276,6 +375,13 @@ void CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::swapEdge( CEdge * edge )
   pv[2] = halfedgeTarget( ph[2]);
   pv[3] = halfedgeTarget( ph[4]);
 
+  //the flipped edge would duplicate an edge already joining the two opposite vertices
+  if( pv[1] == pv[3] || vertexEdge( pv[1], pv[3] ) != NULL )
+  {
+	  std::cerr <<"Warning: Ilegal: Edge Swap creates a duplicated edge" << std::endl;
+	  return;
+  }
+
   int     pi[6];
   CEdge * pe[6];
 
@@ -296,30 +402,8 @@ void CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::swapEdge( CEdge * edge )
     }
   }
 
-/*
-  //remove edge from edge list of the original vertex
-  CVertex * vb = (pv[0]->id() < pv[2]->id() )?pv[0]:pv[2];
-  std::list<CEdge*> & ledges = (std::list<CEdge*> &) vb->edges();
-
-  //add edge to the edge list of the new vertex
-  CVertex * wb = (pv[1]->id() < pv[3]->id() )?pv[1]:pv[3];
-  std::list<CEdge*> & wedges = (std::list<CEdge*> &) wb->edges();
-
-  for( std::list<CEdge*>::iterator eiter = wedges.begin(); eiter != wedges.end(); eiter ++ )
-  {
-		CEdge * pE = *eiter;
-
-		CVertex * v1 = edgeVertex1( pE );
-		CVertex * v2 = edgeVertex2( pE );
-
-		if(( v1 == pv[0] && v2 == pv[2] ) || (v1 == pv[2] )&& (v2 == pv[0]) )
-		{
-			std::cout << "DynamicMesh::SwapEdge::Warning Two edges share same both end vertices" << std::endl;
-			//return;
-		}
-  }
-
-*/
+  //the edge leaves the edge list of pv[0] or pv[2], in O(1) by its position
+  _unlist_edge( edge );
 
   //relink the vertices
 
@@ -330,11 +414,17 @@ void CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::swapEdge( CEdge * edge )
   ph[4]->target() = pv[0];
   ph[5]->target() = pv[1];
 
-  for( int i = 0; i < 6; i ++ )
+  //the halfedges of the sides turn by one, a vertex follows its halfedge to the one
+  //which takes its place, so a boundary vertex keeps its boundary halfedge
+  CHalfEdge * moved[6] = { ph[4], ph[5], ph[1], ph[1], ph[2], ph[4] };
+  for( int j = 0; j < 4; j ++ )
   {
-	  CHalfEdge * h = ph[i];
-	  CVertex   * v = halfedgeTarget(h);
-	  v->halfedge() = h;
+	  for( int i = 0; i < 6; i ++ )
+	  {
+		  if( pv[j]->halfedge() != ph[i] ) continue;
+		  pv[j]->halfedge() = moved[i];
+		  break;
+	  }
   }
   
   
@@ -351,89 +441,11 @@ void CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::swapEdge( CEdge * edge )
 
   ph[5]->edge() = pe[1];
   pe[1]->halfedge( pi[1] ) = ph[5];
-  
-
-/*
-  //remove edge from edge list of the original vertex
-  std::list<CEdge*>::iterator pos = ledges.end();
-  for( std::list<CEdge*>::iterator eiter = ledges.begin(); eiter != ledges.end(); eiter ++ )
-  {
-		CEdge * pE = *eiter;
-		if( pE == edge ) 
-		{
-			pos = eiter;
-			break;
-		}
-  }
-
-  if( pos == ledges.end() )
-  {
-	  std::cout << "Error" << std::endl;
-  }
-
-  if( pos != ledges.end() )
-	ledges.erase( pos );
 
-  //add edge to the edge list of the new vertex
-  wedges.push_back( edge );
-
-  for(int i = 0; i < 6; i ++ )
-  {
-      CHalfEdge * he = ph[i];
-      CHalfEdge * sh = halfedgeSym( he );
-      assert( he->target() == sh->he_prev()->target() );
-      assert( he->he_prev()->target() == sh->target() );
-  }
-*/
-/*
-  for(int i = 0; i < 6; i ++ )
-  {
-      CHalfEdge * he = ph[i];
-	  CEdge     * pe = halfedgeEdge( he );
-	  CVertex   * v1 = edgeVertex1( pe );
-	  CVertex   * v2 = edgeVertex2( pe );
-	  CEdge     * we = vertexEdge( v1, v2 );
-	  if( pe != we )
-	  {
-		  std::cout << "Error" << std::endl;
-
-		  for( int j = 0; j < 4; j ++ )
-		  {
-			  std::cout << pv[j]->id() << " ";
-		  }
-		  std::cout << std::endl;
-
-		  for( std::list<CEdge*>::iterator eiter = ledges.begin(); eiter != ledges.end(); eiter ++ )
-		  {
-			  CEdge * e = *eiter;
-			  CVertex * v1 = edgeVertex1( e );
-			  CVertex * v2 = edgeVertex2( e );
-			  std::cout << "(" << v1->id() << "," << v2->id() <<")" << std::endl;
-		  }
-
-		  std::cout << " Edge list " << std::endl;
-
-		  for( std::list<CEdge*>::iterator eiter = wedges.begin(); eiter != wedges.end(); eiter ++ )
-		  {
-			  CEdge * e = *eiter;
-			  CVertex * v1 = edgeVertex1( e );
-			  CVertex * v2 = edgeVertex2( e );
-			  std::cout << "(" << v1->id() << "," << v2->id() <<")" << std::endl;
-		  }
-
-		  write_m("test.m");
-	  }
-	  assert( pe == we );
-  }
- 
-  static int id = 0;
-  char name[1024];
-  sprintf(name,"temp_%d.g", id++);
-
-  write_g( name );
- */ 
-  
+  //the edge joins the edge list of pv[1] or pv[3]
+  _list_edge( edge );
 
+  markDirty( edge );
 };
 
 /*---------------------------------------------------------------------------*/
@@ -448,8 +460,7 @@ template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 CVertex * CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::splitEdge( CEdge * pEdge )
 {
 
-	CVertex * pV = createVertex( ++ m_vertex_id );
-
+	CVertex * pV = createVertex( _new_vertex_id() );
 
 	CHalfEdge *  h[12];
 	CHalfEdge *  s[6];
@@ -476,15 +487,19 @@ CVertex * CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::splitEdge( CEdge * pEdge
 		s[i] = halfedgeSym( h[i] );
 	}
 
-	f[2] = new CFace();
+	//the edge gets a new end vertex, it moves in the edge lists
+	_unlist_edge( pEdge );
+
+	f[2] = _new_face();
 	assert( f[2] != NULL );
-	f[2]->id() = ++ m_face_id;
+	f[2]->id() = _new_face_id();
 	m_faces.push_back( f[2] );
+	m_map_face.insert( f[2]->id(), f[2] );
 
 	//create halfedges
 	for(int i = 6; i < 9; i ++ )
 	{
-		h[i] = new CHalfEdge;
+		h[i] = _new_halfedge();
 		assert( h[i] );
 	}
 
@@ -503,15 +518,16 @@ CVertex * CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::splitEdge( CEdge * pEdge
 	}
 
 
-	f[3] = new CFace();
+	f[3] = _new_face();
 	assert( f[3] != NULL );
-	f[3]->id() = ++m_face_id;
+	f[3]->id() = _new_face_id();
 	m_faces.push_back( f[3] );
+	m_map_face.insert( f[3]->id(), f[3] );
 
 	//create halfedges
 	for(int i = 9; i < 12; i ++ )
 	{
-		h[i] = new CHalfEdge;
+		h[i] = _new_halfedge();
 		assert( h[i] );
 	}
 
@@ -533,10 +549,10 @@ CVertex * CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::splitEdge( CEdge * pEdge
 
 	for( int i = 0; i < 3; i ++ )
 	{
-		e[i] = new CEdge();
-		e[i]->id() = ++ m_edge_id;
-		m_edges.push_back( e[i] );
+		e[i] = _new_edge();
 		assert( e[i] );
+		e[i]->id() = _new_edge_id();
+		m_edges.push_back( e[i] );
 	}
 	
 	__attach_halfedge_to_edge(h[2], h[6] , e[0]);
@@ -572,21 +588,652 @@ CVertex * CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::splitEdge( CEdge * pEdge
 	v[4]->halfedge() = h[4];
 	pV->halfedge()   = h[3];
 
+	_list_edge( pEdge );
+	for( int i = 0; i < 3; i ++ ) _list_edge( e[i] );
+
 	for( int k = 0; k < 4; k ++ )
 	{
 		CHalfEdge * pH = faceHalfedge( f[k] );
 		for( int i = 0; i < 3; i ++ )
 		{
-			assert( pH->vertex() == pH->he_sym()->he_prev()->vertex() );
+			assert( pH->he_sym() == NULL || pH->vertex() == pH->he_sym()->he_prev()->vertex() );
 			pH = faceNextCcwHalfEdge( pH );
 		}
 	}
+	markDirty( pV );
 	return pV;	
 
 };
 
 /*---------------------------------------------------------------------------*/
 
+//a vertex of both faces of the edge
+
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+bool CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::collapsible( CEdge * pEdge )
+{
+	CHalfEdge * h[2] = { edgeHalfedge( pEdge, 0 ), edgeHalfedge( pEdge, 1 ) };
+	CVertex   * a = halfedgeTarget( h[0] );
+	CVertex   * b = halfedgeSource( h[0] );
+	if( a == b ) return false;
+	if( h[1] != NULL && a->boundary() && b->boundary() ) return false;
+
+	CVertex * opp[2] = { NULL, NULL };
+	for( int k = 0; k < 2; k ++ )
+	{
+		if( h[k] == NULL ) continue;
+		CHalfEdge * n = halfedgeNext( h[k] );
+		CHalfEdge * p = halfedgePrev( h[k] );
+		//the opposite vertex would be left without a face
+		if( halfedgeSym( n ) == NULL && halfedgeSym( p ) == NULL ) return false;
+		opp[k] = halfedgeTarget( n );
+	}
+
+	std::vector<CHalfEdge*> in;
+	std::vector<CEdge*>     ea, eb;
+	_vertex_ring( a, in, ea );
+	_vertex_ring( b, in, eb );
+
+	int common = 0;
+	for( size_t i = 0; i < ea.size(); i ++ )
+	{
+		CVertex * x = ( edgeVertex1( ea[i] ) == a )? edgeVertex2( ea[i] ) : edgeVertex1( ea[i] );
+		if( x == b ) continue;
+		for( size_t j = 0; j < eb.size(); j ++ )
+		{
+			CVertex * y = ( edgeVertex1( eb[j] ) == b )? edgeVertex2( eb[j] ) : edgeVertex1( eb[j] );
+			if( x != y ) continue;
+			if( x != opp[0] && x != opp[1] ) return false;
+			common ++;
+		}
+	}
+	int faces = ( h[1] != NULL )? 2 : 1;
+	if( common != faces ) return false;
+
+	//a tetrahedron would collapse to a doubled triangle
+	if( faces == 2 && ea.size() == 3 && eb.size() == 3 ) return false;
+	return true;
+};
+
+//b goes to a, in each face of the edge the edge at b is merged into the edge at a
+
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+CVertex * CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::collapseEdge( CEdge * pEdge, CVertex * pV, const CPoint & p, bool sweep )
+{
+	if( !collapsible( pEdge ) ) return NULL;
+
+	CVertex * a = pV;
+	CVertex * b = ( edgeVertex1( pEdge ) == a )? edgeVertex2( pEdge ) : edgeVertex1( pEdge );
+
+	//the vertex data follow the position along the edge
+	CPoint d = b->point() - a->point();
+	double t = ( d * d > 0 )? ( ( p - a->point() ) * d ) / ( d * d ) : 0;
+	t = ( t < 0 )? 0 : ( ( t > 1 )? 1 : t );
+	a->uv()     = traitBlend( a->uv(), b->uv(), t );
+	a->normal() = traitBlend( a->normal(), b->normal(), t );
+	vertexTraits().blend( a->slot(), a->slot(), b->slot(), t );
+	CVertex * ab[2] = { a, b };
+	double    w[2]  = { 1 - t, t };
+	a->_mix( ab, w, 2 );
+	a->point()  = p;
+
+	std::vector<CHalfEdge*> in;
+	std::vector<CEdge*>     edges;
+	_vertex_ring( b, in, edges );
+
+	CHalfEdge * h[2] = { edgeHalfedge( pEdge, 0 ), edgeHalfedge( pEdge, 1 ) };
+	CFace     * f[2] = { NULL, NULL };
+	CEdge     * dead[3] = { pEdge, NULL, NULL };
+	CHalfEdge * ha[2], * hb[2];
+	for( int k = 0; k < 2; k ++ )
+	{
+		if( h[k] == NULL ) continue;
+		f[k] = halfedgeFace( h[k] );
+		CHalfEdge * n = halfedgeNext( h[k] );
+		CHalfEdge * q = halfedgePrev( h[k] );
+		ha[k] = ( halfedgeSource( n ) == a )? n : q;
+		hb[k] = ( ha[k] == n )? q : n;
+		dead[k+1] = halfedgeEdge( hb[k] );
+	}
+
+	//the edge lists are keyed by the end vertices, which change
+	for( size_t i = 0; i < edges.size(); i ++ ) _unlist_edge( edges[i] );
+
+	CHalfEdge * live[8];
+	int         nlive = 0;
+	for( int k = 0; k < 2; k ++ )
+	{
+		if( h[k] == NULL ) continue;
+		CHalfEdge * oa = halfedgeSym( ha[k] );
+		CHalfEdge * ob = halfedgeSym( hb[k] );
+		__attach_halfedge_to_edge( oa, ob, halfedgeEdge( ha[k] ) );
+		if( oa != NULL ) { live[nlive++] = oa; live[nlive++] = halfedgePrev( oa ); }
+		if( ob != NULL ) { live[nlive++] = ob; live[nlive++] = halfedgePrev( ob ); }
+	}
+
+	for( size_t i = 0; i < in.size(); i ++ ) in[i]->vertex() = a;
+	for( size_t i = 0; i < edges.size(); i ++ )
+	{
+		if( edges[i] != dead[0] && edges[i] != dead[1] && edges[i] != dead[2] ) _list_edge( edges[i] );
+	}
+	if( b->boundary() ) a->boundary() = true;
+
+	//the vertices of the faces take a live in-halfedge, the most ccw one on the boundary
+	for( int i = 0; i < nlive; i ++ )
+	{
+		CHalfEdge * start = live[i], * pH = start;
+		while( halfedgeSym( pH ) != NULL )
+		{
+			pH = (CHalfEdge*) pH->ccw_rotate_about_target();
+			if( pH == start ) break;
+		}
+		halfedgeTarget( pH )->halfedge() = pH;
+	}
+
+	for( int k = 0; k < 2; k ++ )
+	{
+		if( f[k] == NULL ) continue;
+		//the face keeps its halfedges until sweep(), it is still in the face list
+		CHalfEdge * q[3] = { h[k], ha[k], hb[k] };
+		for( int i = 0; i < 3; i ++ ) m_removed_halfedges.push_back( q[i] );
+		m_map_face.erase( f[k]->id() );
+		m_removed_faces.push_back( f[k] );
+		m_removed_edges.push_back( dead[k+1] );
+	}
+	m_removed_edges.push_back( pEdge );
+	m_map_vert.erase( b->id() );
+	b->halfedge() = NULL;
+	m_removed_vertices.push_back( b );
+
+	markDirty( a );
+	if( sweep ) this->sweep();
+	return a;
+};
+
+//the dirty lists lose the removed elements too
+
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::sweep()
+{
+	if( m_removed_faces.empty() && m_removed_edges.empty() && m_removed_vertices.empty() ) return;
+
+	std::vector<char> face( faceTraits().size(), 0 ), edge( edgeTraits().size(), 0 ), vertex( vertexTraits().size(), 0 );
+	for( size_t i = 0; i < m_removed_faces.size(); i ++ )    face[m_removed_faces[i]->slot()] = 1;
+	for( size_t i = 0; i < m_removed_edges.size(); i ++ )    edge[m_removed_edges[i]->slot()] = 1;
+	for( size_t i = 0; i < m_removed_vertices.size(); i ++ ) vertex[m_removed_vertices[i]->slot()] = 1;
+
+	for( size_t i = 0; i < m_dirty_faces.size(); )
+	{
+		if( !face[m_dirty_faces[i]->slot()] ) { i ++; continue; }
+		m_face_dirty[m_dirty_faces[i]->slot()] = false;
+		m_dirty_faces[i] = m_dirty_faces.back();
+		m_dirty_faces.pop_back();
+	}
+	for( size_t i = 0; i < m_dirty_edges.size(); )
+	{
+		if( !edge[m_dirty_edges[i]->slot()] ) { i ++; continue; }
+		m_edge_dirty[m_dirty_edges[i]->slot()] = false;
+		m_dirty_edges[i] = m_dirty_edges.back();
+		m_dirty_edges.pop_back();
+	}
+	for( size_t i = 0; i < m_dirty_vertices.size(); )
+	{
+		if( !vertex[m_dirty_vertices[i]->slot()] ) { i ++; continue; }
+		m_vertex_dirty[m_dirty_vertices[i]->slot()] = false;
+		m_dirty_vertices[i] = m_dirty_vertices.back();
+		m_dirty_vertices.pop_back();
+	}
+
+	for( std::list<CFace*>::iterator fiter = m_faces.begin(); fiter != m_faces.end(); )
+	{
+		if( face[(*fiter)->slot()] ) fiter = m_faces.erase( fiter );
+		else ++ fiter;
+	}
+	for( std::list<CEdge*>::iterator eiter = m_edges.begin(); eiter != m_edges.end(); )
+	{
+		if( edge[(*eiter)->slot()] ) eiter = m_edges.erase( eiter );
+		else ++ eiter;
+	}
+	for( std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); )
+	{
+		if( vertex[(*viter)->slot()] ) viter = m_verts.erase( viter );
+		else ++ viter;
+	}
+
+	for( size_t i = 0; i < m_removed_faces.size(); i ++ )    _delete_face( m_removed_faces[i] );
+	for( size_t i = 0; i < m_removed_edges.size(); i ++ )    _delete_edge( m_removed_edges[i] );
+	for( size_t i = 0; i < m_removed_vertices.size(); i ++ ) _delete_vertex( m_removed_vertices[i] );
+	for( size_t i = 0; i < m_removed_halfedges.size(); i ++ ) _delete_halfedge( m_removed_halfedges[i] );
+	m_removed_halfedges.clear();
+	m_removed_faces.clear();
+	m_removed_edges.clear();
+	m_removed_vertices.clear();
+};
+
+//on the boundary the in-halfedges miss the edge of the most clw out-halfedge
+
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::_vertex_ring( CVertex * pV, std::vector<CHalfEdge*> & in, std::vector<CEdge*> & edges )
+{
+	for( VertexInHalfedgeIterator<CVertex,CEdge,CFace,CHalfEdge> vh( this, pV ); !vh.end(); ++ vh )
+	{
+		in.push_back( *vh );
+		edges.push_back( halfedgeEdge( *vh ) );
+	}
+	if( pV->boundary() ) edges.push_back( halfedgeEdge( (CHalfEdge*) pV->most_clw_out_halfedge() ) );
+};
+
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::_unlist_edge( CEdge * pE )
+{
+	CVertex * v1 = edgeVertex1( pE );
+	CVertex * v2 = edgeVertex2( pE );
+	CVertex * pV = ( v1->id() < v2->id() )? v1 : v2;
+	//position() is only valid for a listed edge
+	assert( std::find( pV->edges().begin(), pV->edges().end(), pE ) != pV->edges().end() );
+	pV->edges().erase( pE->position() );
+	if( m_edge_table_active ) m_edge_table.erase( v1->id(), v2->id() );
+};
+
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+int CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::_new_vertex_id()
+{
+	//the counter only goes up, so the ids in use are skipped once in all
+	while( idVertex( ++ m_vertex_id ) != NULL );
+	return m_vertex_id;
+};
+
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+int CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::_new_face_id()
+{
+	while( idFace( ++ m_face_id ) != NULL );
+	return m_face_id;
+};
+
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+int CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::_new_edge_id()
+{
+	//the edges are not in a map, so the largest loaded id is found once, on the first call;
+	//the size of the edge list is no bound after edges have been deleted
+	if( m_edge_id < 0 )
+	{
+		m_edge_id = 0;
+		for( std::list<CEdge*>::iterator eiter = m_edges.begin(); eiter != m_edges.end(); eiter ++ )
+			m_edge_id = std::max( m_edge_id, (*eiter)->id() );
+	}
+	return ++ m_edge_id;
+};
+
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::_list_edge( CEdge * pE )
+{
+	CVertex * v1 = edgeVertex1( pE );
+	CVertex * v2 = edgeVertex2( pE );
+	CVertex * pV = ( v1->id() < v2->id() )? v1 : v2;
+	pV->edges().push_back( pE );
+	pE->position() = -- pV->edges().end();
+	if( m_edge_table_active ) m_edge_table.insert( v1->id(), v2->id(), pE );
+};
+
+/*---------------------------------------------------------------------------*/
+
+//the edges and the faces around the vertex, through its in-halfedges and the next ones
+
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::markDirty( CVertex * pV )
+{
+	for( VertexInHalfedgeIterator<CVertex,CEdge,CFace,CHalfEdge> vh( this, pV ); !vh.end(); ++ vh )
+	{
+		CHalfEdge * pH = *vh;
+		markDirty( halfedgeEdge( pH ) );
+		markDirty( halfedgeEdge( halfedgeNext( pH ) ) );
+	}
+};
+
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::markDirty( CEdge * pE )
+{
+	if( (size_t) pE->slot() >= m_edge_dirty.size() ) m_edge_dirty.resize( edgeTraits().size(), false );
+	if( !m_edge_dirty[pE->slot()] )
+	{
+		m_edge_dirty[pE->slot()] = true;
+		m_dirty_edges.push_back( pE );
+	}
+	for( int i = 0; i < 2; i ++ )
+	{
+		CHalfEdge * pH = edgeHalfedge( pE, i );
+		if( pH != NULL ) markDirty( halfedgeFace( pH ) );
+	}
+};
+
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::markDirty( CFace * pF )
+{
+	if( (size_t) pF->slot() >= m_face_dirty.size() ) m_face_dirty.resize( faceTraits().size(), false );
+	if( m_face_dirty[pF->slot()] ) return;
+	m_face_dirty[pF->slot()] = true;
+	m_dirty_faces.push_back( pF );
+
+	CHalfEdge * pH = faceHalfedge( pF );
+	do{
+		CVertex * pV = halfedgeTarget( pH );
+		if( (size_t) pV->slot() >= m_vertex_dirty.size() ) m_vertex_dirty.resize( vertexTraits().size(), false );
+		if( !m_vertex_dirty[pV->slot()] )
+		{
+			m_vertex_dirty[pV->slot()] = true;
+			m_dirty_vertices.push_back( pV );
+		}
+		pH = halfedgeNext( pH );
+	}while( pH != faceHalfedge( pF ) );
+};
+
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::clearDirty()
+{
+	for( size_t i = 0; i < m_dirty_edges.size(); i ++ ) m_edge_dirty[m_dirty_edges[i]->slot()] = false;
+	for( size_t i = 0; i < m_dirty_faces.size(); i ++ ) m_face_dirty[m_dirty_faces[i]->slot()] = false;
+	for( size_t i = 0; i < m_dirty_vertices.size(); i ++ ) m_vertex_dirty[m_dirty_vertices[i]->slot()] = false;
+	m_dirty_edges.clear();
+	m_dirty_faces.clear();
+	m_dirty_vertices.clear();
+};
+
+//the dirty lists may point to deleted elements, they are rebuilt from the remapped flags
+
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+typename CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::CSlotRemap CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::deleteFaces( const std::vector<CFace*> & dead )
+{
+	std::vector<bool> ring( vertexTraits().size(), false );
+	for( size_t i = 0; i < dead.size(); i ++ )
+	{
+		CHalfEdge * pH = faceHalfedge( dead[i] );
+		for( int k = 0; k < 3; k ++, pH = halfedgeNext( pH ) ) ring[halfedgeTarget( pH )->slot()] = true;
+	}
+	m_dirty_edges.clear();
+	m_dirty_faces.clear();
+	m_dirty_vertices.clear();
+
+	typename CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::CSlotRemap remap = CBaseMesh<CVertex,CEdge,CFace,CHalfEdge>::deleteFaces( dead );
+
+	_remap_flags( m_edge_dirty,   remap.edge,   edgeTraits().size() );
+	_remap_flags( m_face_dirty,   remap.face,   faceTraits().size() );
+	_remap_flags( m_vertex_dirty, remap.vertex, vertexTraits().size() );
+	_remap_flags( ring,           remap.vertex, vertexTraits().size() );
+
+	for( std::list<CEdge*>::iterator eiter = edges().begin(); eiter != edges().end(); eiter ++ )
+		if( m_edge_dirty[(*eiter)->slot()] ) m_dirty_edges.push_back( *eiter );
+	for( std::list<CFace*>::iterator fiter = faces().begin(); fiter != faces().end(); fiter ++ )
+		if( m_face_dirty[(*fiter)->slot()] ) m_dirty_faces.push_back( *fiter );
+	for( std::list<CVertex*>::iterator viter = vertices().begin(); viter != vertices().end(); viter ++ )
+		if( m_vertex_dirty[(*viter)->slot()] ) m_dirty_vertices.push_back( *viter );
+
+	for( std::list<CVertex*>::iterator viter = vertices().begin(); viter != vertices().end(); viter ++ )
+		if( ring[(*viter)->slot()] ) markDirty( *viter );
+	return remap;
+};
+
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::_remap_flags( std::vector<bool> & flags, const std::vector<int> & remap, int n )
+{
+	std::vector<bool> moved( n, false );
+	size_t m = std::min( flags.size(), remap.size() );
+	for( size_t s = 0; s < m; s ++ ) if( flags[s] && remap[s] >= 0 ) moved[remap[s]] = true;
+	flags.swap( moved );
+};
+
+/*---------------------------------------------------------------------------*/
+
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+void CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::subdivide( CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge> & fine, int scheme, int levels, int threads )
+{
+	if( !fine.vertices().empty() || !fine.faces().empty() )
+	{
+		fprintf(stderr,"Error: the mesh to receive the subdivision is not empty\n");
+		return;
+	}
+	if( levels <= 0 )
+	{
+		fprintf(stderr,"Error: the number of subdivision levels %d is not positive\n", levels );
+		return;
+	}
+	threads = parallelThreads( threads );
+
+	//each level is built into a new mesh, the last one into fine
+	CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge> * coarse = this;
+	for( int l = 0; l < levels; l ++ )
+	{
+		CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge> * next = ( l + 1 == levels )? &fine : new CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>;
+		bool done = coarse->_subdivide( *next, scheme, threads );
+		if( coarse != this ) delete coarse;
+		coarse = next;
+		if( done ) continue;
+
+		fprintf(stderr,"Error: only a triangle mesh can be subdivided\n");
+		if( coarse != &fine ) delete coarse;
+		return;
+	}
+};
+
+/*!
+	One level of subdivision. Every vertex of the fine mesh has a mask, its coarse
+	vertices and their weights, laid out in arrays; the masks, the fine points and the
+	halfedges of the fine faces are computed on several threads, only the elements are
+	allocated in order.
+	\param fine    the empty fine mesh
+	\param scheme  LOOP or MIDPOINT
+	\param threads number of threads
+	\return false if a face is not a triangle
+*/
+template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
+bool CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::_subdivide( CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge> & fine, int scheme, int threads )
+{
+	std::vector<CVertex*> verts;
+	verts.reserve( m_verts.size() );
+	for( std::list<CVertex*>::iterator viter = m_verts.begin(); viter != m_verts.end(); viter ++ )
+		if( (*viter)->halfedge() != NULL ) verts.push_back( *viter );
+	std::vector<CEdge*> edges( m_edges.begin(), m_edges.end() );
+	std::vector<CFace*> faces( m_faces.begin(), m_faces.end() );
+
+	for( size_t k = 0; k < faces.size(); k ++ )
+	{
+		CHalfEdge * pH = faceHalfedge( faces[k] );
+		if( halfedgeNext( halfedgeNext( halfedgeNext( pH ) ) ) != pH ) return false;
+	}
+
+	size_t nv = verts.size();
+	size_t ne = edges.size();
+	size_t nf = faces.size();
+
+	//index of the edges by slot, the id of the first edge vertex
+	std::vector<int> edge_index( edgeTraits().size(), -1 );
+	for( size_t k = 0; k < ne; k ++ ) edge_index[ edges[k]->slot() ] = (int) k;
+	int id = 0;
+	for( size_t i = 0; i < nv; i ++ ) id = std::max( id, verts[i]->id() );
+
+	//masks, old vertices first, then the edge vertices in the edge order
+	const bool loop = ( scheme == LOOP );
+	std::vector<size_t> first( nv + ne + 1, 0 );
+	parallelFor( nv, threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ )
+		{
+			if( !loop ) { first[i+1] = 1; continue; }
+			if( verts[i]->boundary() ) { first[i+1] = 3; continue; }
+			size_t n = 0;
+			CHalfEdge * start = vertexMostCcwInHalfEdge( verts[i] ), * pH = start;
+			do{ n ++; pH = halfedgeSym( halfedgeNext( pH ) ); }while( pH != start );
+			first[i+1] = 1 + n;
+		}
+	});
+	parallelFor( ne, threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t k = b; k < e; k ++ ) first[nv+k+1] = ( loop && edgeHalfedge( edges[k], 1 ) != NULL )? 4 : 2;
+	});
+	for( size_t i = 0; i < nv + ne; i ++ ) first[i+1] += first[i];
+
+	std::vector<CVertex*> mask( first[nv+ne] );
+	std::vector<double>   weight( first[nv+ne] );
+	parallelFor( nv, threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ )
+		{
+			size_t s = first[i];
+			mask[s] = verts[i];
+			weight[s] = 1;
+			if( !loop ) continue;
+
+			CHalfEdge * start = vertexMostCcwInHalfEdge( verts[i] ), * pH = start;
+			if( verts[i]->boundary() )
+			{
+				//the two boundary neighbors, at the most ccw in halfedge and at the most clw out halfedge
+				while( halfedgeSym( halfedgeNext( pH ) ) != NULL ) pH = halfedgeSym( halfedgeNext( pH ) );
+				mask[s+1] = halfedgeSource( start );
+				mask[s+2] = halfedgeTarget( halfedgeNext( pH ) );
+				weight[s] = 3.0 / 4.0; weight[s+1] = weight[s+2] = 1.0 / 8.0;
+				continue;
+			}
+
+			size_t n = first[i+1] - s - 1;
+			double c = 3.0 / 8.0 + cos( 2 * 3.14159265358979323846 / n ) / 4;
+			double beta = ( 5.0 / 8.0 - c * c ) / n;
+			weight[s] = 1 - n * beta;
+			for( size_t j = 1; j <= n; j ++ )
+			{
+				mask[s+j] = halfedgeSource( pH );
+				weight[s+j] = beta;
+				pH = halfedgeSym( halfedgeNext( pH ) );
+			}
+		}
+	});
+	parallelFor( ne, threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t k = b; k < e; k ++ )
+		{
+			size_t s = first[nv+k];
+			CHalfEdge * h0 = edgeHalfedge( edges[k], 0 );
+			CHalfEdge * h1 = edgeHalfedge( edges[k], 1 );
+			mask[s]   = halfedgeSource( h0 );
+			mask[s+1] = halfedgeTarget( h0 );
+			weight[s] = weight[s+1] = 1.0 / 2.0;
+			if( first[nv+k+1] - s == 2 ) continue;
+			mask[s+2] = halfedgeTarget( halfedgeNext( h0 ) );
+			mask[s+3] = halfedgeTarget( halfedgeNext( h1 ) );
+			weight[s] = weight[s+1] = 3.0 / 8.0; weight[s+2] = weight[s+3] = 1.0 / 8.0;
+		}
+	});
+
+	//fine vertices and faces, each face is split at its corners and in the middle
+	fine.vertexTraits().copyColumns( vertexTraits() );
+	fine.edgeTraits().copyColumns( edgeTraits() );
+	fine.faceTraits().copyColumns( faceTraits() );
+
+	std::vector<CVertex*> fv( nv + ne );
+	for( size_t i = 0; i < nv; i ++ ) fv[i] = fine.createVertex( verts[i]->id() );
+	for( size_t k = 0; k < ne; k ++ ) fv[nv+k] = fine.createVertex( id + 1 + (int) k );
+
+	std::vector<CFace*> ff( 4 * nf );
+	for( size_t k = 0; k < 4 * nf; k ++ )
+	{
+		CFace * f = fine._new_face();
+		assert( f != NULL );
+		f->id() = (int) k + 1;
+		fine.m_faces.push_back( f );
+		fine.m_map_face.insert( f->id(), f );
+		ff[k] = f;
+	}
+
+	std::vector<size_t>   start( 4 * nf + 1 );
+	std::vector<CVertex*> fverts( 12 * nf );
+	std::vector<int>      vertex_index( vertexTraits().size(), -1 );
+	for( size_t i = 0; i < nv; i ++ ) vertex_index[ verts[i]->slot() ] = (int) i;
+	parallelFor( nf, threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t k = b; k < e; k ++ )
+		{
+			CVertex * c[3];
+			CVertex * m[3];
+			CHalfEdge * pH = faceHalfedge( faces[k] );
+			for( int j = 0; j < 3; j ++ )
+			{
+				c[j] = fv[ vertex_index[ halfedgeSource( pH )->slot() ] ];
+				m[j] = fv[ nv + edge_index[ halfedgeEdge( pH )->slot() ] ];
+				pH = halfedgeNext( pH );
+			}
+			CVertex * child[12] = { c[0], m[0], m[2],  c[1], m[1], m[0],  c[2], m[2], m[1],  m[0], m[1], m[2] };
+			for( int j = 0; j < 12; j ++ ) fverts[12*k+j] = child[j];
+			for( int j = 0; j < 4; j ++ ) start[4*k+j] = 12 * k + 3 * j;
+		}
+	});
+	start[4*nf] = 12 * nf;
+
+	//the edge table is only filled if it is kept after loading
+	std::vector<size_t> edge_first;
+	fine.m_edge_table_active = fine.m_keep_edge_table;
+	fine._create_faces( ff, start, fverts, false, edge_first, threads );
+	fine._finish_m( threads );
+
+	//the geometry and the traits, by the masks
+	parallelFor( nv + ne, threads, [&]( size_t b, size_t e, int )
+	{
+		std::vector<int> slots;
+		for( size_t i = b; i < e; i ++ )
+		{
+			CPoint p, n;
+			CPoint2 uv;
+			slots.clear();
+			for( size_t s = first[i]; s < first[i+1]; s ++ )
+			{
+				p  += mask[s]->point() * weight[s];
+				n  += mask[s]->normal() * weight[s];
+				uv += mask[s]->uv() * weight[s];
+				slots.push_back( mask[s]->slot() );
+			}
+			fv[i]->point() = p;
+			fv[i]->normal() = ( n.norm() > 0 )? n / n.norm() : n;
+			fv[i]->uv() = uv;
+			if( !fine.vertexTraits().empty() ) fine.vertexTraits().mix( fv[i]->slot(), vertexTraits(), &slots[0], &weight[first[i]], (int) slots.size() );
+		}
+	});
+
+	//the hooks may not be thread safe
+	parallelFor( nv + ne, m_parallel_traits ? threads : 1, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ ) fv[i]->_mix( &mask[first[i]], &weight[first[i]], (int)( first[i+1] - first[i] ) );
+	});
+
+	if( !fine.edgeTraits().empty() )
+	{
+		parallelFor( ne, threads, [&]( size_t b, size_t e, int )
+		{
+			const double one = 1;
+			for( size_t k = b; k < e; k ++ )
+			{
+				int slot = edges[k]->slot();
+				CVertex * v1 = fv[ vertex_index[ edgeVertex1( edges[k] )->slot() ] ];
+				CVertex * v2 = fv[ vertex_index[ edgeVertex2( edges[k] )->slot() ] ];
+				fine.edgeTraits().mix( fine.vertexEdge( v1, fv[nv+k] )->slot(), edgeTraits(), &slot, &one, 1 );
+				fine.edgeTraits().mix( fine.vertexEdge( fv[nv+k], v2 )->slot(), edgeTraits(), &slot, &one, 1 );
+			}
+		});
+	}
+
+	if( !fine.faceTraits().empty() )
+	{
+		parallelFor( nf, threads, [&]( size_t b, size_t e, int )
+		{
+			const double one = 1;
+			for( size_t k = b; k < e; k ++ )
+			{
+				int slot = faces[k]->slot();
+				for( int j = 0; j < 4; j ++ ) fine.faceTraits().mix( ff[4*k+j]->slot(), faceTraits(), &slot, &one, 1 );
+			}
+		});
+	}
+	return true;
+};
+
+/*---------------------------------------------------------------------------*/
+
 template<typename CVertex, typename CEdge, typename CFace, typename CHalfEdge>
 void CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::__attach_halfedge_to_edge( CHalfEdge * he0, CHalfEdge * he1, CEdge * e )
 {
@@ -658,10 +1305,10 @@ void CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::read_vef( const char * input )
 			}
 		
 			// create vertex
-			CVertex * v = new CVertex();
+			CVertex * v = _new_vertex();
 			assert( v != NULL );
 			m_verts.push_back( v );
-			m_map_vert.insert( std::pair<int,CVertex*>(id,v));
+			m_map_vert.insert( id, v );
 			v->id() = id;
 			v->point() = p;
 			v->boundary() = false;
@@ -697,7 +1344,7 @@ void CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::read_vef( const char * input )
 			ev[1] = idVertex(vid[1]);
 
 			// create edge 
-			CEdge * e = new CEdge();	assert( e != NULL );
+			CEdge * e = _new_edge();	assert( e != NULL );
 			e->id() = id;
 			m_edges.push_back( e );
 			m_map_edge.insert( std::pair<int,CEdge*>(id,e));
@@ -706,7 +1353,7 @@ void CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::read_vef( const char * input )
 			CHalfEdge * he[2];
 			for (int k=0; k<2; k++)
 			{
-				he[k] = new CHalfEdge();	assert(he[k]);
+				he[k] = _new_halfedge();	assert(he[k]);
 				he[k]->vertex() = ev[1-k];
 				he[k]->edge() = e;
 				he[k]->face() = NULL;
@@ -746,11 +1393,11 @@ void CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::read_vef( const char * input )
 			}
 
 			// create face & link he
-			CFace * f = new CFace();
+			CFace * f = _new_face();
 			assert( f != NULL );
 			f->id() = id;
 			m_faces.push_back( f );
-			m_map_face.insert( std::pair<int,tFace>(id,f) );
+			m_map_face.insert( id, f );
 			size_t	nhe = f_he.size();
 			for ( size_t k=0; k<nhe; k++)
 			{
@@ -810,7 +1457,7 @@ void CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::read_vef( const char * input )
 		{
 			if ( NULL == e->halfedge(k)->face() )
 			{
-				delete e->halfedge(k);
+				_delete_halfedge( (CHalfEdge*) e->halfedge(k) );
 				e->halfedge(k) = NULL;
 			}
 		}
@@ -848,7 +1495,13 @@ void CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::read_vef( const char * input )
 	{
 		tEdge e = *eiter;
 		m_edges.remove( e );
-		delete e;
+		_delete_edge( e );
+	}
+
+	//list the edges at their end vertices, the edits take them out by position()
+	for( std::list<tEdge>::iterator eiter = m_edges.begin(); eiter != m_edges.end(); ++ eiter )
+	{
+		_list_edge( *eiter );
 	}
 
 	// check vertex: remove singular v
@@ -863,7 +1516,8 @@ void CDynamicMesh<CVertex,CEdge,CFace,CHalfEdge>::read_vef( const char * input )
 	{
 		tVertex v = *viter;
 		m_verts.remove( v );
-		delete v;
+		m_map_vert.erase( v->id() );
+		_delete_vertex( v );
 	}
 
 	//Arrange the boundary half_edge of boundary vertices, to make its halfedge to be the most ccw in half_edge
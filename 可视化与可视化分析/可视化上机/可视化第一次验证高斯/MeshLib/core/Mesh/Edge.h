@@ -14,6 +14,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string>
+#include <list>
 
 namespace MeshLib{
 
@@ -29,7 +30,7 @@ public:
 	/*!
 		CEdge constructor, set both halfedge pointers to be NULL.
 	*/
-	CEdge(){ m_halfedge[0] = NULL; m_halfedge[1] = NULL; };
+	CEdge(){ m_halfedge[0] = NULL; m_halfedge[1] = NULL; m_slot = -1; };
 	/*!
 		CEdge destructor.
 	*/
@@ -38,6 +39,10 @@ public:
 		Edge ID
 	 */
 	int & id() { return m_id; };
+	/*!
+		Row of the edge in the trait columns of the mesh
+	 */
+	int & slot() { return m_slot; };
 
 	/*!
 		The halfedge attached to the current edge
@@ -55,16 +60,21 @@ public:
 		\return the other halfedge attached to the current edge
 	*/
 	CHalfEdge * & other( CHalfEdge * he ) { return (he != m_halfedge[0] )?m_halfedge[0]:m_halfedge[1]; };
+	/*!
+		Position of the edge in the edge list of its end vertex with the smaller id,
+		so that the edge is taken out of the list in O(1)
+	*/
+	std::list<CEdge*>::iterator & position() { return m_position; };
     /*!
 		The string of the current edge.
 	*/
 	std::string & string() { return m_string; };
 	/*!
-		Read the traits from the string.
+		Read the traits from the string, see CBaseMesh::m_parallel_traits.
 	*/
 	void _from_string() {};
 	/*!
-		Save the traits to the string.
+		Save the traits to the string, see CBaseMesh::m_parallel_traits.
 	*/
 	void _to_string() {};
 protected:
@@ -80,6 +90,14 @@ protected:
 		Edge ID
 	 */
 	int				 m_id;
+	/*!
+		Row in the trait columns
+	 */
+	int				 m_slot;
+	/*!
+		Position in the edge list of the end vertex with the smaller id
+	 */
+	std::list<CEdge*>::iterator m_position;
 };
 
 
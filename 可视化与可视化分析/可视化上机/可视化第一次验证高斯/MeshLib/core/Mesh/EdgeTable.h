@@ -0,0 +1,195 @@
+/*!
+*      \file EdgeTable.h
+*      \brief Hash table between the end vertex ids of an edge and the edge
+*
+*		Open addressing with linear probing, the key is the (min id, max id) pair of the
+*		two end vertices packed into 64 bits.
+*/
+
+#ifndef _MESHLIB_EDGE_TABLE_H_
+#define _MESHLIB_EDGE_TABLE_H_
+
+#include <assert.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace MeshLib{
+
+/*!
+*	\brief CEdgeTable, find an edge by its two end vertex ids in O(1)
+*	\tparam CEdge edge class
+*/
+template<typename CEdge>
+class CEdgeTable
+{
+public:
+	/*! CEdgeTable constructor */
+	CEdgeTable() { m_count = 0; };
+	/*! CEdgeTable destructor */
+	~CEdgeTable(){};
+
+	/*!
+	Find the edge connecting two vertices.
+	\param id0 id of one end vertex
+	\param id1 id of the other end vertex
+	\return the edge, NULL if there is no such an edge
+	*/
+	CEdge * find( int id0, int id1 );
+	/*!
+	Insert an edge, the key should not be in the table.
+	\param id0 id of one end vertex
+	\param id1 id of the other end vertex
+	\param e   the edge
+	*/
+	void insert( int id0, int id1, CEdge * e );
+	/*!
+	Remove an edge.
+	\return false if there is no such an edge
+	*/
+	bool erase( int id0, int id1 );
+	/*! Prepare the table for n edges */
+	void reserve( size_t n );
+	/*! Remove all the edges and release the memory */
+	void clear();
+	/*! Number of edges in the table */
+	size_t size() { return m_count; };
+
+	/*! pack the ordered pair (min id, max id) into 64 bits */
+	static unsigned long long pack( int id0, int id1 )
+	{
+		unsigned int a = (unsigned int)( id0 < id1 ? id0 : id1 );
+		unsigned int b = (unsigned int)( id0 < id1 ? id1 : id0 );
+		return ( (unsigned long long) a << 32 ) | b;
+	};
+
+protected:
+	/*! home slot of a key */
+	size_t _slot( unsigned long long key )
+	{
+		key *= 0x9E3779B97F4A7C15ull;
+		return (size_t)( key >> 32 ) & ( m_keys.size() - 1 );
+	};
+	/*! grow the table to size slots, size is a power of 2 */
+	void _rehash( size_t size );
+
+	/*! keys of the slots */
+	std::vector<unsigned long long>	m_keys;
+	/*! edges of the slots, NULL for an empty slot */
+	std::vector<CEdge*>				m_vals;
+	/*! number of edges */
+	size_t							m_count;
+};
+
+template<typename CEdge>
+inline CEdge * CEdgeTable<CEdge>::find( int id0, int id1 )
+{
+	if( m_count == 0 ) return NULL;
+
+	unsigned long long key = pack( id0, id1 );
+	size_t mask = m_keys.size() - 1;
+	size_t s = _slot( key );
+	while( m_vals[s] != NULL )
+	{
+		if( m_keys[s] == key ) return m_vals[s];
+		s = ( s + 1 ) & mask;
+	}
+	return NULL;
+};
+
+template<typename CEdge>
+void CEdgeTable<CEdge>::insert( int id0, int id1, CEdge * e )
+{
+	assert( e != NULL );
+	//keep the load factor below 1/2
+	if( 2 * ( m_count + 1 ) > m_keys.size() )
+	{
+		_rehash( m_keys.empty() ? 64 : 2 * m_keys.size() );
+	}
+
+	unsigned long long key = pack( id0, id1 );
+	size_t mask = m_keys.size() - 1;
+	size_t s = _slot( key );
+	while( m_vals[s] != NULL )
+	{
+		assert( m_keys[s] != key );
+		s = ( s + 1 ) & mask;
+	}
+	m_keys[s] = key;
+	m_vals[s] = e;
+	m_count ++;
+};
+
+/*!
+	Backward shift deletion, no tombstone is left in the table.
+*/
+template<typename CEdge>
+bool CEdgeTable<CEdge>::erase( int id0, int id1 )
+{
+	if( m_count == 0 ) return false;
+
+	unsigned long long key = pack( id0, id1 );
+	size_t mask = m_keys.size() - 1;
+	size_t s = _slot( key );
+	while( m_vals[s] != NULL && m_keys[s] != key ) s = ( s + 1 ) & mask;
+	if( m_vals[s] == NULL ) return false;
+
+	//move the following entries of the cluster back, if the hole lies between their home slot and them
+	size_t hole = s;
+	size_t t = ( s + 1 ) & mask;
+	while( m_vals[t] != NULL )
+	{
+		size_t home = _slot( m_keys[t] );
+		if( ( ( t - home ) & mask ) >= ( ( t - hole ) & mask ) )
+		{
+			m_keys[hole] = m_keys[t];
+			m_vals[hole] = m_vals[t];
+			hole = t;
+		}
+		t = ( t + 1 ) & mask;
+	}
+	m_vals[hole] = NULL;
+	m_count --;
+	return true;
+};
+
+template<typename CEdge>
+void CEdgeTable<CEdge>::reserve( size_t n )
+{
+	size_t size = 64;
+	while( size < 2 * n ) size *= 2;
+	if( size > m_keys.size() ) _rehash( size );
+};
+
+template<typename CEdge>
+void CEdgeTable<CEdge>::clear()
+{
+	std::vector<unsigned long long>().swap( m_keys );
+	std::vector<CEdge*>().swap( m_vals );
+	m_count = 0;
+};
+
+template<typename CEdge>
+void CEdgeTable<CEdge>::_rehash( size_t size )
+{
+	std::vector<unsigned long long> keys;
+	std::vector<CEdge*>             vals;
+	keys.swap( m_keys );
+	vals.swap( m_vals );
+
+	m_keys.assign( size, 0 );
+	m_vals.assign( size, (CEdge*) NULL );
+
+	size_t mask = size - 1;
+	for( size_t i = 0; i < keys.size(); i ++ )
+	{
+		if( vals[i] == NULL ) continue;
+		size_t s = _slot( keys[i] );
+		while( m_vals[s] != NULL ) s = ( s + 1 ) & mask;
+		m_keys[s] = keys[i];
+		m_vals[s] = vals[i];
+	}
+};
+
+}//name space MeshLib
+
+#endif //_MESHLIB_EDGE_TABLE_H_ defined
@@ -27,7 +27,7 @@ public:
 	/*!	
 	CFace constructor
 	*/
-	CFace(){ m_halfedge = NULL; };
+	CFace(){ m_halfedge = NULL; m_slot = -1; };
 	/*!
 	CFace destructor
 	*/
@@ -44,16 +44,20 @@ public:
 		The value of the current face id.
 	*/
 	const int             id() const { return m_id;      };
+	/*!
+		Row of the current face in the trait columns of the mesh.
+	*/
+	int		            & slot()        { return m_slot;    };
 	/*!
 		The string of the current face.
 	*/
 	std::string			& string()     { return m_string; };
 	/*!
-		Convert face traits to the string.
+		Convert face traits to the string, see CBaseMesh::m_parallel_traits.
 	*/
 	void                  _to_string()   {};
 	/*!
-		read face traits from the string.
+		read face traits from the string, see CBaseMesh::m_parallel_traits.
 	*/
 	void                  _from_string() {};
 protected:
@@ -61,6 +65,10 @@ protected:
 		id of the current face
 	*/
 	int			       m_id;
+	/*!
+		row in the trait columns
+	*/
+	int			       m_slot;
 	/*!
 		One halfedge  attaching to the current face.
 	*/
@@ -29,7 +29,7 @@ public:
 
 	/*!	Constructor, initialize all pointers to be NULL.
 	*/
-	CHalfEdge(){ m_edge = NULL; m_vertex = NULL; m_prev = NULL; m_next = NULL; m_face = NULL; };
+	CHalfEdge(){ m_edge = NULL; m_vertex = NULL; m_prev = NULL; m_next = NULL; m_face = NULL; m_slot = -1; };
 	/*!	Destructure.
 	*/
 	~CHalfEdge(){};
@@ -68,9 +68,11 @@ public:
 	CHalfEdge *   clw_rotate_about_source();
 	/*! String of the current halfedge. */
 	std::string & string() { return m_string; };
-	/*! Convert the traits to string. */
+	/*! Row of the current halfedge in the trait columns of the mesh. */
+	int & slot() { return m_slot; };
+	/*! Convert the traits to string, see CBaseMesh::m_parallel_traits. */
 	void _to_string()   {};
-	/*! Read traits from string. */
+	/*! Read traits from string, see CBaseMesh::m_parallel_traits. */
 	void _from_string() {};
 
 protected:
@@ -86,6 +88,8 @@ protected:
 	CHalfEdge	*     m_next;
 	/*! The string of the current halfedge. */
 	std::string       m_string;
+	/*! Row in the trait columns. */
+	int               m_slot;
 };
 
 //roate the halfedge about its target vertex CCWly
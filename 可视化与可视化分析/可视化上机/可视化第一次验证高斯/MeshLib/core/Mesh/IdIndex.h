@@ -0,0 +1,227 @@
+/*!
+*      \file IdIndex.h
+*      \brief Lookup table between element ids and element pointers
+*
+*		Dense ids are stored in a vector indexed by the id, sparse or negative ids
+*		fall back to an open addressing hash table.
+*/
+
+#ifndef _MESHLIB_ID_INDEX_H_
+#define _MESHLIB_ID_INDEX_H_
+
+#include <assert.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace MeshLib{
+
+/*!
+*	\brief CIdIndex, map between element id and element pointer, O(1) access
+*
+*	An id goes to the dense vector if it is non-negative and not much larger than the
+*	number of elements, otherwise to the hash table. find() never inserts, a missing id
+*	returns NULL.
+*	\tparam T element class
+*/
+template<typename T>
+class CIdIndex
+{
+public:
+	/*! CIdIndex constructor */
+	CIdIndex() { m_count = 0; m_hash_count = 0; m_hash_used = 0; };
+	/*! CIdIndex destructor */
+	~CIdIndex(){};
+
+	/*!
+	Insert an element.
+	\param id element id
+	\param p  element pointer, not NULL
+	\return false if the id is already in the index, the old element is kept
+	*/
+	bool insert( int id, T * p );
+	/*!
+	Find an element by its id.
+	\param id element id
+	\return the element, NULL if the id is missing
+	*/
+	T *  find( int id );
+	/*!
+	Remove an id.
+	\return false if the id is missing
+	*/
+	bool erase( int id );
+	/*! Remove all the ids */
+	void clear();
+	/*! Prepare the dense vector for ids 0 ... n */
+	void reserve( int n )	{ if( n >= (int) m_dense.size() ) m_dense.resize( n + 1, (T*) NULL ); };
+	/*! Number of ids in the index */
+	size_t size()			{ return m_count; };
+
+protected:
+	/*! whether an id should be stored in the dense vector */
+	bool _dense( int id );
+	/*! hash slot of an id */
+	size_t _slot( int id )	{ return ( (unsigned int) id * 2654435761u ) & ( m_hash_keys.size() - 1 ); };
+	/*! grow the hash table and rehash */
+	void _rehash( size_t size );
+
+	/*! slot state of the hash table */
+	enum { SLOT_EMPTY = 0, SLOT_FULL = 1, SLOT_DELETED = 2 };
+
+	/*! elements with dense ids, indexed by id */
+	std::vector<T*>				m_dense;
+	/*! hash table keys */
+	std::vector<int>			m_hash_keys;
+	/*! hash table values */
+	std::vector<T*>				m_hash_vals;
+	/*! hash table slot states */
+	std::vector<unsigned char>	m_hash_state;
+	/*! number of ids in the index */
+	size_t						m_count;
+	/*! number of full slots in the hash table */
+	size_t						m_hash_count;
+	/*! number of full or deleted slots in the hash table */
+	size_t						m_hash_used;
+};
+
+/*!
+	Dense ids are within 2 * (number of elements) + 1024, so the vector wastes at most a constant factor.
+*/
+template<typename T>
+inline bool CIdIndex<T>::_dense( int id )
+{
+	if( id < 0 ) return false;
+	if( id < (int) m_dense.size() ) return true;
+	return (size_t) id < 2 * m_count + 1024;
+};
+
+template<typename T>
+bool CIdIndex<T>::insert( int id, T * p )
+{
+	assert( p != NULL );
+
+	if( _dense( id ) )
+	{
+		if( id >= (int) m_dense.size() )
+		{
+			size_t size = 2 * m_dense.size();
+			if( size < (size_t) id + 1 ) size = (size_t) id + 1;
+			m_dense.resize( size, (T*) NULL );
+		}
+		if( m_dense[id] != NULL ) return false;
+		//the id may have entered the hash table before the vector grew
+		if( m_hash_count > 0 && find( id ) != NULL ) return false;
+		m_dense[id] = p;
+		m_count ++;
+		return true;
+	}
+
+	if( find( id ) != NULL ) return false;
+
+	if( 2 * ( m_hash_used + 1 ) > m_hash_keys.size() )
+	{
+		size_t size = 16;
+		while( size < 4 * ( m_hash_count + 1 ) ) size *= 2;
+		_rehash( size );
+	}
+
+	size_t mask = m_hash_keys.size() - 1;
+	size_t s = _slot( id );
+	while( m_hash_state[s] == SLOT_FULL ) s = ( s + 1 ) & mask;
+
+	if( m_hash_state[s] == SLOT_EMPTY ) m_hash_used ++;
+	m_hash_keys[s]  = id;
+	m_hash_vals[s]  = p;
+	m_hash_state[s] = SLOT_FULL;
+	m_hash_count ++;
+	m_count ++;
+	return true;
+};
+
+template<typename T>
+inline T * CIdIndex<T>::find( int id )
+{
+	if( id >= 0 && id < (int) m_dense.size() && m_dense[id] != NULL ) return m_dense[id];
+	if( m_hash_count == 0 ) return NULL;
+
+	size_t mask = m_hash_keys.size() - 1;
+	size_t s = _slot( id );
+	while( m_hash_state[s] != SLOT_EMPTY )
+	{
+		if( m_hash_state[s] == SLOT_FULL && m_hash_keys[s] == id ) return m_hash_vals[s];
+		s = ( s + 1 ) & mask;
+	}
+	return NULL;
+};
+
+template<typename T>
+bool CIdIndex<T>::erase( int id )
+{
+	if( id >= 0 && id < (int) m_dense.size() && m_dense[id] != NULL )
+	{
+		m_dense[id] = NULL;
+		m_count --;
+		return true;
+	}
+	if( m_hash_count == 0 ) return false;
+
+	size_t mask = m_hash_keys.size() - 1;
+	size_t s = _slot( id );
+	while( m_hash_state[s] != SLOT_EMPTY )
+	{
+		if( m_hash_state[s] == SLOT_FULL && m_hash_keys[s] == id )
+		{
+			m_hash_state[s] = SLOT_DELETED;
+			m_hash_vals[s]  = NULL;
+			m_hash_count --;
+			m_count --;
+			return true;
+		}
+		s = ( s + 1 ) & mask;
+	}
+	return false;
+};
+
+template<typename T>
+void CIdIndex<T>::clear()
+{
+	m_dense.clear();
+	m_hash_keys.clear();
+	m_hash_vals.clear();
+	m_hash_state.clear();
+	m_count = 0;
+	m_hash_count = 0;
+	m_hash_used = 0;
+};
+
+template<typename T>
+void CIdIndex<T>::_rehash( size_t size )
+{
+	std::vector<int>			keys;
+	std::vector<T*>				vals;
+	std::vector<unsigned char>	state;
+
+	keys.swap( m_hash_keys );
+	vals.swap( m_hash_vals );
+	state.swap( m_hash_state );
+
+	m_hash_keys.assign( size, 0 );
+	m_hash_vals.assign( size, (T*) NULL );
+	m_hash_state.assign( size, (unsigned char) SLOT_EMPTY );
+	m_hash_used = m_hash_count;
+
+	size_t mask = size - 1;
+	for( size_t i = 0; i < keys.size(); i ++ )
+	{
+		if( state[i] != SLOT_FULL ) continue;
+		size_t s = _slot( keys[i] );
+		while( m_hash_state[s] == SLOT_FULL ) s = ( s + 1 ) & mask;
+		m_hash_keys[s]  = keys[i];
+		m_hash_vals[s]  = vals[i];
+		m_hash_state[s] = SLOT_FULL;
+	}
+};
+
+}//name space MeshLib
+
+#endif //_MESHLIB_ID_INDEX_H_ defined
@@ -0,0 +1,1026 @@
+/*!
+*      \file IndexMesh.h
+*      \brief Index based mesh kernel, the connectivity is stored in contiguous arrays
+*
+*		The vertices, halfedges, edges and faces are addressed by 32 bit handles, every
+*		attribute is stored in its own array (structure of arrays). The proxy classes
+*		CIndexVertex, CIndexHalfEdge, CIndexEdge and CIndexFace offer the same interface
+*		as CVertex, CHalfEdge, CEdge and CFace, so that the algorithms written for
+*		CBaseMesh can run on CIndexMesh through the usual iterators.
+*/
+
+#ifndef _MESHLIB_INDEX_MESH_H_
+#define _MESHLIB_INDEX_MESH_H_
+
+#include <assert.h>
+#include <stdio.h>
+#include <fstream>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+#include "../Geometry/Point.h"
+#include "../Geometry/Point2.h"
+#include "../Parser/StrUtil.h"
+#include "iterators.h"
+
+namespace MeshLib{
+
+/*! 32 bit handle of a geometric primitive in CIndexMesh */
+typedef unsigned int tIndex;
+/*! invalid handle, plays the role of NULL */
+const tIndex INDEX_NULL = 0xFFFFFFFF;
+
+class CIndexMesh;
+class CIndexVertex;
+class CIndexHalfEdge;
+class CIndexEdge;
+class CIndexFace;
+
+/*!
+*	\brief CIndexVertex, proxy of a vertex in CIndexMesh
+*
+*	The proxy only stores the pointer to the mesh, its handle is its position in the proxy array.
+*/
+class CIndexVertex
+{
+public:
+	/*! handle of the vertex */
+	tIndex index();
+	/*! The point of the vertex */
+	CPoint & point();
+	/*! The normal of the vertex */
+	CPoint & normal();
+	/*! The texture coordinates of the vertex */
+	CPoint2 & uv();
+	/*! Vertex id */
+	int & id();
+	/*! Whether the vertex is on the boundary */
+	bool boundary();
+	/*! The most ccw incoming halfedge of the vertex */
+	CIndexHalfEdge * halfedge();
+	/*! The most counter clockwise outgoing halfedge of the vertex */
+	CIndexHalfEdge * most_ccw_out_halfedge();
+	/*! The most clockwise outgoing halfedge of the vertex */
+	CIndexHalfEdge * most_clw_out_halfedge();
+	/*! The most counter clockwise incoming halfedge of the vertex */
+	CIndexHalfEdge * most_ccw_in_halfedge();
+	/*! The most clockwise incoming halfedge of the vertex */
+	CIndexHalfEdge * most_clw_in_halfedge();
+protected:
+	friend class CIndexMesh;
+	/*! The mesh owning the vertex */
+	CIndexMesh * m_pMesh;
+};
+
+/*!
+*	\brief CIndexHalfEdge, proxy of a halfedge in CIndexMesh
+*/
+class CIndexHalfEdge
+{
+public:
+	/*! handle of the halfedge */
+	tIndex index();
+	/*! Edge of the halfedge */
+	CIndexEdge * edge();
+	/*! Target vertex of the halfedge */
+	CIndexVertex * vertex();
+	/*! Target vertex of the halfedge */
+	CIndexVertex * target();
+	/*! Source vertex of the halfedge */
+	CIndexVertex * source();
+	/*! Previous halfedge in the same face */
+	CIndexHalfEdge * he_prev();
+	/*! Next halfedge in the same face */
+	CIndexHalfEdge * he_next();
+	/*! The dual halfedge, NULL on the boundary */
+	CIndexHalfEdge * he_sym();
+	/*! The face of the halfedge */
+	CIndexFace * face();
+	/*! Rotate the halfedge about the target vertex ccwly */
+	CIndexHalfEdge * ccw_rotate_about_target();
+	/*! Rotate the halfedge about the target vertex clwly */
+	CIndexHalfEdge * clw_rotate_about_target();
+	/*! Rotate the halfedge about the source vertex ccwly */
+	CIndexHalfEdge * ccw_rotate_about_source();
+	/*! Rotate the halfedge about the source vertex clwly */
+	CIndexHalfEdge * clw_rotate_about_source();
+protected:
+	friend class CIndexMesh;
+	/*! The mesh owning the halfedge */
+	CIndexMesh * m_pMesh;
+};
+
+/*!
+*	\brief CIndexEdge, proxy of an edge in CIndexMesh
+*/
+class CIndexEdge
+{
+public:
+	/*! handle of the edge */
+	tIndex index();
+	/*! Edge id */
+	int id();
+	/*! The halfedge attached to the edge
+		\param id either 0 or 1
+	*/
+	CIndexHalfEdge * halfedge( int id );
+	/*! whether the edge is on the boundary */
+	bool boundary();
+	/*! The dual halfedge to the input halfedge */
+	CIndexHalfEdge * other( CIndexHalfEdge * he );
+protected:
+	friend class CIndexMesh;
+	/*! The mesh owning the edge */
+	CIndexMesh * m_pMesh;
+};
+
+/*!
+*	\brief CIndexFace, proxy of a face in CIndexMesh
+*/
+class CIndexFace
+{
+public:
+	/*! handle of the face */
+	tIndex index();
+	/*! Face id */
+	int & id();
+	/*! One halfedge of the face */
+	CIndexHalfEdge * halfedge();
+protected:
+	friend class CIndexMesh;
+	/*! The mesh owning the face */
+	CIndexMesh * m_pMesh;
+};
+
+/*!
+* \brief CIndexMesh, index based mesh kernel
+*
+*  All the geometric primitives are addressed by 32 bit handles. Positions, normals, uvs and
+*  the halfedge next/prev/sym/vertex/face/edge relations are stored in contiguous arrays, which
+*  are traversed without pointer chasing. The boundary halfedges are not stored, he_sym of a
+*  boundary halfedge is INDEX_NULL, the same convention as CBaseMesh. The halfedge of a
+*  boundary vertex is its most ccw in halfedge.
+*
+*  Two interfaces are offered:
+*  - handle interface, he_next( tIndex ), v_point( tIndex ) etc. for the performance critical loops;
+*  - pointer interface, the CBaseMesh member functions and the iterators, working on the proxies.
+*/
+class CIndexMesh
+{
+public:
+	typedef CIndexVertex	CVertex;
+	typedef CIndexEdge		CEdge;
+	typedef CIndexFace		CFace;
+	typedef CIndexHalfEdge	CHalfEdge;
+
+	typedef CIndexVertex   * tVertex;
+	typedef CIndexHalfEdge * tHalfEdge;
+	typedef CIndexEdge     * tEdge;
+	typedef CIndexFace     * tFace;
+
+	/*! vertex flag, the vertex is on the boundary */
+	static const unsigned char VERTEX_BOUNDARY = 1;
+
+	/*! CIndexMesh constructor */
+	CIndexMesh(){};
+	/*! CIndexMesh destructor */
+	~CIndexMesh(){};
+
+	/*!
+	Build the mesh from a face soup.
+	\param ids     vertex ids
+	\param points  vertex positions
+	\param fids    face ids
+	\param fstart  face i uses fverts[fstart[i]] ... fverts[fstart[i+1]-1], fstart has size #faces+1
+	\param fverts  vertex ids of the faces, ccw ordered
+	\param remap   if not NULL, the handle of each input vertex, INDEX_NULL for a vertex without a face
+	*/
+	void build( const std::vector<int> & ids, const std::vector<CPoint> & points,
+				const std::vector<int> & fids, const std::vector<tIndex> & fstart, const std::vector<int> & fverts,
+				std::vector<tIndex> * remap = NULL );
+	/*!
+	Copy the vertices and faces of a pointer based mesh, the traversal order is kept.
+	\param pMesh the input mesh, CBaseMesh or its derived class
+	*/
+	template<typename M>
+	void copy( M * pMesh );
+	/*!
+	Read an .m file, only the vertex positions, uv=() and normal=() traits and the faces are loaded.
+	\param input the input .m file name
+	*/
+	void read_m( const char * input );
+
+	//handle interface
+	/*! number of halfedges */
+	tIndex numHalfEdges()							{ return (tIndex) m_he_next.size(); };
+	/*! next halfedge */
+	tIndex he_next( tIndex he )						{ return m_he_next[he]; };
+	/*! previous halfedge */
+	tIndex he_prev( tIndex he )						{ return m_he_prev[he]; };
+	/*! dual halfedge, INDEX_NULL for boundary halfedges */
+	tIndex he_sym( tIndex he )						{ return m_he_sym[he]; };
+	/*! target vertex */
+	tIndex he_target( tIndex he )					{ return m_he_vert[he]; };
+	/*! source vertex */
+	tIndex he_source( tIndex he )					{ return m_he_vert[m_he_prev[he]]; };
+	/*! attaching face */
+	tIndex he_face( tIndex he )						{ return m_he_face[he]; };
+	/*! attaching edge */
+	tIndex he_edge( tIndex he )						{ return m_he_edge[he]; };
+	/*! ccw rotation about the target vertex, INDEX_NULL at the boundary */
+	tIndex he_ccw_rotate_about_target( tIndex he )	{ tIndex s = m_he_sym[he]; return ( s == INDEX_NULL )? INDEX_NULL : m_he_prev[s]; };
+	/*! clw rotation about the target vertex, INDEX_NULL at the boundary */
+	tIndex he_clw_rotate_about_target( tIndex he )	{ return m_he_sym[m_he_next[he]]; };
+	/*! ccw rotation about the source vertex, INDEX_NULL at the boundary */
+	tIndex he_ccw_rotate_about_source( tIndex he )	{ return m_he_sym[m_he_prev[he]]; };
+	/*! clw rotation about the source vertex, INDEX_NULL at the boundary */
+	tIndex he_clw_rotate_about_source( tIndex he )	{ tIndex s = m_he_sym[he]; return ( s == INDEX_NULL )? INDEX_NULL : m_he_next[s]; };
+	/*! most ccw in halfedge of a vertex */
+	tIndex v_halfedge( tIndex v )					{ return m_v_he[v]; };
+	/*! position of a vertex */
+	CPoint & v_point( tIndex v )					{ return m_v_point[v]; };
+	/*! whether a vertex is on the boundary */
+	bool v_boundary( tIndex v )						{ return ( m_v_flag[v] & VERTEX_BOUNDARY ) != 0; };
+	/*! halfedge[i] of an edge */
+	tIndex e_halfedge( tIndex e, int i )			{ return ( i == 0 )? m_e_he[e] : m_he_sym[m_e_he[e]]; };
+	/*! one halfedge of a face */
+	tIndex f_halfedge( tIndex f )					{ return m_f_he[f]; };
+	/*! length of an edge */
+	double e_length( tIndex e )						{ tIndex h = m_e_he[e]; return ( m_v_point[m_he_vert[h]] - m_v_point[m_he_vert[m_he_prev[h]]] ).norm(); };
+
+	//handle <-> proxy
+	/*! vertex proxy of a handle */
+	tVertex   indexVertex( tIndex v )	{ return ( v == INDEX_NULL )? NULL : &m_v_obj[v]; };
+	/*! halfedge proxy of a handle */
+	tHalfEdge indexHalfEdge( tIndex h )	{ return ( h == INDEX_NULL )? NULL : &m_he_obj[h]; };
+	/*! edge proxy of a handle */
+	tEdge     indexEdge( tIndex e )		{ return ( e == INDEX_NULL )? NULL : &m_e_obj[e]; };
+	/*! face proxy of a handle */
+	tFace     indexFace( tIndex f )		{ return ( f == INDEX_NULL )? NULL : &m_f_obj[f]; };
+
+	//pointer interface, the same as CBaseMesh
+	/*! number of vertices */
+	int  numVertices()	{ return (int) m_v_point.size(); };
+	/*! number of edges */
+	int  numEdges()		{ return (int) m_e_he.size(); };
+	/*! number of faces */
+	int  numFaces()		{ return (int) m_f_he.size(); };
+
+	/*! whether a vertex is on the boundary */
+	bool isBoundary( tVertex v )		{ return v_boundary( v->index() ); };
+	/*! whether an edge is on the boundary */
+	bool isBoundary( tEdge e )			{ return m_he_sym[m_e_he[e->index()]] == INDEX_NULL; };
+	/*! whether a halfedge is on the boundary */
+	bool isBoundary( tHalfEdge he )		{ return m_he_sym[he->index()] == INDEX_NULL; };
+
+	/*! Access a vertex by its id, NULL if there is no such a vertex */
+	tVertex idVertex( int id );
+	/*! The vertex id */
+	int     vertexId( tVertex v )		{ return v->id(); };
+	/*! Access a face by its id, NULL if there is no such a face */
+	tFace   idFace( int id );
+	/*! The face id */
+	int     faceId( tFace f )			{ return f->id(); };
+	/*! Access an edge by its two end vertices, NULL if no such edge exists */
+	tEdge     vertexEdge( tVertex v0, tVertex v1 );
+	/*! Access the halfedge from v0 to v1, NULL if no such halfedge exists */
+	tHalfEdge vertexHalfedge( tVertex v0, tVertex v1 );
+	/*! Access a halfedge by its target vertex, and attaching face */
+	tHalfEdge corner( tVertex v, tFace f );
+
+	/*! The face a halfedge attaching to */
+	tFace     halfedgeFace( tHalfEdge he )		{ return he->face(); };
+	/*! The target vertex of a halfedge */
+	tVertex   halfedgeVertex( tHalfEdge he )	{ return he->vertex(); };
+	/*! The target vertex of a halfedge */
+	tVertex   halfedgeTarget( tHalfEdge he )	{ return he->target(); };
+	/*! The source vertex of a halfedge */
+	tVertex   halfedgeSource( tHalfEdge he )	{ return he->source(); };
+	/*! The next halfedge of a halfedge */
+	tHalfEdge halfedgeNext( tHalfEdge he )		{ return he->he_next(); };
+	/*! The previous halfedge of a halfedge */
+	tHalfEdge halfedgePrev( tHalfEdge he )		{ return he->he_prev(); };
+	/*! The dual halfedge of a halfedge */
+	tHalfEdge halfedgeSym( tHalfEdge he )		{ return he->he_sym(); };
+	/*! The edge of a halfedge */
+	tEdge     halfedgeEdge( tHalfEdge he )		{ return he->edge(); };
+	/*! The halfedge targeting at a vertex */
+	tHalfEdge vertexHalfedge( tVertex v )		{ return v->halfedge(); };
+	/*! The first vertex of an edge */
+	tVertex   edgeVertex1( tEdge e )			{ return e->halfedge(0)->source(); };
+	/*! The second vertex of an edge */
+	tVertex   edgeVertex2( tEdge e )			{ return e->halfedge(0)->target(); };
+	/*! The halfedge[id] attaching to an edge */
+	tHalfEdge edgeHalfedge( tEdge e, int id )	{ return e->halfedge( id ); };
+	/*! The first halfedge attaching to a face */
+	tHalfEdge faceHalfedge( tFace f )			{ return f->halfedge(); };
+
+	/*! The most Clw Out HalfEdge of a vertex */
+	tHalfEdge vertexMostClwOutHalfEdge( tVertex v )		{ return v->most_clw_out_halfedge(); };
+	/*! The most Ccw Out HalfEdge of a vertex */
+	tHalfEdge vertexMostCcwOutHalfEdge( tVertex v )		{ return v->most_ccw_out_halfedge(); };
+	/*! The next Ccw Out HalfEdge */
+	tHalfEdge vertexNextCcwOutHalfEdge( tHalfEdge he )	{ return he->ccw_rotate_about_source(); };
+	/*! The next Clw Out HalfEdge */
+	tHalfEdge vertexNextClwOutHalfEdge( tHalfEdge he )	{ assert( he->he_sym() != NULL ); return he->clw_rotate_about_source(); };
+	/*! The most Clw In HalfEdge of a vertex */
+	tHalfEdge vertexMostClwInHalfEdge( tVertex v )		{ return v->most_clw_in_halfedge(); };
+	/*! The most Ccw In HalfEdge of a vertex */
+	tHalfEdge vertexMostCcwInHalfEdge( tVertex v )		{ return v->most_ccw_in_halfedge(); };
+	/*! The next Ccw In HalfEdge */
+	tHalfEdge vertexNextCcwInHalfEdge( tHalfEdge he )	{ assert( he->he_sym() != NULL ); return he->ccw_rotate_about_target(); };
+	/*! The next Clw In HalfEdge */
+	tHalfEdge vertexNextClwInHalfEdge( tHalfEdge he )	{ return he->clw_rotate_about_target(); };
+	/*! The most Ccw HalfEdge of a face */
+	tHalfEdge faceMostCcwHalfEdge( tFace f )			{ return f->halfedge(); };
+	/*! The most Clw HalfEdge of a face */
+	tHalfEdge faceMostClwHalfEdge( tFace f )			{ return f->halfedge()->he_next(); };
+	/*! The next Ccw HalfEdge of a halfedge in a face */
+	tHalfEdge faceNextCcwHalfEdge( tHalfEdge he )		{ return he->he_next(); };
+	/*! The next Clw HalfEdge of a halfedge in a face */
+	tHalfEdge faceNextClwHalfEdge( tHalfEdge he )		{ return he->he_prev(); };
+
+	/*! Edge length */
+	double edgeLength( tEdge e )						{ return e_length( e->index() ); };
+
+	/*!
+		\brief MeshVertexIterator, transverse all the vertices in the mesh
+	*/
+	class MeshVertexIterator
+	{
+	public:
+		MeshVertexIterator( CIndexMesh * pMesh )	{ m_pMesh = pMesh; m_index = 0; };
+		CIndexVertex * value()						{ return &m_pMesh->m_v_obj[m_index]; };
+		CIndexVertex * operator*()					{ return value(); };
+		void operator++()							{ ++ m_index; };
+		void operator++(int)						{ ++ m_index; };
+		bool end()									{ return m_index >= (tIndex) m_pMesh->m_v_obj.size(); };
+		void reset()								{ m_index = 0; };
+	private:
+		CIndexMesh * m_pMesh;
+		tIndex       m_index;
+	};
+
+	/*!
+		\brief MeshEdgeIterator, transverse all the edges in the mesh
+	*/
+	class MeshEdgeIterator
+	{
+	public:
+		MeshEdgeIterator( CIndexMesh * pMesh )		{ m_pMesh = pMesh; m_index = 0; };
+		CIndexEdge * value()						{ return &m_pMesh->m_e_obj[m_index]; };
+		CIndexEdge * operator*()					{ return value(); };
+		void operator++()							{ ++ m_index; };
+		void operator++(int)						{ ++ m_index; };
+		bool end()									{ return m_index >= (tIndex) m_pMesh->m_e_obj.size(); };
+		void reset()								{ m_index = 0; };
+	private:
+		CIndexMesh * m_pMesh;
+		tIndex       m_index;
+	};
+
+	/*!
+		\brief MeshFaceIterator, transverse all the faces in the mesh
+	*/
+	class MeshFaceIterator
+	{
+	public:
+		MeshFaceIterator( CIndexMesh * pMesh )		{ m_pMesh = pMesh; m_index = 0; };
+		CIndexFace * value()						{ return &m_pMesh->m_f_obj[m_index]; };
+		CIndexFace * operator*()					{ return value(); };
+		void operator++()							{ ++ m_index; };
+		void operator++(int)						{ ++ m_index; };
+		bool end()									{ return m_index >= (tIndex) m_pMesh->m_f_obj.size(); };
+		void reset()								{ m_index = 0; };
+	private:
+		CIndexMesh * m_pMesh;
+		tIndex       m_index;
+	};
+
+	/*!
+		\brief MeshHalfEdgeIterator, transverse all the halfedges in the mesh
+	*/
+	class MeshHalfEdgeIterator
+	{
+	public:
+		MeshHalfEdgeIterator( CIndexMesh * pMesh )	{ m_pMesh = pMesh; m_index = 0; };
+		CIndexHalfEdge * value()					{ return &m_pMesh->m_he_obj[m_index]; };
+		CIndexHalfEdge * operator*()				{ return value(); };
+		void operator++()							{ ++ m_index; };
+		void operator++(int)						{ ++ m_index; };
+		bool end()									{ return m_index >= (tIndex) m_pMesh->m_he_obj.size(); };
+		void reset()								{ m_index = 0; };
+	private:
+		CIndexMesh * m_pMesh;
+		tIndex       m_index;
+	};
+
+	/*!
+		\brief VertexOutHalfedgeIterator, transverse all the outgoing halfedges of a vertex ccwly
+	*/
+	class VertexOutHalfedgeIterator
+	{
+	public:
+		VertexOutHalfedgeIterator( CIndexMesh * pMesh, CIndexVertex * v )
+		{ m_pMesh = pMesh; m_vertex = v; m_halfedge = m_pMesh->vertexMostClwOutHalfEdge( v ); };
+		void operator++()	{ _next(); };
+		void operator++(int){ _next(); };
+		CIndexHalfEdge * value()		{ return m_halfedge; };
+		CIndexHalfEdge * operator*()	{ return value(); };
+		bool end()						{ return m_halfedge == NULL; };
+	private:
+		void _next()
+		{
+			assert( m_halfedge != NULL );
+			if( m_halfedge == m_pMesh->vertexMostCcwOutHalfEdge( m_vertex ) )
+				m_halfedge = NULL;
+			else
+				m_halfedge = m_pMesh->vertexNextCcwOutHalfEdge( m_halfedge );
+		};
+		CIndexMesh     * m_pMesh;
+		CIndexVertex   * m_vertex;
+		CIndexHalfEdge * m_halfedge;
+	};
+
+	/*!
+		\brief VertexInHalfedgeIterator, transverse all the incoming halfedges of a vertex ccwly
+	*/
+	class VertexInHalfedgeIterator
+	{
+	public:
+		VertexInHalfedgeIterator( CIndexMesh * pMesh, CIndexVertex * v )
+		{ m_pMesh = pMesh; m_vertex = v; m_halfedge = m_pMesh->vertexMostClwInHalfEdge( v ); };
+		void operator++()	{ _next(); };
+		void operator++(int){ _next(); };
+		CIndexHalfEdge * value()		{ return m_halfedge; };
+		CIndexHalfEdge * operator*()	{ return value(); };
+		bool end()						{ return m_halfedge == NULL; };
+	private:
+		void _next()
+		{
+			assert( m_halfedge != NULL );
+			if( m_halfedge == m_pMesh->vertexMostCcwInHalfEdge( m_vertex ) )
+				m_halfedge = NULL;
+			else
+				m_halfedge = m_pMesh->vertexNextCcwInHalfEdge( m_halfedge );
+		};
+		CIndexMesh     * m_pMesh;
+		CIndexVertex   * m_vertex;
+		CIndexHalfEdge * m_halfedge;
+	};
+
+	//the local iterators only use the primitive interface, they are shared with CBaseMesh
+	typedef MeshLib::VertexVertexIterator<CIndexVertex, CIndexEdge, CIndexFace, CIndexHalfEdge>	VertexVertexIterator;
+	typedef MeshLib::VertexEdgeIterator<CIndexVertex, CIndexEdge, CIndexFace, CIndexHalfEdge>	VertexEdgeIterator;
+	typedef MeshLib::VertexFaceIterator<CIndexVertex, CIndexEdge, CIndexFace, CIndexHalfEdge>	VertexFaceIterator;
+	typedef MeshLib::FaceVertexIterator<CIndexVertex, CIndexEdge, CIndexFace, CIndexHalfEdge>	FaceVertexIterator;
+	typedef MeshLib::FaceEdgeIterator<CIndexVertex, CIndexEdge, CIndexFace, CIndexHalfEdge>		FaceEdgeIterator;
+	typedef MeshLib::FaceHalfedgeIterator<CIndexVertex, CIndexEdge, CIndexFace, CIndexHalfEdge>	FaceHalfedgeIterator;
+
+protected:
+	friend class CIndexVertex;
+	friend class CIndexHalfEdge;
+	friend class CIndexEdge;
+	friend class CIndexFace;
+
+	/*! rebuild the proxy arrays */
+	void _build_proxies();
+
+	//vertex arrays
+	/*! vertex positions */
+	std::vector<CPoint>			m_v_point;
+	/*! vertex normals */
+	std::vector<CPoint>			m_v_normal;
+	/*! vertex texture coordinates */
+	std::vector<CPoint2>		m_v_uv;
+	/*! vertex ids */
+	std::vector<int>			m_v_id;
+	/*! most ccw in halfedge of each vertex */
+	std::vector<tIndex>			m_v_he;
+	/*! vertex flags */
+	std::vector<unsigned char>	m_v_flag;
+
+	//halfedge arrays
+	/*! next halfedge */
+	std::vector<tIndex>			m_he_next;
+	/*! previous halfedge */
+	std::vector<tIndex>			m_he_prev;
+	/*! dual halfedge */
+	std::vector<tIndex>			m_he_sym;
+	/*! target vertex */
+	std::vector<tIndex>			m_he_vert;
+	/*! attaching face */
+	std::vector<tIndex>			m_he_face;
+	/*! attaching edge */
+	std::vector<tIndex>			m_he_edge;
+
+	//edge arrays
+	/*! halfedge[0] of each edge */
+	std::vector<tIndex>			m_e_he;
+
+	//face arrays
+	/*! first halfedge of each face */
+	std::vector<tIndex>			m_f_he;
+	/*! face ids */
+	std::vector<int>			m_f_id;
+
+	/*! map between vertex id and vertex handle */
+	std::map<int, tIndex>		m_map_vert;
+	/*! map between face id and face handle */
+	std::map<int, tIndex>		m_map_face;
+
+	//proxies
+	std::vector<CIndexVertex>	m_v_obj;
+	std::vector<CIndexHalfEdge>	m_he_obj;
+	std::vector<CIndexEdge>		m_e_obj;
+	std::vector<CIndexFace>		m_f_obj;
+private:
+	/*! not copyable, the proxies point back to their mesh */
+	CIndexMesh( const CIndexMesh & );
+	CIndexMesh & operator=( const CIndexMesh & );
+};
+
+//CIndexVertex
+
+inline tIndex CIndexVertex::index()		{ return (tIndex)( this - &m_pMesh->m_v_obj[0] ); };
+inline CPoint & CIndexVertex::point()	{ return m_pMesh->m_v_point[index()]; };
+inline CPoint & CIndexVertex::normal()	{ return m_pMesh->m_v_normal[index()]; };
+inline CPoint2 & CIndexVertex::uv()		{ return m_pMesh->m_v_uv[index()]; };
+inline int & CIndexVertex::id()			{ return m_pMesh->m_v_id[index()]; };
+inline bool CIndexVertex::boundary()	{ return m_pMesh->v_boundary( index() ); };
+inline CIndexHalfEdge * CIndexVertex::halfedge()	{ return m_pMesh->indexHalfEdge( m_pMesh->m_v_he[index()] ); };
+
+//the halfedge of a boundary vertex is already the most ccw in halfedge, no rotation is needed
+inline CIndexHalfEdge * CIndexVertex::most_ccw_in_halfedge()
+{
+	return halfedge();
+};
+
+inline CIndexHalfEdge * CIndexVertex::most_clw_in_halfedge()
+{
+	CIndexMesh * m = m_pMesh;
+	tIndex he = m->m_v_he[index()];
+	if( !boundary() )
+	{
+		return m->indexHalfEdge( m->he_ccw_rotate_about_target( he ) );
+	}
+	tIndex ne = m->he_clw_rotate_about_target( he );
+	while( ne != INDEX_NULL )
+	{
+		he = ne;
+		ne = m->he_clw_rotate_about_target( he );
+	}
+	return m->indexHalfEdge( he );
+};
+
+inline CIndexHalfEdge * CIndexVertex::most_ccw_out_halfedge()
+{
+	CIndexMesh * m = m_pMesh;
+	tIndex he = m->m_v_he[index()];
+	if( !boundary() )
+	{
+		return m->indexHalfEdge( m->he_sym( he ) );
+	}
+	he = m->he_next( he );
+	tIndex ne = m->he_ccw_rotate_about_source( he );
+	while( ne != INDEX_NULL )
+	{
+		he = ne;
+		ne = m->he_ccw_rotate_about_source( he );
+	}
+	return m->indexHalfEdge( he );
+};
+
+inline CIndexHalfEdge * CIndexVertex::most_clw_out_halfedge()
+{
+	CIndexMesh * m = m_pMesh;
+	tIndex he = m->m_v_he[index()];
+	if( !boundary() )
+	{
+		return m->indexHalfEdge( m->he_ccw_rotate_about_source( m->he_sym( he ) ) );
+	}
+	he = m->he_next( he );
+	tIndex ne = m->he_clw_rotate_about_source( he );
+	while( ne != INDEX_NULL )
+	{
+		he = ne;
+		ne = m->he_clw_rotate_about_source( he );
+	}
+	return m->indexHalfEdge( he );
+};
+
+//CIndexHalfEdge
+
+inline tIndex CIndexHalfEdge::index()				{ return (tIndex)( this - &m_pMesh->m_he_obj[0] ); };
+inline CIndexEdge * CIndexHalfEdge::edge()			{ return m_pMesh->indexEdge( m_pMesh->m_he_edge[index()] ); };
+inline CIndexVertex * CIndexHalfEdge::vertex()		{ return m_pMesh->indexVertex( m_pMesh->m_he_vert[index()] ); };
+inline CIndexVertex * CIndexHalfEdge::target()		{ return vertex(); };
+inline CIndexVertex * CIndexHalfEdge::source()		{ return m_pMesh->indexVertex( m_pMesh->he_source( index() ) ); };
+inline CIndexHalfEdge * CIndexHalfEdge::he_prev()	{ return m_pMesh->indexHalfEdge( m_pMesh->m_he_prev[index()] ); };
+inline CIndexHalfEdge * CIndexHalfEdge::he_next()	{ return m_pMesh->indexHalfEdge( m_pMesh->m_he_next[index()] ); };
+inline CIndexHalfEdge * CIndexHalfEdge::he_sym()	{ return m_pMesh->indexHalfEdge( m_pMesh->m_he_sym[index()] ); };
+inline CIndexFace * CIndexHalfEdge::face()			{ return m_pMesh->indexFace( m_pMesh->m_he_face[index()] ); };
+inline CIndexHalfEdge * CIndexHalfEdge::ccw_rotate_about_target()	{ return m_pMesh->indexHalfEdge( m_pMesh->he_ccw_rotate_about_target( index() ) ); };
+inline CIndexHalfEdge * CIndexHalfEdge::clw_rotate_about_target()	{ return m_pMesh->indexHalfEdge( m_pMesh->he_clw_rotate_about_target( index() ) ); };
+inline CIndexHalfEdge * CIndexHalfEdge::ccw_rotate_about_source()	{ return m_pMesh->indexHalfEdge( m_pMesh->he_ccw_rotate_about_source( index() ) ); };
+inline CIndexHalfEdge * CIndexHalfEdge::clw_rotate_about_source()	{ return m_pMesh->indexHalfEdge( m_pMesh->he_clw_rotate_about_source( index() ) ); };
+
+//CIndexEdge
+
+inline tIndex CIndexEdge::index()		{ return (tIndex)( this - &m_pMesh->m_e_obj[0] ); };
+//edge ids are 1 based, the same as CBaseMesh::createEdge
+inline int CIndexEdge::id()				{ return (int) index() + 1; };
+inline CIndexHalfEdge * CIndexEdge::halfedge( int id )	{ assert( 0 <= id && id < 2 ); return m_pMesh->indexHalfEdge( m_pMesh->e_halfedge( index(), id ) ); };
+inline bool CIndexEdge::boundary()		{ return m_pMesh->m_he_sym[m_pMesh->m_e_he[index()]] == INDEX_NULL; };
+inline CIndexHalfEdge * CIndexEdge::other( CIndexHalfEdge * he )	{ return he->he_sym(); };
+
+//CIndexFace
+
+inline tIndex CIndexFace::index()		{ return (tIndex)( this - &m_pMesh->m_f_obj[0] ); };
+inline int & CIndexFace::id()			{ return m_pMesh->m_f_id[index()]; };
+inline CIndexHalfEdge * CIndexFace::halfedge()	{ return m_pMesh->indexHalfEdge( m_pMesh->m_f_he[index()] ); };
+
+//CIndexMesh
+
+/*!
+	Build the mesh from a face soup. The halfedges are paired by sorting the (min id, max id) keys,
+	the edges are numbered in the order of their first appearance, the same as CBaseMesh::createFace.
+	A face with a missing vertex is skipped, the same as CBaseMesh::read_m.
+*/
+inline void CIndexMesh::build( const std::vector<int> & ids, const std::vector<CPoint> & points,
+							   const std::vector<int> & in_fids, const std::vector<tIndex> & in_fstart, const std::vector<int> & in_fverts,
+							   std::vector<tIndex> * vremap )
+{
+	tIndex nv = (tIndex) ids.size();
+
+	m_map_vert.clear();
+	for( tIndex i = 0; i < nv; i ++ )
+		m_map_vert[ids[i]] = i;
+
+	//the faces whose vertices all exist
+	std::vector<int>    fids;
+	std::vector<tIndex> fstart( 1, 0 );
+	std::vector<int>    fverts;
+	fids.reserve( in_fids.size() );
+	fverts.reserve( in_fverts.size() );
+	for( size_t f = 0; f < in_fids.size(); f ++ )
+	{
+		bool valid = true;
+		for( tIndex h = in_fstart[f]; h < in_fstart[f+1]; h ++ )
+		{
+			if( m_map_vert.find( in_fverts[h] ) != m_map_vert.end() ) continue;
+			fprintf(stderr, "Error: face %d refers to a missing vertex %d, the face is skipped\n", in_fids[f], in_fverts[h] );
+			valid = false;
+			break;
+		}
+		if( !valid ) continue;
+		fids.push_back( in_fids[f] );
+		fverts.insert( fverts.end(), in_fverts.begin() + in_fstart[f], in_fverts.begin() + in_fstart[f+1] );
+		fstart.push_back( (tIndex) fverts.size() );
+	}
+
+	tIndex nf = (tIndex) fids.size();
+	tIndex nh = (tIndex) fverts.size();
+
+	m_v_id    = ids;
+	m_v_point = points;
+	m_v_normal.assign( nv, CPoint() );
+	m_v_uv.assign( nv, CPoint2() );
+	m_v_he.assign( nv, INDEX_NULL );
+	m_v_flag.assign( nv, 0 );
+
+	m_f_id = fids;
+	m_f_he.resize( nf );
+	m_map_face.clear();
+	for( tIndex i = 0; i < nf; i ++ )
+		m_map_face[fids[i]] = i;
+
+	m_he_next.resize( nh );
+	m_he_prev.resize( nh );
+	m_he_vert.resize( nh );
+	m_he_face.resize( nh );
+	m_he_sym.assign( nh, INDEX_NULL );
+	m_he_edge.assign( nh, INDEX_NULL );
+
+	//halfedge i of a face points to the i-th vertex, the same as CBaseMesh::createFace
+	for( tIndex f = 0; f < nf; f ++ )
+	{
+		tIndex s = fstart[f];
+		tIndex n = fstart[f+1] - s;
+		for( tIndex i = 0; i < n; i ++ )
+		{
+			tIndex h = s + i;
+			std::map<int,tIndex>::iterator pos = m_map_vert.find( fverts[h] );
+			m_he_vert[h] = pos->second;
+			m_he_next[h] = s + ( i + 1 ) % n;
+			m_he_prev[h] = s + ( i + n - 1 ) % n;
+			m_he_face[h] = f;
+			m_v_he[pos->second] = h;
+		}
+		m_f_he[f] = s + n - 1;
+	}
+
+	//remove the dangling vertices, the same as CBaseMesh::read_m
+	std::vector<tIndex> remap( nv, INDEX_NULL );
+	tIndex nu = 0;
+	for( tIndex v = 0; v < nv; v ++ )
+	{
+		if( m_v_he[v] == INDEX_NULL ) continue;
+		remap[v] = nu;
+		m_v_id[nu]    = m_v_id[v];
+		m_v_point[nu] = m_v_point[v];
+		m_v_he[nu]    = m_v_he[v];
+		nu ++;
+	}
+	if( vremap != NULL ) *vremap = remap;
+	if( nu < nv )
+	{
+		nv = nu;
+		m_v_id.resize( nv );
+		m_v_point.resize( nv );
+		m_v_he.resize( nv );
+		m_v_normal.resize( nv );
+		m_v_uv.resize( nv );
+		m_v_flag.resize( nv );
+		for( tIndex h = 0; h < nh; h ++ ) m_he_vert[h] = remap[m_he_vert[h]];
+		m_map_vert.clear();
+		for( tIndex i = 0; i < nv; i ++ )
+			m_map_vert[m_v_id[i]] = i;
+	}
+
+	//pair the halfedges, key = (min vertex handle, max vertex handle)
+	std::vector< std::pair<unsigned long long, tIndex> > keys( nh );
+	for( tIndex h = 0; h < nh; h ++ )
+	{
+		unsigned long long a = m_he_vert[m_he_prev[h]];
+		unsigned long long b = m_he_vert[h];
+		keys[h].first  = ( a < b )? ( ( a << 32 ) | b ) : ( ( b << 32 ) | a );
+		keys[h].second = h;
+	}
+	std::sort( keys.begin(), keys.end() );
+
+	//first halfedge of every edge; on a non-manifold edge the third and later halfedges
+	//get boundary edges of their own, so that every halfedge has an edge
+	std::vector<tIndex> first;
+	for( tIndex i = 0; i < nh; )
+	{
+		tIndex j = i + 1;
+		while( j < nh && keys[j].first == keys[i].first ) j ++;
+		if( j - i > 2 )
+		{
+			fprintf(stderr, "Error: non-manifold edge shared by %d faces\n", (int)( j - i ) );
+			for( tIndex k = i + 2; k < j; k ++ ) first.push_back( keys[k].second );
+		}
+		first.push_back( keys[i].second );
+		if( j - i >= 2 )
+		{
+			m_he_sym[keys[i].second]   = keys[i+1].second;
+			m_he_sym[keys[i+1].second] = keys[i].second;
+		}
+		i = j;
+	}
+	std::sort( first.begin(), first.end() );
+
+	tIndex ne = (tIndex) first.size();
+	m_e_he.resize( ne );
+	for( tIndex e = 0; e < ne; e ++ )
+	{
+		tIndex h = first[e];
+		tIndex s = m_he_sym[h];
+		m_he_edge[h] = e;
+		if( s != INDEX_NULL ) m_he_edge[s] = e;
+		//interior edges go from the smaller id to the larger id, the same as CBaseMesh::read_m
+		if( s != INDEX_NULL && m_v_id[m_he_vert[h]] < m_v_id[m_he_vert[m_he_prev[h]]] )
+			h = s;
+		m_e_he[e] = h;
+		if( s == INDEX_NULL )
+		{
+			m_v_flag[m_he_vert[h]] |= VERTEX_BOUNDARY;
+			m_v_flag[m_he_vert[m_he_prev[h]]] |= VERTEX_BOUNDARY;
+		}
+	}
+
+	//the halfedge of a boundary vertex is its most ccw in halfedge
+	for( tIndex v = 0; v < nv; v ++ )
+	{
+		if( !v_boundary( v ) || m_v_he[v] == INDEX_NULL ) continue;
+		tIndex he = m_v_he[v];
+		while( m_he_sym[he] != INDEX_NULL )
+			he = he_ccw_rotate_about_target( he );
+		m_v_he[v] = he;
+	}
+
+	_build_proxies();
+};
+
+inline void CIndexMesh::_build_proxies()
+{
+	m_v_obj.resize( m_v_point.size() );
+	m_he_obj.resize( m_he_next.size() );
+	m_e_obj.resize( m_e_he.size() );
+	m_f_obj.resize( m_f_he.size() );
+
+	for( size_t i = 0; i < m_v_obj.size(); i ++ )  m_v_obj[i].m_pMesh  = this;
+	for( size_t i = 0; i < m_he_obj.size(); i ++ ) m_he_obj[i].m_pMesh = this;
+	for( size_t i = 0; i < m_e_obj.size(); i ++ )  m_e_obj[i].m_pMesh  = this;
+	for( size_t i = 0; i < m_f_obj.size(); i ++ )  m_f_obj[i].m_pMesh  = this;
+};
+
+/*!
+	Copy a pointer based mesh, the vertex, face order is kept, the vertex normals and uvs are copied.
+*/
+template<typename M>
+void CIndexMesh::copy( M * pMesh )
+{
+	std::vector<int> ids, fids, fverts;
+	std::vector<CPoint> points;
+	std::vector<tIndex> fstart;
+
+	for( M::MeshVertexIterator viter( pMesh ); !viter.end(); viter ++ )
+	{
+		M::CVertex * pV = *viter;
+		ids.push_back( pV->id() );
+		points.push_back( pV->point() );
+	}
+	for( M::MeshFaceIterator fiter( pMesh ); !fiter.end(); fiter ++ )
+	{
+		M::CFace * pF = *fiter;
+		fids.push_back( pF->id() );
+		fstart.push_back( (tIndex) fverts.size() );
+		//face halfedge is the last halfedge, start from the first vertex
+		M::CHalfEdge * pH = (M::CHalfEdge*) pF->halfedge()->he_next();
+		M::CHalfEdge * pS = pH;
+		do{
+			fverts.push_back( pH->target()->id() );
+			pH = (M::CHalfEdge*) pH->he_next();
+		}while( pH != pS );
+	}
+	fstart.push_back( (tIndex) fverts.size() );
+
+	std::vector<tIndex> remap;
+	build( ids, points, fids, fstart, fverts, &remap );
+
+	tIndex i = 0;
+	for( M::MeshVertexIterator viter( pMesh ); !viter.end(); viter ++, i ++ )
+	{
+		if( remap[i] == INDEX_NULL ) continue;
+		M::CVertex * pV = *viter;
+		m_v_normal[remap[i]] = pV->normal();
+		m_v_uv[remap[i]]     = pV->uv();
+	}
+};
+
+/*!
+	Read an .m file
+*/
+inline void CIndexMesh::read_m( const char * input )
+{
+	std::fstream is( input, std::fstream::in );
+
+	if( is.fail() )
+	{
+		fprintf(stderr,"Error in opening file %s\n", input );
+		return;
+	}
+
+	std::vector<int> ids, fids, fverts;
+	std::vector<CPoint> points;
+	std::vector<tIndex> fstart;
+	std::vector<std::string> vstrings;
+
+	char buffer[MAX_LINE];
+
+	while( is.getline( buffer, MAX_LINE ) )
+	{
+		std::string line( buffer );
+		line = strutil::trim( line );
+
+		strutil::Tokenizer stokenizer( line, " \r\n" );
+
+		stokenizer.nextToken();
+		std::string token = stokenizer.getToken();
+
+		if( token == "Vertex" )
+		{
+			stokenizer.nextToken();
+			token = stokenizer.getToken();
+			ids.push_back( strutil::parseString<int>( token ) );
+
+			CPoint p;
+			for( int i = 0; i < 3; i ++ )
+			{
+				stokenizer.nextToken();
+				token = stokenizer.getToken();
+				p[i] = strutil::parseString<float>( token );
+			}
+			points.push_back( p );
+
+			std::string str;
+			int sp = (int) line.find("{");
+			int ep = (int) line.find("}");
+			if( sp >= 0 && ep >= 0 ) str = line.substr( sp+1, ep-sp-1 );
+			vstrings.push_back( str );
+			continue;
+		}
+
+		if( token == "Face" )
+		{
+			stokenizer.nextToken();
+			token = stokenizer.getToken();
+			fids.push_back( strutil::parseString<int>( token ) );
+			fstart.push_back( (tIndex) fverts.size() );
+
+			while( stokenizer.nextToken() )
+			{
+				token = stokenizer.getToken();
+				if( strutil::startsWith( token, "{" ) ) break;
+				fverts.push_back( strutil::parseString<int>( token ) );
+			}
+			continue;
+		}
+	}
+	fstart.push_back( (tIndex) fverts.size() );
+
+	std::vector<tIndex> remap;
+	build( ids, points, fids, fstart, fverts, &remap );
+
+	//uv=(u v) and normal=(x y z), the dangling vertices are gone
+	for( tIndex i = 0; i < (tIndex) vstrings.size(); i ++ )
+	{
+		tIndex v = remap[i];
+		if( v == INDEX_NULL ) continue;
+		const std::string & s = vstrings[i];
+		int p = (int) s.find( "uv=(" );
+		if( p >= 0 ) sscanf( s.c_str() + p + 4, "%lf %lf", &m_v_uv[v][0], &m_v_uv[v][1] );
+		p = (int) s.find( "normal=(" );
+		if( p >= 0 ) sscanf( s.c_str() + p + 8, "%lf %lf %lf", &m_v_normal[v][0], &m_v_normal[v][1], &m_v_normal[v][2] );
+	}
+};
+
+/*!
+	Access a vertex by its id
+*/
+inline CIndexVertex * CIndexMesh::idVertex( int id )
+{
+	std::map<int,tIndex>::iterator pos = m_map_vert.find( id );
+	if( pos == m_map_vert.end() ) return NULL;
+	return &m_v_obj[pos->second];
+};
+
+/*!
+	Access a face by its id
+*/
+inline CIndexFace * CIndexMesh::idFace( int id )
+{
+	std::map<int,tIndex>::iterator pos = m_map_face.find( id );
+	if( pos == m_map_face.end() ) return NULL;
+	return &m_f_obj[pos->second];
+};
+
+/*!
+	Access the halfedge from v0 to v1, by rotating around v1
+*/
+inline CIndexHalfEdge * CIndexMesh::vertexHalfedge( tVertex v0, tVertex v1 )
+{
+	tIndex s = v0->index();
+	tIndex t = v1->index();
+	tIndex he = m_v_he[t];
+	if( he == INDEX_NULL ) return NULL;
+	tIndex start = he;
+	//ccw rotation from the most ccw in halfedge of a boundary vertex stops at once, go clwly
+	do{
+		if( he_source( he ) == s ) return &m_he_obj[he];
+		he = he_clw_rotate_about_target( he );
+	}while( he != INDEX_NULL && he != start );
+	return NULL;
+};
+
+/*!
+	Access an edge by its two end vertices
+*/
+inline CIndexEdge * CIndexMesh::vertexEdge( tVertex v0, tVertex v1 )
+{
+	CIndexHalfEdge * he = vertexHalfedge( v0, v1 );
+	if( he == NULL ) he = vertexHalfedge( v1, v0 );
+	if( he == NULL ) return NULL;
+	return he->edge();
+};
+
+/*!
+	Access a halfedge by its target vertex, and attaching face
+*/
+inline CIndexHalfEdge * CIndexMesh::corner( tVertex v, tFace f )
+{
+	tIndex he = m_f_he[f->index()];
+	tIndex start = he;
+	do{
+		if( m_he_vert[he] == v->index() ) return &m_he_obj[he];
+		he = m_he_next[he];
+	}while( he != start );
+	return NULL;
+};
+
+}//name space MeshLib
+
+#endif //_MESHLIB_INDEX_MESH_H_ defined
@@ -0,0 +1,470 @@
+/*!
+*      \file TraitColumns.h
+*      \brief Typed trait columns of the mesh elements
+*
+*		A trait such as uv=(u v) or sharp is stored in a column, a contiguous array
+*		with one value per element of a kind, instead of in the trait string of every
+*		element. Each element owns a slot, its row in all the columns of its kind.
+*		The loaders parse the tokens of a column straight from the file into the
+*		column, the writers format the column into the file; the tokens without a
+*		column stay in the trait string, unless the mesh drops them, see
+*		CBaseMesh::m_trait_strings. A column owns its key: a token with the key in
+*		the trait string is not written.
+*/
+
+#ifndef _MESHLIB_TRAIT_COLUMNS_H_
+#define _MESHLIB_TRAIT_COLUMNS_H_
+
+#include <assert.h>
+#include <string>
+#include <typeinfo>
+#include <algorithm>
+#include <vector>
+
+#include "../Geometry/Point.h"
+#include "../Geometry/Point2.h"
+#include "../Parser/parser.h"
+#include "../Parser/TextWriter.h"
+
+namespace MeshLib{
+
+/*! read a trait value "(v)" */
+inline void traitRead( const strutil::StrRef & value, double & v )	{ v = 0; CTraitTokenizer::values( value, &v, 1 ); };
+/*! read a trait value "(v)" */
+inline void traitRead( const strutil::StrRef & value, int & v )
+{
+	strutil::RangeTokenizer tokenizer( value, " \t()" );
+	v = tokenizer.nextToken() ? strutil::parseString<int>( tokenizer.getToken() ) : 0;
+};
+/*! read a trait value "(x y z)" */
+inline void traitRead( const strutil::StrRef & value, CPoint & v )	{ value >> v; };
+/*! read a trait value "(x y)" */
+inline void traitRead( const strutil::StrRef & value, CPoint2 & v )	{ value >> v; };
+/*! read a flag, set by the key alone */
+inline void traitRead( const strutil::StrRef &, bool & v )			{ v = true; };
+
+/*! blend two trait values, ( 1 - t ) a + t b; a value which does not interpolate takes the nearer one */
+template<typename T>
+inline T traitBlend( const T & a, const T & b, double t )	{ return ( t < 0.5 )? a : b; };
+/*! blend two trait values, ( 1 - t ) a + t b */
+inline double traitBlend( const double & a, const double & b, double t )	{ return a + ( b - a ) * t; };
+/*! blend two trait values, ( 1 - t ) a + t b */
+inline CPoint traitBlend( const CPoint & a, const CPoint & b, double t )	{ return a + ( b - a ) * t; };
+/*! blend two trait values, ( 1 - t ) a + t b */
+inline CPoint2 traitBlend( const CPoint2 & a, const CPoint2 & b, double t )	{ return CPoint2( a[0] + ( b[0] - a[0] ) * t, a[1] + ( b[1] - a[1] ) * t ); };
+
+/*! write a trait value "(v)" */
+inline void traitWrite( CTextBuffer & out, double v )		{ out << '(' << v << ')'; };
+/*! write a trait value "(v)" */
+inline void traitWrite( CTextBuffer & out, int v )			{ out << '(' << v << ')'; };
+/*! write a trait value "(x y z)" */
+inline void traitWrite( CTextBuffer & out, const CPoint & v )	{ out << '(' << v[0] << ' ' << v[1] << ' ' << v[2] << ')'; };
+/*! write a trait value "(x y)" */
+inline void traitWrite( CTextBuffer & out, const CPoint2 & v )	{ out << '(' << v[0] << ' ' << v[1] << ')'; };
+
+/*!
+*	\brief CTraitColumnBase, untyped interface of a trait column
+*/
+class CTraitColumnBase
+{
+public:
+	/*! CTraitColumnBase constructor */
+	CTraitColumnBase( const char * name ) : m_key( name ) {};
+	/*! CTraitColumnBase destructor */
+	virtual ~CTraitColumnBase() {};
+
+	/*! key of the trait */
+	const CTraitKey & key() const { return m_key; };
+
+	/*! make room for n slots */
+	virtual void resize( size_t n ) = 0;
+	/*! set the value of a slot to the default value */
+	virtual void reset( size_t slot ) = 0;
+	/*!
+	Read the value of a slot from a token.
+	\param slot  the slot
+	\param value the value of the token, with the parentheses, empty for a key without value
+	*/
+	virtual void read( size_t slot, const strutil::StrRef & value ) = 0;
+	/*!
+	Append the token of a slot.
+	\return false if the slot has no token, i.e. a flag which is not set
+	*/
+	virtual bool write( size_t slot, CTextBuffer & out ) = 0;
+	/*!
+	Move the values to the new slots and keep n of them.
+	\param remap new slot of each old slot, -1 for a dropped slot, never larger than the old slot
+	\param n     number of new slots
+	*/
+	virtual void compact( const std::vector<int> & remap, size_t n ) = 0;
+	/*! set the value of a slot to the blend ( 1 - t ) a + t b of the values of two slots */
+	virtual void blend( size_t slot, size_t a, size_t b, double t ) = 0;
+	/*!
+	Set the value of a slot to a weighted sum of the values of a column of the same type.
+	\param slot    the slot
+	\param from    the column of the values, e.g. of a coarser mesh
+	\param slots   the slots of the values in from
+	\param weights the weights, positive
+	\param n       number of values
+	*/
+	virtual void mix( size_t slot, CTraitColumnBase & from, const int * slots, const double * weights, int n ) = 0;
+	/*! a new column of the same trait and type, without values */
+	virtual CTraitColumnBase * clone() const = 0;
+
+protected:
+	/*! key of the trait */
+	CTraitKey m_key;
+};
+
+/*! stored type of a trait value, a flag is stored as a char so that the values are addressable */
+template<typename T> struct CTraitStorage			{ typedef T type; };
+template<>           struct CTraitStorage<bool>	{ typedef char type; };
+
+/*!
+*	\brief CTraitColumn, the values of one trait for all the elements of a kind
+*
+*	Every element has a value, the default one until it is set or read. Only the
+*	elements whose value has been read from a token or accessed for writing carry the
+*	trait, see present(), the others are not written. A bool column is a flag: the
+*	token is the key alone, written only when the value is true.
+*	\tparam T value type, with traitRead/traitWrite overloads unless it is bool
+*/
+template<typename T>
+class CTraitColumn : public CTraitColumnBase
+{
+public:
+	/*! stored value type */
+	typedef typename CTraitStorage<T>::type tValue;
+
+	/*! CTraitColumn constructor */
+	CTraitColumn( const char * name, const T & value ) : CTraitColumnBase( name ), m_default( value ) {};
+
+	/*! value of a slot, which then carries the trait */
+	tValue & operator[]( size_t slot ) { m_present[slot] = 1; return m_values[slot]; };
+	/*! value of an element, which then carries the trait */
+	template<typename E>
+	tValue & operator()( E * e ) { return (*this)[e->slot()]; };
+	/*! value of a slot, the default one if the slot does not carry the trait */
+	const tValue & value( size_t slot ) const { return m_values[slot]; };
+	/*! whether a slot carries the trait */
+	bool present( size_t slot ) const { return m_present[slot] != 0; };
+	/*! all the values, indexed by the slots, all of them then carry the trait */
+	std::vector<tValue> & values() { std::fill( m_present.begin(), m_present.end(), 1 ); return m_values; };
+
+	void resize( size_t n )
+	{
+		if( n <= m_values.size() ) return;
+		m_values.resize( n, m_default );
+		m_present.resize( n, 0 );
+	};
+	void reset( size_t slot )	{ m_values[slot] = m_default; m_present[slot] = 0; };
+	void read( size_t slot, const strutil::StrRef & value )	{ traitRead( value, m_values[slot] ); m_present[slot] = 1; };
+	bool write( size_t slot, CTextBuffer & out )
+	{
+		if( !m_present[slot] ) return false;
+		out << m_key.name();
+		out << '=';
+		traitWrite( out, m_values[slot] );
+		return true;
+	};
+	void compact( const std::vector<int> & remap, size_t n )
+	{
+		size_t m = std::min( remap.size(), m_values.size() );
+		for( size_t s = 0; s < m; s ++ )
+		{
+			if( remap[s] < 0 ) continue;
+			m_values[remap[s]]  = m_values[s];
+			m_present[remap[s]] = m_present[s];
+		}
+		m_values.resize( n, m_default );
+		m_present.resize( n, 0 );
+	};
+	void blend( size_t slot, size_t a, size_t b, double t )
+	{
+		m_values[slot]  = traitBlend( m_values[a], m_values[b], t );
+		m_present[slot] = m_present[a] | m_present[b];
+	};
+	void mix( size_t slot, CTraitColumnBase & from, const int * slots, const double * weights, int n )
+	{
+		std::vector<tValue> & values  = static_cast<CTraitColumn<T>&>( from ).m_values;
+		std::vector<char>   & present = static_cast<CTraitColumn<T>&>( from ).m_present;
+		char carried = 0;
+		for( int i = 0; i < n; i ++ ) carried |= present[slots[i]];
+		m_present[slot] = carried;
+		//blend the values in one by one, a value which does not interpolate is replaced by a heavier one
+		tValue value  = values[slots[0]];
+		double weight = weights[0];
+		for( int i = 1; i < n; i ++ )
+		{
+			weight += weights[i];
+			value = traitBlend( value, values[slots[i]], weights[i] / weight );
+		}
+		m_values[slot] = value;
+	};
+	CTraitColumnBase * clone() const	{ return new CTraitColumn<T>( std::string( m_key.name().begin(), m_key.name().end() ).c_str(), m_default ); };
+
+protected:
+	/*! value of the new elements */
+	tValue              m_default;
+	/*! the values */
+	std::vector<tValue> m_values;
+	/*! by slot, 1 if the element carries the trait */
+	std::vector<char>   m_present;
+};
+
+/*! a flag is set by the key alone */
+template<>
+inline void CTraitColumn<bool>::read( size_t slot, const strutil::StrRef & )	{ m_values[slot] = true; m_present[slot] = 1; };
+
+template<>
+inline bool CTraitColumn<bool>::write( size_t slot, CTextBuffer & out )
+{
+	if( !m_values[slot] ) return false;
+	out << m_key.name();
+	return true;
+};
+
+/*!
+*	\brief CTraitColumns, the trait columns of one element kind and the slots of the elements
+*
+*	The slots of the deleted elements are recycled. The columns are only resized
+*	when an element is created, so the values of distinct elements can be read and
+*	written on several threads.
+*/
+class CTraitColumns
+{
+public:
+	/*! CTraitColumns constructor */
+	CTraitColumns() { m_slots = 0; };
+	/*! CTraitColumns destructor */
+	~CTraitColumns()
+	{
+		for( size_t i = 0; i < m_columns.size(); i ++ ) delete m_columns[i];
+	};
+
+	/*!
+	Register a column, or return the column which is already registered with the name.
+	\param name  trait key
+	\param value value of the elements which do not have the trait
+	*/
+	template<typename T>
+	CTraitColumn<T> & add( const char * name, const T & value = T() );
+	/*! the column with the name, NULL if there is none or its type is not T */
+	template<typename T>
+	CTraitColumn<T> * find( const char * name );
+	/*! whether no column is registered */
+	bool empty() const { return m_columns.empty(); };
+	/*! number of slots, the slots of the elements are in [0, size()) */
+	int  size() const { return m_slots; };
+
+	/*! slot for a new element */
+	int  acquire();
+	/*! recycle the slot of a deleted element */
+	void release( int slot ) { m_free.push_back( slot ); };
+	/*!
+	Renumber the slots, the values of the columns move with them, no slot is left to recycle.
+	\param remap new slot of each old slot, -1 for a dropped slot, never larger than the old slot
+	\param n     number of new slots
+	*/
+	void compact( const std::vector<int> & remap, int n );
+	/*! set the values of a slot in all the columns to the blend ( 1 - t ) a + t b of two slots, e.g. when an edge collapses */
+	void blend( int slot, int a, int b, double t ) { for( size_t i = 0; i < m_columns.size(); i ++ ) m_columns[i]->blend( slot, a, b, t ); };
+	/*! register the columns of another element kind, e.g. of a coarser mesh, a column of another type with the same name is replaced */
+	void copyColumns( const CTraitColumns & from );
+	/*!
+	Set the values of a slot in all the columns to a weighted sum of the values of the
+	columns with the same name and type in from, see CTraitColumnBase::mix.
+	*/
+	void mix( int slot, CTraitColumns & from, const int * slots, const double * weights, int n );
+
+	/*!
+	Read a trait string of an element: the tokens of the columns go to the columns,
+	the other tokens are appended to rest.
+	\param slot the slot of the element
+	\param str  the trait string
+	\param rest the tokens without a column, NULL to drop them
+	*/
+	void read( int slot, const strutil::StrRef & str, std::string * rest );
+	/*!
+	Append the tokens of the columns of an element, separated by blanks.
+	\return false if nothing has been appended
+	*/
+	bool write( int slot, CTextBuffer & out );
+	/*!
+	Append the tokens of a trait string which have no column, separated by blanks,
+	so that a trait written by a column and by a _to_string hook has one token.
+	\return false if nothing has been appended
+	*/
+	bool writeString( const std::string & str, CTextBuffer & out );
+	/*! whether a column is registered with the key */
+	bool has( const CTraitKey & key ) const;
+
+protected:
+	/*! the columns */
+	std::vector<CTraitColumnBase*> m_columns;
+	/*! recycled slots */
+	std::vector<int>               m_free;
+	/*! number of slots */
+	int                            m_slots;
+
+private:
+	CTraitColumns( const CTraitColumns & );
+	CTraitColumns & operator=( const CTraitColumns & );
+};
+
+template<typename T>
+CTraitColumn<T> & CTraitColumns::add( const char * name, const T & value )
+{
+	CTraitColumn<T> * column = find<T>( name );
+	if( column != NULL ) return *column;
+
+	//a column of another type with the same name is replaced
+	CTraitKey key( name );
+	for( size_t i = 0; i < m_columns.size(); i ++ )
+	{
+		if( m_columns[i]->key().id() != key.id() ) continue;
+		delete m_columns[i];
+		m_columns.erase( m_columns.begin() + i );
+		break;
+	}
+
+	column = new CTraitColumn<T>( name, value );
+	column->resize( m_slots );
+	m_columns.push_back( column );
+	return *column;
+};
+
+template<typename T>
+CTraitColumn<T> * CTraitColumns::find( const char * name )
+{
+	CTraitKey key( name );
+	for( size_t i = 0; i < m_columns.size(); i ++ )
+	{
+		if( m_columns[i]->key().id() == key.id() ) return dynamic_cast<CTraitColumn<T>*>( m_columns[i] );
+	}
+	return NULL;
+};
+
+inline int CTraitColumns::acquire()
+{
+	int slot;
+	if( !m_free.empty() )
+	{
+		slot = m_free.back();
+		m_free.pop_back();
+		for( size_t i = 0; i < m_columns.size(); i ++ ) m_columns[i]->reset( slot );
+		return slot;
+	}
+
+	slot = m_slots ++;
+	for( size_t i = 0; i < m_columns.size(); i ++ ) m_columns[i]->resize( m_slots );
+	return slot;
+};
+
+inline void CTraitColumns::compact( const std::vector<int> & remap, int n )
+{
+	for( size_t i = 0; i < m_columns.size(); i ++ ) m_columns[i]->compact( remap, (size_t) n );
+	m_slots = n;
+	m_free.clear();
+};
+
+inline void CTraitColumns::copyColumns( const CTraitColumns & from )
+{
+	for( size_t j = 0; j < from.m_columns.size(); j ++ )
+	{
+		CTraitColumnBase * column = from.m_columns[j];
+		size_t i = 0;
+		while( i < m_columns.size() && m_columns[i]->key().id() != column->key().id() ) i ++;
+		if( i < m_columns.size() && typeid( *m_columns[i] ) == typeid( *column ) ) continue;
+		if( i < m_columns.size() )
+		{
+			delete m_columns[i];
+			m_columns.erase( m_columns.begin() + i );
+		}
+		m_columns.push_back( column->clone() );
+		m_columns.back()->resize( m_slots );
+	}
+};
+
+inline void CTraitColumns::mix( int slot, CTraitColumns & from, const int * slots, const double * weights, int n )
+{
+	for( size_t i = 0; i < m_columns.size(); i ++ )
+	{
+		for( size_t j = 0; j < from.m_columns.size(); j ++ )
+		{
+			if( from.m_columns[j]->key().id() != m_columns[i]->key().id() ) continue;
+			if( typeid( *from.m_columns[j] ) == typeid( *m_columns[i] ) ) m_columns[i]->mix( slot, *from.m_columns[j], slots, weights, n );
+			break;
+		}
+	}
+};
+
+inline void CTraitColumns::read( int slot, const strutil::StrRef & str, std::string * rest )
+{
+	CTraitTokenizer tokenizer( str );
+	while( tokenizer.next() )
+	{
+		size_t i = 0;
+		while( i < m_columns.size() && !tokenizer.is( m_columns[i]->key() ) ) i ++;
+		if( i < m_columns.size() )
+		{
+			m_columns[i]->read( slot, tokenizer.value() );
+			continue;
+		}
+		if( rest == NULL ) continue;
+		if( !rest->empty() ) *rest += ' ';
+		rest->append( tokenizer.key().begin(), tokenizer.key().end() );
+		if( tokenizer.value().empty() ) continue;
+		*rest += '=';
+		rest->append( tokenizer.value().begin(), tokenizer.value().end() );
+	}
+};
+
+inline bool CTraitColumns::has( const CTraitKey & key ) const
+{
+	for( size_t i = 0; i < m_columns.size(); i ++ )
+	{
+		if( m_columns[i]->key().id() == key.id() ) return true;
+	}
+	return false;
+};
+
+inline bool CTraitColumns::writeString( const std::string & str, CTextBuffer & out )
+{
+	if( m_columns.empty() )
+	{
+		out << str;
+		return !str.empty();
+	}
+
+	bool written = false;
+	CTraitTokenizer tokenizer( str );
+	while( tokenizer.next() )
+	{
+		size_t i = 0;
+		while( i < m_columns.size() && !tokenizer.is( m_columns[i]->key() ) ) i ++;
+		if( i < m_columns.size() ) continue;
+		if( written ) out << ' ';
+		out << tokenizer.key();
+		if( !tokenizer.value().empty() ) out << '=' << tokenizer.value();
+		written = true;
+	}
+	return written;
+};
+
+inline bool CTraitColumns::write( int slot, CTextBuffer & out )
+{
+	bool written = false;
+	for( size_t i = 0; i < m_columns.size(); i ++ )
+	{
+		size_t size = out.size();
+		if( written ) out << ' ';
+		if( m_columns[i]->write( slot, out ) ) written = true;
+		else out.resize( size );
+	}
+	return written;
+};
+
+}//name space MeshLib
+
+#endif //_MESHLIB_TRAIT_COLUMNS_H_ defined
@@ -30,7 +30,7 @@ namespace MeshLib{
 	  /*!
 	  CVertex constructor
 	  */
-      CVertex(){ m_halfedge = NULL; m_boundary = false; };
+      CVertex(){ m_halfedge = NULL; m_boundary = false; m_slot = -1; };
 	  /*!
 	  CVertex destructor 
 	  */
@@ -68,15 +68,28 @@ namespace MeshLib{
 	/*! Vertex id. 
 	*/
     int  & id() { return m_id; };
+	/*! Row of the vertex in the trait columns of the mesh.
+	*/
+    int  & slot() { return m_slot; };
 	/*! Whether the vertex is on the boundary. 
 	*/
     bool & boundary() { return m_boundary;};
-    /*! Convert vertex traits to string. 
+    /*! Convert vertex traits to string, see CBaseMesh::m_parallel_traits.
 	*/
 	void _to_string()   {};
-	/*! Read traits from the string. 
+	/*! Read traits from the string, see CBaseMesh::m_parallel_traits.
 	*/
 	void _from_string() {};
+	/*! Set the traits kept in the members of a derived vertex class, e.g. rgb, to a weighted sum of the
+	    ones of other vertices, when CDynamicMesh::collapseEdge or subdivide interpolates the vertex; the
+	    trait columns are interpolated by the mesh. This vertex may be one of the others, so the sum is
+	    made before it is stored. Called serially unless CBaseMesh::m_parallel_traits is set.
+	    \param from    the vertices
+	    \param weights their weights, summing to 1
+	    \param n       number of vertices
+	*/
+	template<typename V>
+	void _mix( V ** from, const double * weights, int n ) {};
 
 	/*!	Adjacent edges, temporarily used for loading the mesh
 	 */
@@ -86,6 +99,9 @@ namespace MeshLib{
     /*! Vertex ID. 
 	*/
     int    m_id ;
+	/*! Row in the trait columns.
+	*/
+    int    m_slot;
     /*! Vertex position point. 
 	*/
     CPoint m_point;
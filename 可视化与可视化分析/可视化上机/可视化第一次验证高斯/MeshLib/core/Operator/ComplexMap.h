@@ -0,0 +1,313 @@
+/*!
+*      \file ComplexMap.h
+*      \brief Map the vertices of a mesh by a complex function, z = x + i y  ->  f(z)
+*
+*		f is a polynomial, given by its roots or by its coefficients, a rational
+*		function p(z) / q(z) of two such polynomials, or a Moebius transform
+*		( a z + b ) / ( c z + d ).
+*
+*		The coefficients are evaluated with the Horner scheme, the roots as the
+*		product lead * prod ( z - r_k ), which stays accurate for thousands of roots
+*		where the expanded coefficients would not. The vertices are evaluated in
+*		batches, several SIMD registers at a time ( see SimdMath.h ), on all the threads.
+*/
+
+#ifndef _MESHLIB_COMPLEX_MAP_H_
+#define _MESHLIB_COMPLEX_MAP_H_
+
+#include <complex>
+#include <vector>
+#include <algorithm>
+
+#include "../Geometry/Point.h"
+#include "../Geometry/SimdMath.h"
+#include "../Parallel/Parallel.h"
+
+namespace MeshLib{
+
+/*! the target of the map is v->huv() */
+struct CComplexMapHuv
+{
+	template<typename V>
+	auto operator()( V * v ) const -> decltype( v->huv() ) { return v->huv(); };
+};
+
+/*! the target of the map is v->uv() */
+struct CComplexMapUv
+{
+	template<typename V>
+	auto operator()( V * v ) const -> decltype( v->uv() ) { return v->uv(); };
+};
+
+/*!
+*	\brief CComplexPolynomial, a complex polynomial by its roots or by its coefficients
+*/
+class CComplexPolynomial
+{
+public:
+	/*! CComplexPolynomial constructor, the constant 1 */
+	CComplexPolynomial() { m_roots = false; m_re.push_back( 1.0 ); m_im.push_back( 0.0 ); m_lead_re = 1.0; m_lead_im = 0.0; };
+
+	/*!
+	The polynomial lead * prod ( z - r_k ).
+	\param roots the roots r_k
+	\param lead  the leading coefficient
+	*/
+	static CComplexPolynomial fromRoots( const std::vector< std::complex<double> > & roots, std::complex<double> lead = 1.0 )
+	{
+		CComplexPolynomial p;
+		p.m_roots = true;
+		p._split( roots );
+		p.m_lead_re = lead.real();
+		p.m_lead_im = lead.imag();
+		return p;
+	};
+
+	/*!
+	The polynomial sum c_k z^k.
+	\param coefficients the c_k, constant term first
+	*/
+	static CComplexPolynomial fromCoefficients( const std::vector< std::complex<double> > & coefficients )
+	{
+		CComplexPolynomial p;
+		p.m_roots = false;
+		p._split( coefficients );
+		if( p.m_re.empty() )
+		{
+			p.m_re.push_back( 0.0 );
+			p.m_im.push_back( 0.0 );
+		}
+		return p;
+	};
+
+	/*! degree of the polynomial */
+	int degree() const { return m_roots ? (int) m_re.size() : (int) m_re.size() - 1; };
+
+	/*!
+	Evaluate at K values of V at once, the independent chains keep the pipeline busy.
+	\param x,y the real and imaginary parts of z
+	\param u,v the real and imaginary parts of p(z)
+	*/
+	template<typename V, int K>
+	void evaluate( const V * x, const V * y, V * u, V * v ) const
+	{
+		int n = (int) m_re.size();
+		if( m_roots )
+		{
+			for( int j = 0; j < K; j ++ )
+			{
+				u[j] = simdSet<V>( m_lead_re );
+				v[j] = simdSet<V>( m_lead_im );
+			}
+			for( int k = 0; k < n; k ++ )
+			{
+				const V rr = simdSet<V>( m_re[k] );
+				const V ri = simdSet<V>( m_im[k] );
+				for( int j = 0; j < K; j ++ )
+				{
+					V a = x[j] - rr;
+					V b = y[j] - ri;
+					V t = u[j] * a - v[j] * b;
+					v[j] = u[j] * b + v[j] * a;
+					u[j] = t;
+				}
+			}
+		}
+		else
+		{
+			for( int j = 0; j < K; j ++ )
+			{
+				u[j] = simdSet<V>( m_re[n-1] );
+				v[j] = simdSet<V>( m_im[n-1] );
+			}
+			for( int k = n - 2; k >= 0; k -- )
+			{
+				const V cr = simdSet<V>( m_re[k] );
+				const V ci = simdSet<V>( m_im[k] );
+				for( int j = 0; j < K; j ++ )
+				{
+					V t  = u[j] * x[j] - v[j] * y[j] + cr;
+					v[j] = u[j] * y[j] + v[j] * x[j] + ci;
+					u[j] = t;
+				}
+			}
+		}
+	};
+
+protected:
+	/*! split the complex values into m_re, m_im */
+	void _split( const std::vector< std::complex<double> > & c )
+	{
+		m_re.resize( c.size() );
+		m_im.resize( c.size() );
+		for( size_t k = 0; k < c.size(); k ++ )
+		{
+			m_re[k] = c[k].real();
+			m_im[k] = c[k].imag();
+		}
+	};
+
+	/*! true if m_re, m_im are the roots, false if they are the coefficients */
+	bool                m_roots;
+	/*! real parts of the roots or of the coefficients */
+	std::vector<double> m_re;
+	/*! imaginary parts of the roots or of the coefficients */
+	std::vector<double> m_im;
+	/*! real part of the leading coefficient, for the roots */
+	double              m_lead_re;
+	/*! imaginary part of the leading coefficient, for the roots */
+	double              m_lead_im;
+};
+
+/*!
+*	\brief CComplexMap, the complex function p(z) / q(z) applied to the vertices of a mesh
+*/
+class CComplexMap
+{
+public:
+	/*! CComplexMap constructor, the identity */
+	CComplexMap() { m_numerator = CComplexPolynomial::fromCoefficients( std::vector< std::complex<double> >{ 0.0, 1.0 } ); m_rational = false; };
+
+	/*! the polynomial p(z) */
+	CComplexMap( const CComplexPolynomial & p ) { m_numerator = p; m_rational = false; };
+
+	/*! the rational function p(z) / q(z) */
+	CComplexMap( const CComplexPolynomial & p, const CComplexPolynomial & q ) { m_numerator = p; m_denominator = q; m_rational = true; };
+
+	/*! the polynomial lead * prod ( z - r_k ) */
+	static CComplexMap roots( const std::vector< std::complex<double> > & roots, std::complex<double> lead = 1.0 )
+	{
+		return CComplexMap( CComplexPolynomial::fromRoots( roots, lead ) );
+	};
+
+	/*! the polynomial sum c_k z^k, constant term first */
+	static CComplexMap polynomial( const std::vector< std::complex<double> > & coefficients )
+	{
+		return CComplexMap( CComplexPolynomial::fromCoefficients( coefficients ) );
+	};
+
+	/*! the Moebius transform ( a z + b ) / ( c z + d ) */
+	static CComplexMap mobius( std::complex<double> a, std::complex<double> b, std::complex<double> c, std::complex<double> d )
+	{
+		return CComplexMap( CComplexPolynomial::fromCoefficients( std::vector< std::complex<double> >{ b, a } ),
+		                    CComplexPolynomial::fromCoefficients( std::vector< std::complex<double> >{ d, c } ) );
+	};
+
+	/*!
+	Evaluate n points, a pole gives an infinite or NaN value.
+	\param x,y the real and imaginary parts of z
+	\param u,v the real and imaginary parts of f(z), may be x, y
+	*/
+	void evaluate( const double * x, const double * y, double * u, double * v, size_t n ) const
+	{
+		size_t i = 0;
+#ifdef MESHLIB_AVX
+		for( ; i + 16 <= n; i += 16 ) _evaluate<CSimd4,4>( x + i, y + i, u + i, v + i );
+#endif
+#ifdef MESHLIB_SSE2
+		for( ; i + 8 <= n; i += 8 ) _evaluate<CSimd2,4>( x + i, y + i, u + i, v + i );
+		for( ; i + 2 <= n; i += 2 ) _evaluate<CSimd2,1>( x + i, y + i, u + i, v + i );
+#endif
+		for( ; i < n; i ++ ) _evaluate<double,1>( x + i, y + i, u + i, v + i );
+	};
+
+	/*! f(z) at a single point */
+	std::complex<double> operator()( std::complex<double> z ) const
+	{
+		double x = z.real(), y = z.imag();
+		evaluate( &x, &y, &x, &y, 1 );
+		return std::complex<double>( x, y );
+	};
+
+	/*!
+	Map the point ( x, y ) of every vertex, the result goes to target( v )[0], target( v )[1].
+	\param pMesh   the mesh
+	\param target  functor called as target( CVertex * ), CComplexMapHuv() or CComplexMapUv()
+	\param threads number of threads, 0 for all the hardware threads
+	*/
+	template<typename M, typename Target>
+	void apply( M * pMesh, Target target, int threads = 0 ) const
+	{
+		//vertices per block, the coordinates of a block are contiguous
+		const size_t block = 256;
+
+		std::vector<M::CVertex*> verts( pMesh->vertices().begin(), pMesh->vertices().end() );
+		size_t blocks = ( verts.size() + block - 1 ) / block;
+		if( blocks == 0 ) return;
+
+		parallelFor( blocks, std::min( parallelThreads( threads ), (int) blocks ), [&]( size_t b, size_t e, int )
+		{
+			std::vector<double> x( block ), y( block );
+			for( size_t k = b; k < e; k ++ )
+			{
+				size_t v0 = k * block;
+				size_t n  = std::min( verts.size(), v0 + block ) - v0;
+
+				for( size_t j = 0; j < n; j ++ )
+				{
+					CPoint & p = verts[v0+j]->point();
+					x[j] = p[0];
+					y[j] = p[1];
+				}
+				evaluate( &x[0], &y[0], &x[0], &y[0], n );
+				for( size_t j = 0; j < n; j ++ )
+				{
+					target( verts[v0+j] )[0] = x[j];
+					target( verts[v0+j] )[1] = y[j];
+				}
+			}
+		});
+	};
+
+protected:
+	/*! evaluate K registers of V, p(z) / q(z) */
+	template<typename V, int K>
+	void _evaluate( const double * x, const double * y, double * u, double * v ) const
+	{
+		const int w = sizeof( V ) / sizeof( double );
+		V zx[K], zy[K], pu[K], pv[K];
+		for( int j = 0; j < K; j ++ )
+		{
+			zx[j] = _load<V>( x + j * w );
+			zy[j] = _load<V>( y + j * w );
+		}
+		m_numerator.evaluate<V,K>( zx, zy, pu, pv );
+		if( m_rational )
+		{
+			V qu[K], qv[K];
+			m_denominator.evaluate<V,K>( zx, zy, qu, qv );
+			for( int j = 0; j < K; j ++ )
+			{
+				//( pu + i pv ) / ( qu + i qv )
+				V d  = qu[j] * qu[j] + qv[j] * qv[j];
+				V t  = ( pu[j] * qu[j] + pv[j] * qv[j] ) / d;
+				pv[j] = ( pv[j] * qu[j] - pu[j] * qv[j] ) / d;
+				pu[j] = t;
+			}
+		}
+		for( int j = 0; j < K; j ++ )
+		{
+			_store( pu[j], u + j * w );
+			_store( pv[j], v + j * w );
+		}
+	};
+
+	/*! load the lanes of V */
+	template<typename V> static V _load( const double * p )	{ return V::load( p ); };
+	/*! store the lanes of V */
+	template<typename V> static void _store( V a, double * p )	{ a.store( p ); };
+
+	/*! the numerator p */
+	CComplexPolynomial m_numerator;
+	/*! the denominator q */
+	CComplexPolynomial m_denominator;
+	/*! true for p / q, false for p */
+	bool               m_rational;
+};
+
+template<> inline double CComplexMap::_load<double>( const double * p )	{ return *p; };
+template<> inline void CComplexMap::_store<double>( double a, double * p )	{ *p = a; };
+
+}//name space MeshLib
+
+#endif //_MESHLIB_COMPLEX_MAP_H_ defined
@@ -0,0 +1,256 @@
+/*!
+*      \file Curvature.h
+*      \brief Discrete Gaussian curvature of a triangle mesh, on several threads
+*
+*		The curvature of a vertex is its angle deficit, 2 pi ( pi on the boundary )
+*		minus the corner angles around it. The lengths and the corner angles come
+*		from a CGeometryCache, each computed once and possibly shared with other
+*		tools, and the deficits are summed per vertex from the corner angles.
+*		The total curvature is a deterministic sum, the same for any thread count.
+*		CIndexMesh has its own version, over the handle arrays.
+*/
+
+#ifndef _MESHLIB_CURVATURE_H_
+#define _MESHLIB_CURVATURE_H_
+
+#include <math.h>
+#include <vector>
+
+#include "../Mesh/BaseMesh.h"
+#include "../Mesh/TraitColumns.h"
+#include "../Mesh/iterators.h"
+#include "../Mesh/IndexMesh.h"
+#include "../Geometry/SimdMath.h"
+#include "../Parallel/Parallel.h"
+#include "../Parallel/Reduce.h"
+#include "GeometryCache.h"
+
+#ifndef PI
+#define PI 3.14159265358979323846
+#endif
+
+namespace MeshLib{
+
+/*!
+*	\brief CCurvature, Gaussian curvature of the vertices and the Gauss-Bonnet check
+*
+*	The lengths and the angles are read from the geometry cache. The vertex
+*	curvatures are kept in a column indexed by the vertex slots, a trait column of
+*	the mesh if a key is given, so that they are written with the mesh.
+*	\tparam M a CBaseMesh of triangles
+*/
+template<typename M>
+class CCurvature
+{
+public:
+	/*!
+	CCurvature constructor, with a geometry cache of its own, recomputed by every compute()
+	\param pMesh the mesh
+	\param key   key of the vertex trait column of the curvatures, NULL for a column of its own
+	*/
+	CCurvature( M * pMesh, const char * key = NULL );
+	/*!
+	CCurvature constructor, sharing the lengths and the angles of a cache, which the
+	caller invalidates when the mesh changes
+	\param pMesh the mesh
+	\param cache the geometry cache of the mesh
+	\param key   key of the vertex trait column of the curvatures, NULL for a column of its own
+	*/
+	CCurvature( M * pMesh, CGeometryCache<M> * cache, const char * key = NULL );
+	/*! CCurvature destructor */
+	~CCurvature() { if( m_own_cache ) delete m_cache; if( m_own_k ) delete m_k; };
+
+	/*!
+	Compute the vertex curvatures, the lengths and the angles are taken from the
+	cache, computed there if needed; a cache of its own is invalidated first, so
+	the vertices may have moved since the last call.
+	\param threads number of threads, 0 for all the hardware threads
+	*/
+	void compute( int threads = 0 );
+
+	/*! Gaussian curvature of a vertex */
+	double & k( typename M::CVertex * v ) { return (*m_k)( v ); };
+	/*! Gaussian curvatures of the vertices, indexed by the vertex slots */
+	CTraitColumn<double> & k() { return *m_k; };
+	/*! length of an edge */
+	double length( typename M::CEdge * e ) { return m_cache->length( e ); };
+	/*! corner angle at the target of a halfedge, in its face */
+	double angle( typename M::CHalfEdge * h ) { return m_cache->angle( h ); };
+
+	/*! total Gaussian curvature */
+	double total() { return m_total; };
+	/*! Euler characteristic V - E + F */
+	int    euler() { return m_pMesh->numVertices() - m_pMesh->numEdges() + m_pMesh->numFaces(); };
+	/*! total curvature minus 2 pi times the Euler characteristic, zero by Gauss-Bonnet */
+	double error() { return m_total - 2 * PI * euler(); };
+
+protected:
+	/*! the mesh */
+	M *                    m_pMesh;
+	/*! vertex curvatures */
+	CTraitColumn<double> * m_k;
+	/*! lengths and angles */
+	CGeometryCache<M> *    m_cache;
+	/*! true if m_cache was created by this object */
+	bool                   m_own_cache;
+	/*! true if m_k is not a trait column of the mesh */
+	bool                   m_own_k;
+	/*! total curvature */
+	double                 m_total;
+
+private:
+	/*! not copyable, the cache and the column may be owned */
+	CCurvature( const CCurvature & );
+	CCurvature & operator=( const CCurvature & );
+};
+
+template<typename M>
+CCurvature<M>::CCurvature( M * pMesh, const char * key )
+{
+	m_pMesh = pMesh;
+	m_own_k = ( key == NULL );
+	m_k     = m_own_k ? new CTraitColumn<double>( "K", 0.0 ) : &pMesh->vertexTraits().template add<double>( key );
+	m_total = 0;
+	m_cache = new CGeometryCache<M>( pMesh );
+	m_own_cache = true;
+};
+
+template<typename M>
+CCurvature<M>::CCurvature( M * pMesh, CGeometryCache<M> * cache, const char * key )
+{
+	m_pMesh = pMesh;
+	m_own_k = ( key == NULL );
+	m_k     = m_own_k ? new CTraitColumn<double>( "K", 0.0 ) : &pMesh->vertexTraits().template add<double>( key );
+	m_total = 0;
+	m_cache = cache;
+	m_own_cache = false;
+};
+
+template<typename M>
+void CCurvature<M>::compute( int threads )
+{
+	threads = parallelThreads( threads );
+
+	//nobody else can invalidate the own cache
+	if( m_own_cache ) m_cache->invalidate();
+	const std::vector<double> & angle = m_cache->angles();
+	m_k->resize( m_pMesh->vertexTraits().size() );
+
+	std::vector<M::CVertex*> verts( m_pMesh->vertices().begin(), m_pMesh->vertices().end() );
+	parallelFor( verts.size(), threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ )
+		{
+			M::CVertex * pV = verts[i];
+			double k = m_pMesh->isBoundary( pV )? PI : 2 * PI;
+			for( M::VertexInHalfedgeIterator vh( m_pMesh, pV ); !vh.end(); ++ vh )
+			{
+				k -= angle[(*vh)->slot()];
+			}
+			(*m_k)( pV ) = k;
+		}
+	});
+
+	m_total = parallelSum( verts.size(), threads, 0.0, [&]( size_t i ) { return (*m_k)( verts[i] ); } );
+};
+
+/*!
+*	\brief CCurvature of a CIndexMesh, through the handle interface
+*
+*	The same passes over the handle arrays: the lengths by edge, the corner angles
+*	by halfedge and the deficits by vertex, all indexed by the handles.
+*/
+template<>
+class CCurvature<CIndexMesh>
+{
+public:
+	/*!
+	CCurvature constructor
+	\param pMesh the mesh
+	*/
+	CCurvature( CIndexMesh * pMesh ) { m_pMesh = pMesh; m_total = 0; };
+
+	/*!
+	Compute the edge lengths, the corner angles and the vertex curvatures.
+	\param threads number of threads, 0 for all the hardware threads
+	*/
+	void compute( int threads = 0 );
+
+	/*! Gaussian curvature of a vertex */
+	double & k( CIndexVertex * v ) { return m_k[v->index()]; };
+	/*! Gaussian curvatures of the vertices, indexed by the vertex handles */
+	std::vector<double> & k() { return m_k; };
+	/*! length of an edge */
+	double length( CIndexEdge * e ) { return m_length[e->index()]; };
+	/*! corner angle at the target of a halfedge, in its face */
+	double angle( CIndexHalfEdge * h ) { return m_angle[h->index()]; };
+
+	/*! total Gaussian curvature */
+	double total() { return m_total; };
+	/*! Euler characteristic V - E + F */
+	int    euler() { return m_pMesh->numVertices() - m_pMesh->numEdges() + m_pMesh->numFaces(); };
+	/*! total curvature minus 2 pi times the Euler characteristic, zero by Gauss-Bonnet */
+	double error() { return m_total - 2 * PI * euler(); };
+
+protected:
+	/*! the mesh */
+	CIndexMesh *        m_pMesh;
+	/*! edge lengths */
+	std::vector<double> m_length;
+	/*! corner angles */
+	std::vector<double> m_angle;
+	/*! vertex curvatures */
+	std::vector<double> m_k;
+	/*! total curvature */
+	double              m_total;
+};
+
+inline void CCurvature<CIndexMesh>::compute( int threads )
+{
+	threads = parallelThreads( threads );
+	CIndexMesh * pMesh = m_pMesh;
+
+	m_length.resize( pMesh->numEdges() );
+	parallelFor( m_length.size(), threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ ) m_length[i] = pMesh->e_length( (tIndex) i );
+	});
+
+	//the angle at the target is opposite to the previous edge
+	m_angle.resize( pMesh->numHalfEdges() );
+	parallelFor( m_angle.size(), threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ )
+		{
+			tIndex he = (tIndex) i;
+			m_angle[i] = cosineLawFast( m_length[pMesh->he_edge( he )], m_length[pMesh->he_edge( pMesh->he_next( he ) )],
+										m_length[pMesh->he_edge( pMesh->he_prev( he ) )] );
+		}
+	});
+
+	m_k.resize( pMesh->numVertices() );
+	parallelFor( m_k.size(), threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ )
+		{
+			tIndex v = (tIndex) i;
+			double k = pMesh->v_boundary( v )? PI : 2 * PI;
+			//clw from the most ccw in halfedge
+			tIndex start = pMesh->v_halfedge( v );
+			tIndex he    = start;
+			while( he != INDEX_NULL )
+			{
+				k -= m_angle[he];
+				he = pMesh->he_clw_rotate_about_target( he );
+				if( he == start ) break;
+			}
+			m_k[i] = k;
+		}
+	});
+
+	m_total = parallelSum( m_k.size(), threads, 0.0, [&]( size_t i ) { return m_k[i]; } );
+};
+
+}//name space MeshLib
+
+#endif //_MESHLIB_CURVATURE_H_ defined
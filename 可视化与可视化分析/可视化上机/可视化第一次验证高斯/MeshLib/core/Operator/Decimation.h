@@ -0,0 +1,311 @@
+/*!
+*      \file Decimation.h
+*      \brief Simplification of a triangle mesh by edge collapses, ordered by the quadric error metric
+*
+*		Every vertex carries the quadric of the planes of its faces, weighted by their areas
+*		( Garland and Heckbert ). An edge collapses to the point which minimizes the sum of
+*		the quadrics of its end vertices, and its cost is the quadric error at that point.
+*		The edges wait in a priority queue by cost. An entry carries the stamp of its edge
+*		at the time it was pushed, so an edge is updated by pushing it again with a new
+*		stamp and its stale entries are skipped when they come out.
+*
+*		The boundary is kept exactly: a boundary vertex is neither moved nor removed, so
+*		the boundary loops ( see Mesh/boundary.h ) are unchanged. A collapse which breaks
+*		the link condition or flips a face is refused, the edge comes back when one of its
+*		end vertices moves. The uv, the normal and the vertex trait columns of the kept
+*		vertex are interpolated, see CDynamicMesh::collapseEdge.
+*/
+
+#ifndef _MESHLIB_DECIMATION_H_
+#define _MESHLIB_DECIMATION_H_
+
+#include <float.h>
+#include <math.h>
+#include <vector>
+#include <queue>
+#include <algorithm>
+
+#include "../Geometry/Point.h"
+#include "../Mesh/DynamicMesh.h"
+#include "../Mesh/iterators.h"
+#include "../Parallel/Parallel.h"
+
+namespace MeshLib{
+
+/*!
+*	\brief CQuadric, the symmetric 4x4 matrix of a sum of squared distances to planes
+*
+*	Stored as the upper triangle, a[0..5] the 3x3 block xx xy xz yy yz zz, a[6..8]
+*	the linear part and a[9] the constant.
+*/
+struct CQuadric
+{
+	/*! the coefficients */
+	double a[10];
+
+	/*! CQuadric constructor, zero */
+	CQuadric() { for( int i = 0; i < 10; i ++ ) a[i] = 0; };
+
+	/*! the squared distance to the plane n . x + d = 0, times w */
+	CQuadric( const CPoint & n, double d, double w )
+	{
+		a[0] = w * n[0] * n[0]; a[1] = w * n[0] * n[1]; a[2] = w * n[0] * n[2];
+		a[3] = w * n[1] * n[1]; a[4] = w * n[1] * n[2]; a[5] = w * n[2] * n[2];
+		a[6] = w * n[0] * d;    a[7] = w * n[1] * d;    a[8] = w * n[2] * d;
+		a[9] = w * d * d;
+	};
+
+	/*! add a quadric */
+	CQuadric & operator+=( const CQuadric & q ) { for( int i = 0; i < 10; i ++ ) a[i] += q.a[i]; return *this; };
+
+	/*! the value at p */
+	double operator()( const CPoint & p ) const
+	{
+		double x = p[0], y = p[1], z = p[2];
+		return a[0] * x * x + 2 * a[1] * x * y + 2 * a[2] * x * z
+		     + a[3] * y * y + 2 * a[4] * y * z + a[5] * z * z
+		     + 2 * ( a[6] * x + a[7] * y + a[8] * z ) + a[9];
+	};
+
+	/*!
+	The minimum point, solving the 3x3 system by Cramer's rule.
+	\return false if the system is close to singular
+	*/
+	bool minimize( CPoint & p ) const
+	{
+		double c00 = a[3] * a[5] - a[4] * a[4];
+		double c01 = a[2] * a[4] - a[1] * a[5];
+		double c02 = a[1] * a[4] - a[2] * a[3];
+		double det = a[0] * c00 + a[1] * c01 + a[2] * c02;
+		double scale = a[0] + a[3] + a[5];
+		if( !( fabs( det ) > 1e-12 * scale * scale * scale ) ) return false;
+
+		double c11 = a[0] * a[5] - a[2] * a[2];
+		double c12 = a[1] * a[2] - a[0] * a[4];
+		double c22 = a[0] * a[3] - a[1] * a[1];
+		p[0] = -( c00 * a[6] + c01 * a[7] + c02 * a[8] ) / det;
+		p[1] = -( c01 * a[6] + c11 * a[7] + c12 * a[8] ) / det;
+		p[2] = -( c02 * a[6] + c12 * a[7] + c22 * a[8] ) / det;
+		return true;
+	};
+};
+
+/*!
+*	\brief CDecimation, quadric error metric decimation of a CDynamicMesh
+*	\tparam M a CDynamicMesh of triangles
+*/
+template<typename M>
+class CDecimation
+{
+public:
+	/*!
+	CDecimation constructor
+	\param pMesh the mesh
+	*/
+	CDecimation( M * pMesh ) { m_pMesh = pMesh; m_error = 0; };
+
+	/*!
+	Collapse the cheapest edges until the mesh has at most faces faces, or the cheapest
+	collapse has a larger error than error.
+	\param faces   target number of faces
+	\param error   largest quadric error of a collapse
+	\param threads number of threads of the quadrics and the first costs, 0 for all the hardware threads
+	\return number of collapses
+	*/
+	int decimate( int faces, double error = DBL_MAX, int threads = 0 );
+
+	/*! the largest error of the collapses so far */
+	double error() { return m_error; };
+
+protected:
+	/*! an entry of the queue, the cheapest comes first */
+	struct CEntry
+	{
+		double cost;
+		int    slot;
+		int    stamp;
+		bool operator<( const CEntry & e ) const { return cost > e.cost || ( cost == e.cost && slot > e.slot ); };
+	};
+
+	/*! the target point, the kept vertex and the cost of an edge, false if it may not collapse */
+	bool _target( typename M::CEdge * pE, CPoint & p, typename M::CVertex * & keep, double & cost );
+	/*! whether moving pV to p flips or degenerates one of its faces which does not contain pW */
+	bool _flips( typename M::CVertex * pV, typename M::CVertex * pW, const CPoint & p );
+	/*! push an edge with a new stamp */
+	void _push( typename M::CEdge * pE );
+
+	/*! the mesh */
+	M *                                  m_pMesh;
+	/*! quadric of each vertex, by slot */
+	std::vector<CQuadric>                m_quadric;
+	/*! edge of each slot, NULL once collapsed */
+	std::vector<typename M::CEdge*>      m_edge;
+	/*! stamp of each edge, by slot */
+	std::vector<int>                     m_stamp;
+	/*! the queue */
+	std::priority_queue<CEntry>          m_queue;
+	/*! largest error of the collapses */
+	double                               m_error;
+};
+
+template<typename M>
+int CDecimation<M>::decimate( int faces, double error, int threads )
+{
+	threads = parallelThreads( threads );
+
+	//quadrics of the faces, then of the vertices
+	std::vector<M::CFace*> fs( m_pMesh->faces().begin(), m_pMesh->faces().end() );
+	std::vector<CQuadric>  fq( m_pMesh->faceTraits().size() );
+	parallelFor( fs.size(), threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ )
+		{
+			M::CHalfEdge * h = (M::CHalfEdge*) fs[i]->halfedge();
+			CPoint p0 = h->source()->point(), p1 = h->target()->point(), p2 = h->he_next()->target()->point();
+			CPoint n = ( p1 - p0 ) ^ ( p2 - p0 );
+			double area = n.norm();
+			if( area > 0 ) fq[fs[i]->slot()] = CQuadric( n / area, -( n * p0 ) / area, area / 2 );
+		}
+	});
+
+	std::vector<M::CVertex*> vs( m_pMesh->vertices().begin(), m_pMesh->vertices().end() );
+	m_quadric.assign( m_pMesh->vertexTraits().size(), CQuadric() );
+	parallelFor( vs.size(), threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ )
+		{
+			for( M::VertexInHalfedgeIterator vh( m_pMesh, vs[i] ); !vh.end(); ++ vh )
+			{
+				m_quadric[vs[i]->slot()] += fq[(*vh)->face()->slot()];
+			}
+		}
+	});
+
+	//first costs
+	std::vector<M::CEdge*> es( m_pMesh->edges().begin(), m_pMesh->edges().end() );
+	m_edge.assign( m_pMesh->edgeTraits().size(), (M::CEdge*) NULL );
+	m_stamp.assign( m_pMesh->edgeTraits().size(), 0 );
+	std::vector<CEntry> entries( es.size() );
+	std::vector<char>   valid( es.size(), 0 );
+	parallelFor( es.size(), threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ )
+		{
+			m_edge[es[i]->slot()] = es[i];
+			CPoint p;
+			M::CVertex * keep;
+			entries[i].slot  = es[i]->slot();
+			entries[i].stamp = 0;
+			valid[i] = _target( es[i], p, keep, entries[i].cost );
+		}
+	});
+	std::vector<CEntry> heap;
+	heap.reserve( es.size() );
+	for( size_t i = 0; i < es.size(); i ++ ) if( valid[i] ) heap.push_back( entries[i] );
+	m_queue = std::priority_queue<CEntry>( std::less<CEntry>(), heap );
+
+	int count   = m_pMesh->numFaces();
+	int collapses = 0;
+	while( count > faces && !m_queue.empty() )
+	{
+		CEntry top = m_queue.top();
+		m_queue.pop();
+		M::CEdge * pE = m_edge[top.slot];
+		if( pE == NULL || top.stamp != m_stamp[top.slot] ) continue;
+		if( top.cost > error ) break;
+
+		CPoint p;
+		M::CVertex * keep;
+		double cost;
+		if( !_target( pE, p, keep, cost ) || !m_pMesh->collapsible( pE ) ) continue;
+		M::CVertex * gone = ( m_pMesh->edgeVertex1( pE ) == keep )? m_pMesh->edgeVertex2( pE ) : m_pMesh->edgeVertex1( pE );
+		if( _flips( keep, gone, p ) || _flips( gone, keep, p ) ) continue;
+
+		//the edges which go away with the collapse: the edge and the edges at gone of its faces
+		for( int k = 0; k < 2; k ++ )
+		{
+			M::CHalfEdge * h = m_pMesh->edgeHalfedge( pE, k );
+			if( h == NULL ) continue;
+			M::CHalfEdge * n = m_pMesh->halfedgeNext( h );
+			M::CHalfEdge * q = m_pMesh->halfedgePrev( h );
+			M::CEdge     * d = m_pMesh->halfedgeEdge( ( m_pMesh->halfedgeSource( n ) == gone )? n : q );
+			m_edge[d->slot()] = NULL;
+			count --;
+		}
+		m_edge[pE->slot()] = NULL;
+
+		CQuadric q = m_quadric[gone->slot()];
+		m_pMesh->collapseEdge( pE, keep, p, false );
+		m_quadric[keep->slot()] += q;
+		m_error = std::max( m_error, cost );
+		collapses ++;
+
+		for( M::VertexEdgeIterator ve( keep ); !ve.end(); ++ ve ) _push( *ve );
+	}
+
+	m_pMesh->sweep();
+	m_queue = std::priority_queue<CEntry>();
+	return collapses;
+};
+
+template<typename M>
+bool CDecimation<M>::_target( typename M::CEdge * pE, CPoint & p, typename M::CVertex * & keep, double & cost )
+{
+	M::CVertex * a = m_pMesh->edgeVertex1( pE );
+	M::CVertex * b = m_pMesh->edgeVertex2( pE );
+	if( a->boundary() && b->boundary() ) return false;
+
+	CQuadric q = m_quadric[a->slot()];
+	q += m_quadric[b->slot()];
+
+	if( a->boundary() || b->boundary() )
+	{
+		keep = a->boundary()? a : b;
+		p    = keep->point();
+	}
+	else
+	{
+		CPoint pa = a->point(), pb = b->point(), pm = ( pa + pb ) / 2;
+		if( !q.minimize( p ) )
+		{
+			p = pm;
+			if( q( pa ) < q( p ) ) p = pa;
+			if( q( pb ) < q( p ) ) p = pb;
+		}
+		keep = ( ( p - pa ).norm() <= ( p - pb ).norm() )? a : b;
+	}
+	cost = std::max( q( p ), 0.0 );
+	return true;
+};
+
+template<typename M>
+bool CDecimation<M>::_flips( typename M::CVertex * pV, typename M::CVertex * pW, const CPoint & p )
+{
+	for( M::VertexInHalfedgeIterator vh( m_pMesh, pV ); !vh.end(); ++ vh )
+	{
+		M::CHalfEdge * h = *vh;
+		M::CVertex   * x = m_pMesh->halfedgeSource( h );
+		M::CVertex   * y = m_pMesh->halfedgeTarget( m_pMesh->halfedgeNext( h ) );
+		if( x == pW || y == pW ) continue;
+
+		CPoint n0 = ( pV->point() - x->point() ) ^ ( y->point() - x->point() );
+		CPoint n1 = ( p - x->point() ) ^ ( y->point() - x->point() );
+		if( !( n0 * n1 > 1e-12 * n0.norm() * n0.norm() ) ) return true;
+	}
+	return false;
+};
+
+template<typename M>
+void CDecimation<M>::_push( typename M::CEdge * pE )
+{
+	CEntry entry;
+	entry.slot  = pE->slot();
+	entry.stamp = ++ m_stamp[pE->slot()];
+	CPoint p;
+	M::CVertex * keep;
+	if( _target( pE, p, keep, entry.cost ) ) m_queue.push( entry );
+};
+
+}//name space MeshLib
+
+#endif //_MESHLIB_DECIMATION_H_ defined
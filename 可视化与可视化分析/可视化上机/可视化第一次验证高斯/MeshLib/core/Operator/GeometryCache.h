@@ -0,0 +1,454 @@
+/*!
+*      \file GeometryCache.h
+*      \brief Derived geometry of a mesh, computed on first request and shared
+*
+*		Edge lengths, corner angles, face areas and normals, vertex areas and
+*		normals are kept in contiguous arrays indexed by the element slots. Each
+*		quantity is computed for the whole mesh, on several threads, the first time
+*		it is requested, and kept until the positions change:
+*
+*			invalidate()        everything, e.g. after moving many vertices
+*			invalidate( v )     the one-ring of a moved vertex
+*			invalidateDirty()   the elements marked by the CDynamicMesh edits
+*
+*		A local invalidation is applied to the computed quantities at the next
+*		request, only the stale elements are recomputed. When elements are deleted
+*		the cache has to be told before the next request, the stale elements may be
+*		among them:
+*
+*			remap( r )          after deleteFaces, with the slots r it returns
+*			prune()             after CDynamicMesh::sweep, e.g. after collapseEdge
+*
+*		The accessors may be called from several threads, the invalidations may
+*		not run concurrently with them.
+*/
+
+#ifndef _MESHLIB_GEOMETRY_CACHE_H_
+#define _MESHLIB_GEOMETRY_CACHE_H_
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+
+#include "../Geometry/Point.h"
+#include "../Geometry/SimdMath.h"
+#include "../Mesh/iterators.h"
+#include "../Parallel/Parallel.h"
+
+namespace MeshLib{
+
+/*!
+	Corner angles of triangles by the cosine law. The faces are taken in blocks, the
+	lengths and the angles of a block are contiguous, so that the angles are computed
+	by the batched cosineLawBatch. Shared by CGeometryCache and COperator.
+	\param pMesh  the mesh
+	\param faces  the faces
+	\param n      number of faces
+	\param length functor called as length( edge ), the length of an edge
+	\param store  functor called as store( halfedge, angle ), the angle at the target of the halfedge
+*/
+template<typename M, typename Length, typename Store>
+void cornerAngles( M * pMesh, typename M::CFace * const * faces, size_t n, Length length, Store store )
+{
+	const size_t block = 256;
+	std::vector<M::CHalfEdge*> he( 3 * block );
+	std::vector<double> l( 3 * block );
+	std::vector<double> angle( 3 * block );
+
+	for( size_t f0 = 0; f0 < n; f0 += block )
+	{
+		size_t m = std::min( n - f0, block );
+
+		//gather, l[i*block+j] is the length of the edge of he[i] in face j
+		for( size_t j = 0; j < m; j ++ )
+		{
+			M::CHalfEdge * h = pMesh->faceMostCcwHalfEdge( faces[f0+j] );
+			for( int i = 0; i < 3; i ++ )
+			{
+				he[i*block+j] = h;
+				l[i*block+j]  = length( pMesh->halfedgeEdge( h ) );
+				h = pMesh->faceNextCcwHalfEdge( h );
+			}
+		}
+
+		//the angle at he[(i+1)%3] is opposite to the edge of he[i]
+		for( int i = 0; i < 3; i ++ )
+		{
+			cosineLawBatch( &l[( (i+1)%3 )*block], &l[( (i+2)%3 )*block], &l[i*block], &angle[( (i+1)%3 )*block], m );
+		}
+
+		for( int i = 0; i < 3; i ++ )
+		{
+			for( size_t j = 0; j < m; j ++ ) store( he[i*block+j], angle[i*block+j] );
+		}
+	}
+};
+
+/*!
+*	\brief CGeometryCache, lazily computed edge lengths, corner angles, areas and normals
+*	\tparam M a CBaseMesh of triangles
+*/
+template<typename M>
+class CGeometryCache
+{
+public:
+	/*! the cached quantities */
+	enum { LENGTH, ANGLE, FACE_AREA, FACE_NORMAL, VERTEX_AREA, VERTEX_NORMAL, QUANTITIES };
+
+	/*!
+	CGeometryCache constructor, nothing is computed yet
+	\param pMesh   the mesh
+	\param threads number of threads, 0 for all the hardware threads
+	*/
+	CGeometryCache( M * pMesh, int threads = 0 );
+
+	/*! length of an edge */
+	double length( typename M::CEdge * e )			{ _ensure( LENGTH ); return m_length[e->slot()]; };
+	/*! corner angle at the target of a halfedge, in its face */
+	double angle( typename M::CHalfEdge * h )		{ _ensure( ANGLE ); return m_angle[h->slot()]; };
+	/*! area of a face */
+	double area( typename M::CFace * f )			{ _ensure( FACE_AREA ); return m_face_area[f->slot()]; };
+	/*! unit normal of a face */
+	const CPoint & normal( typename M::CFace * f )	{ _ensure( FACE_NORMAL ); return m_face_normal[f->slot()]; };
+	/*! a third of the area of the faces around a vertex */
+	double area( typename M::CVertex * v )			{ _ensure( VERTEX_AREA ); return m_vertex_area[v->slot()]; };
+	/*! unit normal of a vertex, the normalized sum of the normals of its faces */
+	const CPoint & normal( typename M::CVertex * v )	{ _ensure( VERTEX_NORMAL ); return m_vertex_normal[v->slot()]; };
+
+	/*! the edge lengths, by edge slot */
+	const std::vector<double> & lengths()			{ _ensure( LENGTH ); return m_length; };
+	/*! the corner angles, by halfedge slot */
+	const std::vector<double> & angles()			{ _ensure( ANGLE ); return m_angle; };
+	/*! the face areas, by face slot */
+	const std::vector<double> & faceAreas()			{ _ensure( FACE_AREA ); return m_face_area; };
+	/*! the face normals, by face slot */
+	const std::vector<CPoint> & faceNormals()		{ _ensure( FACE_NORMAL ); return m_face_normal; };
+	/*! the vertex areas, by vertex slot */
+	const std::vector<double> & vertexAreas()		{ _ensure( VERTEX_AREA ); return m_vertex_area; };
+	/*! the vertex normals, by vertex slot */
+	const std::vector<CPoint> & vertexNormals()		{ _ensure( VERTEX_NORMAL ); return m_vertex_normal; };
+
+	/*! Forget all the quantities, they are recomputed at the next request */
+	void invalidate();
+	/*! A vertex has moved, its edges and faces are stale */
+	void invalidate( typename M::CVertex * v );
+	/*! The elements in the dirty lists of a CDynamicMesh are stale, call it before clearDirty() */
+	void invalidateDirty();
+	/*!
+	Elements have been deleted and the slots compacted, e.g. by deleteFaces: the quantities move to
+	the new slots and the deleted elements are dropped from the stale ones, O(n)
+	\param remap the new slots, as returned by deleteFaces
+	*/
+	void remap( const typename M::CSlotRemap & remap );
+	/*! Elements have been deleted, e.g. by CDynamicMesh::sweep: the deleted elements are dropped
+	 *  from the stale ones without being read, O(n) */
+	void prune();
+
+protected:
+	/*! the mesh */
+	M *                                  m_pMesh;
+	/*! number of threads */
+	int                                  m_threads;
+	/*! the quantity has been computed */
+	bool                                 m_valid[QUANTITIES];
+	/*! the quantity is computed and up to date, read without the lock */
+	std::atomic<bool>                    m_ready[QUANTITIES];
+	/*! serializes the computations */
+	std::mutex                           m_lock;
+
+	/*! edge lengths */
+	std::vector<double>                  m_length;
+	/*! corner angles */
+	std::vector<double>                  m_angle;
+	/*! face areas */
+	std::vector<double>                  m_face_area;
+	/*! face normals */
+	std::vector<CPoint>                  m_face_normal;
+	/*! vertex areas */
+	std::vector<double>                  m_vertex_area;
+	/*! vertex normals */
+	std::vector<CPoint>                  m_vertex_normal;
+
+	/*! stale edges */
+	std::vector<typename M::CEdge*>      m_stale_edges;
+	/*! stale faces */
+	std::vector<typename M::CFace*>      m_stale_faces;
+	/*! stale vertices */
+	std::vector<typename M::CVertex*>    m_stale_verts;
+
+	/*! make the quantity q up to date */
+	void _ensure( int q )
+	{
+		if( m_ready[q].load( std::memory_order_acquire ) ) return;
+		std::lock_guard<std::mutex> lock( m_lock );
+		if( m_ready[q].load( std::memory_order_relaxed ) ) return;
+		_refresh();
+		_compute( q );
+		m_ready[q].store( true, std::memory_order_release );
+	};
+
+	/*! compute q and the quantities it depends on, if they are not valid */
+	void _compute( int q );
+	/*! recompute the stale elements of the valid quantities */
+	void _refresh();
+	/*! mark everything as not ready, after an invalidation */
+	void _unready()	{ for( int q = 0; q < QUANTITIES; q ++ ) m_ready[q].store( false ); };
+	/*! move the values indexed by the old slots to the new slots, n slots are kept */
+	template<typename T>
+	static void _remap( std::vector<T> & values, const std::vector<int> & remap, size_t n );
+	/*! keep the stale elements which are still in the element list, the others are only compared */
+	template<typename E, typename C>
+	static void _prune( std::vector<E*> & stale, C & elements );
+
+	/*! angles of the faces, the angle at the target of h[(i+1)%3] is opposite to the edge of h[i] */
+	void _angles( typename M::CFace * const * faces, size_t n );
+	/*! area and normal of a face, a zero normal for a degenerate face */
+	void _face( typename M::CFace * f );
+	/*! area and normal of a vertex, a zero normal for a vertex without a face normal */
+	void _vertex( typename M::CVertex * v );
+};
+
+template<typename M>
+CGeometryCache<M>::CGeometryCache( M * pMesh, int threads )
+{
+	m_pMesh   = pMesh;
+	m_threads = parallelThreads( threads );
+	for( int q = 0; q < QUANTITIES; q ++ )
+	{
+		m_valid[q] = false;
+		m_ready[q].store( false );
+	}
+};
+
+template<typename M>
+void CGeometryCache<M>::invalidate()
+{
+	for( int q = 0; q < QUANTITIES; q ++ ) m_valid[q] = false;
+	m_stale_edges.clear();
+	m_stale_faces.clear();
+	m_stale_verts.clear();
+	_unready();
+};
+
+template<typename M>
+void CGeometryCache<M>::invalidate( typename M::CVertex * v )
+{
+	for( M::VertexEdgeIterator veiter( v ); !veiter.end(); veiter ++ ) m_stale_edges.push_back( *veiter );
+	for( M::VertexFaceIterator vfiter( v ); !vfiter.end(); ++ vfiter )
+	{
+		M::CFace * f = *vfiter;
+		m_stale_faces.push_back( f );
+		for( M::FaceVertexIterator fviter( f ); !fviter.end(); ++ fviter ) m_stale_verts.push_back( *fviter );
+	}
+	_unready();
+};
+
+template<typename M>
+void CGeometryCache<M>::invalidateDirty()
+{
+	m_stale_edges.insert( m_stale_edges.end(), m_pMesh->dirtyEdges().begin(), m_pMesh->dirtyEdges().end() );
+	m_stale_faces.insert( m_stale_faces.end(), m_pMesh->dirtyFaces().begin(), m_pMesh->dirtyFaces().end() );
+	m_stale_verts.insert( m_stale_verts.end(), m_pMesh->dirtyVertices().begin(), m_pMesh->dirtyVertices().end() );
+	_unready();
+};
+
+template<typename M>
+void CGeometryCache<M>::remap( const typename M::CSlotRemap & remap )
+{
+	//the slots only go down, the values are moved in place
+	if( m_valid[LENGTH] )    _remap( m_length, remap.edge, (size_t) m_pMesh->edgeTraits().size() );
+	if( m_valid[ANGLE] )     _remap( m_angle, remap.halfedge, (size_t) m_pMesh->halfedgeTraits().size() );
+	if( m_valid[FACE_AREA] )
+	{
+		_remap( m_face_area, remap.face, (size_t) m_pMesh->faceTraits().size() );
+		_remap( m_face_normal, remap.face, (size_t) m_pMesh->faceTraits().size() );
+	}
+	if( m_valid[VERTEX_AREA] )
+	{
+		_remap( m_vertex_area, remap.vertex, (size_t) m_pMesh->vertexTraits().size() );
+		_remap( m_vertex_normal, remap.vertex, (size_t) m_pMesh->vertexTraits().size() );
+	}
+	prune();
+};
+
+template<typename M>
+void CGeometryCache<M>::prune()
+{
+	_prune( m_stale_edges, m_pMesh->edges() );
+	_prune( m_stale_faces, m_pMesh->faces() );
+	_prune( m_stale_verts, m_pMesh->vertices() );
+};
+
+template<typename M>
+template<typename T>
+void CGeometryCache<M>::_remap( std::vector<T> & values, const std::vector<int> & remap, size_t n )
+{
+	size_t m = std::min( remap.size(), values.size() );
+	for( size_t s = 0; s < m; s ++ ) if( remap[s] >= 0 ) values[remap[s]] = values[s];
+	values.resize( n );
+};
+
+template<typename M>
+template<typename E, typename C>
+void CGeometryCache<M>::_prune( std::vector<E*> & stale, C & elements )
+{
+	if( stale.empty() ) return;
+
+	//a deleted element may not be read, it is looked up by its address among the live ones
+	std::vector<E*> sorted( stale );
+	std::sort( sorted.begin(), sorted.end() );
+	stale.clear();
+	for( typename C::iterator iter = elements.begin(); iter != elements.end(); iter ++ )
+	{
+		if( std::binary_search( sorted.begin(), sorted.end(), *iter ) ) stale.push_back( *iter );
+	}
+};
+
+template<typename M>
+void CGeometryCache<M>::_compute( int q )
+{
+	if( m_valid[q] ) return;
+
+	switch( q )
+	{
+	case LENGTH:
+		{
+			std::vector<M::CEdge*> edges( m_pMesh->edges().begin(), m_pMesh->edges().end() );
+			m_length.resize( m_pMesh->edgeTraits().size() );
+			parallelFor( edges.size(), m_threads, [&]( size_t b, size_t e, int )
+			{
+				for( size_t i = b; i < e; i ++ )
+				{
+					M::CEdge * pE = edges[i];
+					m_length[pE->slot()] = ( m_pMesh->edgeVertex1( pE )->point() - m_pMesh->edgeVertex2( pE )->point() ).norm();
+				}
+			});
+		}
+		break;
+	case ANGLE:
+		{
+			_compute( LENGTH );
+			//faces per block, the lengths and the angles of a block are contiguous
+			const size_t block = 256;
+			std::vector<M::CFace*> faces( m_pMesh->faces().begin(), m_pMesh->faces().end() );
+			size_t blocks = ( faces.size() + block - 1 ) / block;
+			m_angle.resize( m_pMesh->halfedgeTraits().size() );
+			parallelFor( blocks, std::min( m_threads, (int) std::max( blocks, (size_t) 1 ) ), [&]( size_t b, size_t e, int )
+			{
+				for( size_t k = b; k < e; k ++ )
+				{
+					size_t f0 = k * block;
+					_angles( &faces[f0], std::min( faces.size(), f0 + block ) - f0 );
+				}
+			});
+		}
+		break;
+	case FACE_AREA:
+	case FACE_NORMAL:
+		{
+			std::vector<M::CFace*> faces( m_pMesh->faces().begin(), m_pMesh->faces().end() );
+			m_face_area.resize( m_pMesh->faceTraits().size() );
+			m_face_normal.resize( m_pMesh->faceTraits().size() );
+			parallelFor( faces.size(), m_threads, [&]( size_t b, size_t e, int )
+			{
+				for( size_t i = b; i < e; i ++ ) _face( faces[i] );
+			});
+			m_valid[FACE_AREA] = m_valid[FACE_NORMAL] = true;
+		}
+		break;
+	case VERTEX_AREA:
+	case VERTEX_NORMAL:
+		{
+			_compute( FACE_AREA );
+			std::vector<M::CVertex*> verts( m_pMesh->vertices().begin(), m_pMesh->vertices().end() );
+			m_vertex_area.resize( m_pMesh->vertexTraits().size() );
+			m_vertex_normal.resize( m_pMesh->vertexTraits().size() );
+			parallelFor( verts.size(), m_threads, [&]( size_t b, size_t e, int )
+			{
+				for( size_t i = b; i < e; i ++ ) _vertex( verts[i] );
+			});
+			m_valid[VERTEX_AREA] = m_valid[VERTEX_NORMAL] = true;
+		}
+		break;
+	}
+	m_valid[q] = true;
+};
+
+template<typename M>
+void CGeometryCache<M>::_refresh()
+{
+	if( m_stale_edges.empty() && m_stale_faces.empty() && m_stale_verts.empty() ) return;
+
+	//the edits may have created elements, with new slots
+	if( m_valid[LENGTH] )
+	{
+		m_length.resize( m_pMesh->edgeTraits().size() );
+		for( size_t i = 0; i < m_stale_edges.size(); i ++ )
+		{
+			M::CEdge * pE = m_stale_edges[i];
+			m_length[pE->slot()] = ( m_pMesh->edgeVertex1( pE )->point() - m_pMesh->edgeVertex2( pE )->point() ).norm();
+		}
+	}
+	if( m_valid[ANGLE] )
+	{
+		m_angle.resize( m_pMesh->halfedgeTraits().size() );
+		if( !m_stale_faces.empty() ) _angles( &m_stale_faces[0], m_stale_faces.size() );
+	}
+	if( m_valid[FACE_AREA] )
+	{
+		m_face_area.resize( m_pMesh->faceTraits().size() );
+		m_face_normal.resize( m_pMesh->faceTraits().size() );
+		for( size_t i = 0; i < m_stale_faces.size(); i ++ ) _face( m_stale_faces[i] );
+	}
+	if( m_valid[VERTEX_AREA] )
+	{
+		m_vertex_area.resize( m_pMesh->vertexTraits().size() );
+		m_vertex_normal.resize( m_pMesh->vertexTraits().size() );
+		for( size_t i = 0; i < m_stale_verts.size(); i ++ ) _vertex( m_stale_verts[i] );
+	}
+
+	m_stale_edges.clear();
+	m_stale_faces.clear();
+	m_stale_verts.clear();
+};
+
+template<typename M>
+void CGeometryCache<M>::_angles( typename M::CFace * const * faces, size_t n )
+{
+	cornerAngles( m_pMesh, faces, n,
+		[&]( typename M::CEdge * e ) { return m_length[e->slot()]; },
+		[&]( typename M::CHalfEdge * h, double a ) { m_angle[h->slot()] = a; } );
+};
+
+template<typename M>
+void CGeometryCache<M>::_face( typename M::CFace * f )
+{
+	CPoint p[3];
+	int k = 0;
+	for( M::FaceVertexIterator fviter( f ); !fviter.end() && k < 3; ++ fviter ) p[k++] = (*fviter)->point();
+
+	CPoint fn = ( p[1] - p[0] ) ^ ( p[2] - p[0] );
+	double a  = fn.norm();
+	m_face_area[f->slot()]   = a / 2.0;
+	m_face_normal[f->slot()] = ( a > 0 )? fn / a : fn;
+};
+
+template<typename M>
+void CGeometryCache<M>::_vertex( typename M::CVertex * v )
+{
+	CPoint n( 0, 0, 0 );
+	double s = 0;
+	for( M::VertexFaceIterator vfiter( v ); !vfiter.end(); ++ vfiter )
+	{
+		M::CFace * f = *vfiter;
+		n += m_face_normal[f->slot()];
+		s += m_face_area[f->slot()];
+	}
+	m_vertex_area[v->slot()]   = s / 3;
+	m_vertex_normal[v->slot()] = ( n.norm() > 0 )? n / n.norm() : n;
+};
+
+}//name space MeshLib
+
+#endif //_MESHLIB_GEOMETRY_CACHE_H_ defined
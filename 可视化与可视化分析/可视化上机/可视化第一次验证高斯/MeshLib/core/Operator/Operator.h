@@ -21,6 +21,9 @@
 #include "mesh/iterators.h"
 #include "mesh/boundary.h"
 #include "Parser/parser.h"
+#include "Parallel/Reduce.h"
+#include "Geometry/SimdMath.h"
+#include "Operator/GeometryCache.h"
 
 #ifndef PI
 #define PI 3.14159265358979323846
@@ -46,9 +49,11 @@ public:
 	  ~COperator(){};
 	
 	  /*!
-	   *	Convert the metric structure to angle structure
+	   *	Convert the metric structure to angle structure, the faces are processed
+	   *	in blocks on several threads, the angles with the batched acosFast
+	   *	\param threads number of threads, 0 for all the hardware threads
 	   */
-	  void _metric_2_angle( );
+	  void _metric_2_angle( int threads = 0 );
 	  /*!
 	   *	Convert the embedding structure in R3 to metric structure
 	   */
@@ -75,6 +80,21 @@ public:
 	   */
 
 	  void _combinatorial_Laplace( );
+
+	  /*!
+	   *	Incremental versions of the passes above for a CDynamicMesh: only the
+	   *	elements marked dirty by the edits ( splitFace, splitEdge, swapEdge,
+	   *	markDirty ) and their one-ring are recomputed, then the caller calls
+	   *	m_pMesh->clearDirty(). The results equal those of the whole-mesh passes.
+	   */
+	  /*! lengths of the dirty edges */
+	  void _embedding_2_metric_dirty();
+	  /*! corner angles of the dirty faces */
+	  void _metric_2_angle_dirty();
+	  /*! curvatures of the vertices of the dirty faces */
+	  void _angle_2_curvature_dirty();
+	  /*! cotangent weights of the edges of the dirty faces */
+	  void _angle_2_Laplace_dirty();
 		
 	  /*! 
 	   *	Deform the angle structure by Beltrami coefficient
@@ -189,34 +209,24 @@ double COperator<M>::_cosine_law( double a, double b, double c )
 
 //Calculate corner angle
 template<typename M>
-void COperator<M>::_metric_2_angle( )
+void COperator<M>::_metric_2_angle( int threads )
 {
-  
-	for ( M::MeshFaceIterator fiter( m_pMesh); ! fiter.end(); fiter ++ )
-  {
-	  M::CFace * f = *fiter;
+	//faces per block, the kernel is shared with CGeometryCache
+	const size_t block = 256;
 
-	  M::CHalfEdge * he[3];
+	std::vector<M::CFace*> faces( m_pMesh->faces().begin(), m_pMesh->faces().end() );
+	size_t blocks = ( faces.size() + block - 1 ) / block;
 
-      he[0] = m_pMesh->faceMostCcwHalfEdge( f ); 
-
-	  for( int i = 0; i < 3; i ++ )
-      {
-        he[(i+1)%3] = m_pMesh->	faceNextCcwHalfEdge(he[i]);
-      }
-
-      double l[3];
-      for(int i = 0; i < 3; i ++ )
-      {
-		  M::CEdge * e = m_pMesh->halfedgeEdge( he[i] );
-          l[i] = e->length();
-      }
-
-      for(int i = 0; i < 3; i ++ )
-      {
-          he[(i+1)%3]->angle() = _cosine_law( l[(i+1)%3] ,l[(i+2)%3] ,l[i] );
-      }
-  }
+	parallelFor( blocks, std::min( parallelThreads( threads ), (int) blocks ), [&]( size_t b, size_t e, int )
+	{
+		for( size_t k = b; k < e; k ++ )
+		{
+			size_t f0 = k * block;
+			cornerAngles( m_pMesh, &faces[f0], std::min( faces.size(), f0 + block ) - f0,
+				[]( M::CEdge * pE ) { return pE->length(); },
+				[]( M::CHalfEdge * pH, double a ) { pH->angle() = a; } );
+		}
+	});
 };
 
 template<typename M>
@@ -293,6 +303,88 @@ void COperator<M>::_combinatorial_Laplace( )
 };
 
 
+//incremental updates after CDynamicMesh edits
+
+template<typename M>
+void COperator<M>::_embedding_2_metric_dirty( )
+{
+	std::vector<M::CEdge*> & edges = m_pMesh->dirtyEdges();
+	for( size_t i = 0; i < edges.size(); i ++ )
+	{
+		M::CEdge * e = edges[i];
+		e->length() = ( m_pMesh->edgeVertex1( e )->point() - m_pMesh->edgeVertex2( e )->point() ).norm();
+	}
+};
+
+template<typename M>
+void COperator<M>::_metric_2_angle_dirty( )
+{
+	std::vector<M::CFace*> & faces = m_pMesh->dirtyFaces();
+	for( size_t j = 0; j < faces.size(); j ++ )
+	{
+		M::CHalfEdge * h[3];
+		double l[3];
+		h[0] = m_pMesh->faceMostCcwHalfEdge( faces[j] );
+		for( int i = 0; i < 3; i ++ )
+		{
+			if( i > 0 ) h[i] = m_pMesh->faceNextCcwHalfEdge( h[i-1] );
+			l[i] = m_pMesh->halfedgeEdge( h[i] )->length();
+		}
+		//same kernel and convention as _metric_2_angle
+		for( int i = 0; i < 3; i ++ )
+		{
+			h[(i+1)%3]->angle() = cosineLawFast( l[(i+1)%3], l[(i+2)%3], l[i] );
+		}
+	}
+};
+
+template<typename M>
+void COperator<M>::_angle_2_curvature_dirty( )
+{
+	std::vector<M::CVertex*> & verts = m_pMesh->dirtyVertices();
+	for( size_t j = 0; j < verts.size(); j ++ )
+	{
+		M::CVertex * v = verts[j];
+		double k = ( v->boundary() )? PI : PI * 2;
+		for( M::VertexInHalfedgeIterator vh( m_pMesh, v ); !vh.end(); ++ vh )
+		{
+			M::CHalfEdge * he = *vh;
+			k -= he->angle();
+		}
+		v->k() = k;
+	}
+};
+
+template<typename M>
+void COperator<M>::_angle_2_Laplace_dirty( )
+{
+	//each edge of the dirty faces once: from its first halfedge, or from the
+	//second one when the face of the first one is clean
+	std::vector<M::CFace*> & faces = m_pMesh->dirtyFaces();
+	for( size_t j = 0; j < faces.size(); j ++ )
+	{
+		M::CHalfEdge * h = m_pMesh->faceHalfedge( faces[j] );
+		for( int i = 0; i < 3; i ++, h = m_pMesh->halfedgeNext( h ) )
+		{
+			M::CEdge * e = m_pMesh->halfedgeEdge( h );
+			M::CHalfEdge * he = m_pMesh->edgeHalfedge( e, 0 );
+			if( h != he && m_pMesh->isDirty( m_pMesh->halfedgeFace( he ) ) ) continue;
+
+			M::CHalfEdge * pNh = m_pMesh->faceNextCcwHalfEdge( he );
+			double wt = cos( pNh->angle() )/sin( pNh->angle() );
+
+			M::CHalfEdge * sh = m_pMesh->halfedgeSym( he );
+			if( sh != NULL )
+			{
+				pNh = m_pMesh->faceNextCcwHalfEdge( sh );
+				wt += cos( pNh->angle() )/sin( pNh->angle() );
+			}
+			e->weight() = wt;
+		}
+	}
+};
+
+
 template<typename M>
 void COperator<M>::_parameter_mu_2_metric( )
 {
@@ -808,41 +900,30 @@ void COperator<M>::_calculate_face_vertex_area()
 template<typename M>
 void COperator<M>::_normalize()
 {
-    CPoint s(0,0,0);
-	for( M::MeshVertexIterator viter( m_pMesh ); !viter.end(); ++ viter )
-    {
-		M::CVertex * v = *viter;
-      s = s + v->point();
-    }
+	int threads = parallelThreads( 0 );
+	std::vector<M::CVertex*> verts( m_pMesh->vertices().begin(), m_pMesh->vertices().end() );
+
+	//the sums are deterministic, the same for any thread count
+	CPoint s = parallelSum( verts.size(), threads, CPoint(0,0,0), [&]( size_t i ) { return verts[i]->point(); } );
 
     s = s / m_pMesh->numVertices();
 
-	for( M::MeshVertexIterator viter( m_pMesh ); !viter.end(); ++ viter )
-    {
-		M::CVertex * v = *viter;
-		CPoint p = v->point();
-		p = p-s;
-		v->point() = p;
-    }
-    double d = 0;
+	parallelFor( verts.size(), threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ ) verts[i]->point() = verts[i]->point() - s;
+	});
 
-	for( M::MeshVertexIterator viter( m_pMesh ); !viter.end(); ++ viter )
-    {
-		M::CVertex * v = *viter;
-		CPoint p = v->point();
-		for( int k = 0; k < 3; k ++ )
-		{
-			d = ( d > fabs(p[k]) )?d: fabs(p[k]);
-		}
-    }
+	double d = parallelReduce( verts.size(), threads, 0.0, [&]( size_t i )
+	{
+		CPoint p = verts[i]->point();
+		return std::max( fabs( p[0] ), std::max( fabs( p[1] ), fabs( p[2] ) ) );
+	},
+	[]( double a, double b ) { return ( a > b )? a : b; } );
 
-	for( M::MeshVertexIterator viter( m_pMesh ); !viter.end(); ++ viter )
-    {
-		M::CVertex * v = *viter;
-		CPoint p = v->point();
-		p = p/d;
-		v->point() = p;
-    }
+	parallelFor( verts.size(), threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ ) verts[i]->point() = verts[i]->point() / d;
+	});
 };
 
 template<typename M>
@@ -0,0 +1,122 @@
+/*!
+*      \file Parallel.h
+*      \brief Minimal fork-join helpers on std::thread
+*
+*		The work is always split into the same contiguous chunks for a given thread
+*		count, so the results do not depend on the scheduling.
+*/
+
+#ifndef _MESHLIB_PARALLEL_H_
+#define _MESHLIB_PARALLEL_H_
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <thread>
+
+namespace MeshLib{
+
+/*!
+	Number of threads to use.
+	\param threads requested number of threads, 0 or negative for all the hardware threads
+	\return at least 1
+*/
+inline int parallelThreads( int threads )
+{
+	if( threads > 0 ) return threads;
+	int n = (int) std::thread::hardware_concurrency();
+	return ( n > 0 )? n : 1;
+};
+
+/*!
+	Begin of the chunk t, when [0,n) is split into threads chunks.
+*/
+inline size_t parallelChunk( size_t n, int threads, int t )
+{
+	return (size_t)( (unsigned long long) n * t / threads );
+};
+
+/*!
+	Split [0,n) into threads contiguous chunks and run func( begin, end, t ) on each
+	chunk in its own thread. Chunk 0 runs on the calling thread.
+	\param n       number of items
+	\param threads number of chunks
+	\param func    functor called as func( size_t begin, size_t end, int t )
+*/
+template<typename Func>
+void parallelFor( size_t n, int threads, Func func )
+{
+	if( threads <= 1 || n <= 1 )
+	{
+		for( int t = 0; t < threads; t ++ )
+		{
+			func( parallelChunk( n, threads, t ), parallelChunk( n, threads, t + 1 ), t );
+		}
+		return;
+	}
+
+	std::vector<std::thread> pool;
+	for( int t = 1; t < threads; t ++ )
+	{
+		pool.push_back( std::thread( func, parallelChunk( n, threads, t ), parallelChunk( n, threads, t + 1 ), t ) );
+	}
+	func( parallelChunk( n, threads, 0 ), parallelChunk( n, threads, 1 ), 0 );
+
+	for( size_t i = 0; i < pool.size(); i ++ ) pool[i].join();
+};
+
+/*!
+	Sort a vector on several threads: the chunks are sorted independently and then
+	merged pairwise. The order of equal elements is unspecified, use a strict total
+	order for a deterministic result.
+*/
+template<typename T, typename Less>
+void parallelSort( std::vector<T> & a, int threads, Less less )
+{
+	size_t n = a.size();
+	if( threads <= 1 || n < 4096 )
+	{
+		std::sort( a.begin(), a.end(), less );
+		return;
+	}
+
+	std::vector<size_t> bounds;
+	for( int t = 0; t <= threads; t ++ ) bounds.push_back( parallelChunk( n, threads, t ) );
+
+	parallelFor( (size_t) threads, threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t c = b; c < e; c ++ ) std::sort( a.begin() + bounds[c], a.begin() + bounds[c+1], less );
+	});
+
+	std::vector<T> buffer( n );
+	std::vector<T> * src = &a;
+	std::vector<T> * dst = &buffer;
+
+	while( bounds.size() > 2 )
+	{
+		std::vector<size_t> merged;
+		for( size_t c = 0; c + 1 < bounds.size(); c += 2 ) merged.push_back( bounds[c] );
+		merged.push_back( n );
+
+		size_t pairs = merged.size() - 1;
+		parallelFor( pairs, std::min( threads, (int) pairs ), [&]( size_t b, size_t e, int )
+		{
+			for( size_t p = b; p < e; p ++ )
+			{
+				size_t lo  = bounds[2*p];
+				size_t mid = ( 2*p + 1 < bounds.size() )? bounds[2*p+1] : n;
+				size_t hi  = merged[p+1];
+				std::merge( src->begin() + lo, src->begin() + mid, src->begin() + mid, src->begin() + hi, dst->begin() + lo, less );
+			}
+		});
+
+		std::swap( src, dst );
+		bounds.swap( merged );
+	}
+
+	if( src != &a ) a.swap( buffer );
+};
+
+}//name space MeshLib
+
+#endif //_MESHLIB_PARALLEL_H_ defined
@@ -0,0 +1,122 @@
+/*!
+*      \file Reduce.h
+*      \brief Deterministic parallel reductions
+*
+*		The items are cut into blocks of a fixed size, whatever the number of
+*		threads. Each block is reduced in the item order, and the block results are
+*		combined pairwise in a fixed tree, so the result is bit-identical for any
+*		thread count and any scheduling.
+*/
+
+#ifndef _MESHLIB_REDUCE_H_
+#define _MESHLIB_REDUCE_H_
+
+#include <vector>
+#include <algorithm>
+
+#include "Parallel.h"
+
+namespace MeshLib{
+
+/*! number of items per block of the reductions */
+const size_t PARALLEL_REDUCE_BLOCK = 4096;
+
+/*!
+	Reduce n items on several threads, deterministically.
+	\param n       number of items
+	\param threads number of threads
+	\param zero    neutral element of combine
+	\param value   functor called as value( size_t i ), the item i
+	\param combine functor called as combine( a, b ), associative
+	\return combine of the items, zero if n is 0
+*/
+template<typename T, typename Value, typename Combine>
+T parallelReduce( size_t n, int threads, const T & zero, Value value, Combine combine )
+{
+	const size_t block = PARALLEL_REDUCE_BLOCK;
+	size_t blocks = ( n + block - 1 ) / block;
+	if( blocks == 0 ) return zero;
+
+	std::vector<T> partial( blocks, zero );
+	parallelFor( blocks, std::min( threads, (int) blocks ), [&]( size_t b, size_t e, int )
+	{
+		for( size_t k = b; k < e; k ++ )
+		{
+			T s = zero;
+			size_t end = std::min( n, ( k + 1 ) * block );
+			for( size_t i = k * block; i < end; i ++ ) s = combine( s, value( i ) );
+			partial[k] = s;
+		}
+	});
+
+	for( size_t w = 1; w < blocks; w *= 2 )
+	{
+		for( size_t k = 0; k + w < blocks; k += 2 * w ) partial[k] = combine( partial[k], partial[k+w] );
+	}
+	return partial[0];
+};
+
+/*! add v to the compensated sum s, c is the running compensation */
+template<typename T>
+inline void _kahan( T & s, T & c, const T & v )
+{
+	T y = v - c;
+	T t = s + y;
+	c = ( t - s ) - y;
+	s = t;
+};
+
+/*!
+	Sum n items on several threads, deterministically. Each block is summed with
+	Kahan compensation, in four interleaved sums, and the block sums pairwise, so
+	the rounding error does not grow with n.
+	\param n       number of items
+	\param threads number of threads
+	\param zero    zero of T, e.g. 0.0 or CPoint(0,0,0)
+	\param value   functor called as value( size_t i ), the item i
+	\return the sum of the items
+*/
+template<typename T, typename Value>
+T parallelSum( size_t n, int threads, const T & zero, Value value )
+{
+	const size_t block = PARALLEL_REDUCE_BLOCK;
+	size_t blocks = ( n + block - 1 ) / block;
+	if( blocks == 0 ) return zero;
+
+	std::vector<T> partial( blocks, zero );
+	parallelFor( blocks, std::min( threads, (int) blocks ), [&]( size_t b, size_t e, int )
+	{
+		for( size_t k = b; k < e; k ++ )
+		{
+			//four interleaved compensated sums, independent chains for the pipeline
+			T s0 = zero, s1 = zero, s2 = zero, s3 = zero;
+			T c0 = zero, c1 = zero, c2 = zero, c3 = zero;
+			size_t i   = k * block;
+			size_t end = std::min( n, ( k + 1 ) * block );
+			for( ; i + 4 <= end; i += 4 )
+			{
+				_kahan( s0, c0, value( i ) );
+				_kahan( s1, c1, value( i + 1 ) );
+				_kahan( s2, c2, value( i + 2 ) );
+				_kahan( s3, c3, value( i + 3 ) );
+			}
+			for( int l = 0; i < end; i ++, l ++ )
+			{
+				if( l == 0 ) _kahan( s0, c0, value( i ) );
+				if( l == 1 ) _kahan( s1, c1, value( i ) );
+				if( l == 2 ) _kahan( s2, c2, value( i ) );
+			}
+			partial[k] = ( s0 + s1 ) + ( s2 + s3 );
+		}
+	});
+
+	for( size_t w = 1; w < blocks; w *= 2 )
+	{
+		for( size_t k = 0; k + w < blocks; k += 2 * w ) partial[k] = partial[k] + partial[k+w];
+	}
+	return partial[0];
+};
+
+}//name space MeshLib
+
+#endif //_MESHLIB_REDUCE_H_ defined
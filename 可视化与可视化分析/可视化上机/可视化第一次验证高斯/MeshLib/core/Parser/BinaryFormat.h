@@ -0,0 +1,116 @@
+/*!
+*      \file BinaryFormat.h
+*      \brief Layout of the binary .mb mesh file
+*
+*		The file holds the same information as an .m file: a header followed by arrays,
+*		each array starts at a multiple of 8 bytes, in the native (little endian) byte order.
+*
+*		vertex ids          int[nv]
+*		vertex points       double[3*nv]
+*		vertex uvs          double[2*nv]        if flags & UV
+*		vertex normals      double[3*nv]        if flags & NORMAL
+*		face ids            int[nf]
+*		face starts         unsigned long long[nf+1], into the face vertex ids
+*		face vertex ids     int[nc]
+*		edge vertex ids     int[2*ne]           the edges with a trait string
+*		corner vertex ids   int[nh]             the corners with a trait string
+*		corner face ids     int[nh]
+*		string starts       unsigned long long[nv+nf+ne+nh+1], into the string pool,
+*		                    vertex, face, edge and corner strings in this order
+*		string pool         char[nbytes]
+*/
+
+#ifndef _MESHLIB_BINARY_FORMAT_H_
+#define _MESHLIB_BINARY_FORMAT_H_
+
+#include <string.h>
+
+namespace MeshLib{
+
+/*!
+*	\brief CMBHeader, header of an .mb file
+*/
+struct CMBHeader
+{
+	/*! current version */
+	enum { VERSION = 1 };
+	/*! optional vertex columns */
+	enum { UV = 1, NORMAL = 2 };
+	/*! arrays of the file, in the file order */
+	enum { V_ID, V_POINT, V_UV, V_NORMAL, F_ID, F_START, F_VERT, E_VERT, C_VERT, C_FACE, S_START, S_POOL, END };
+
+	/*! "MLMB" */
+	char               magic[4];
+	/*! format version */
+	unsigned int       version;
+	/*! optional columns */
+	unsigned int       flags;
+	/*! zero */
+	unsigned int       reserved;
+	/*! number of vertices */
+	unsigned long long nv;
+	/*! number of faces */
+	unsigned long long nf;
+	/*! number of face vertex ids */
+	unsigned long long nc;
+	/*! number of edges with a trait string */
+	unsigned long long ne;
+	/*! number of corners with a trait string */
+	unsigned long long nh;
+	/*! size of the string pool */
+	unsigned long long nbytes;
+
+	/*! CMBHeader constructor, an empty mesh of the current version */
+	CMBHeader()
+	{
+		memcpy( magic, "MLMB", 4 );
+		version  = VERSION;
+		flags    = 0;
+		reserved = 0;
+		nv = nf = nc = ne = nh = nbytes = 0;
+	};
+
+	/*! whether the magic and the version are known */
+	bool valid() const { return memcmp( magic, "MLMB", 4 ) == 0 && version == VERSION; };
+
+	/*! size of array i in bytes, without the padding */
+	unsigned long long size( int i ) const
+	{
+		switch( i )
+		{
+		case V_ID:     return 4 * nv;
+		case V_POINT:  return 24 * nv;
+		case V_UV:     return ( flags & UV )? 16 * nv : 0;
+		case V_NORMAL: return ( flags & NORMAL )? 24 * nv : 0;
+		case F_ID:     return 4 * nf;
+		case F_START:  return 8 * ( nf + 1 );
+		case F_VERT:   return 4 * nc;
+		case E_VERT:   return 8 * ne;
+		case C_VERT:   return 4 * nh;
+		case C_FACE:   return 4 * nh;
+		case S_START:  return 8 * ( nv + nf + ne + nh + 1 );
+		case S_POOL:   return nbytes;
+		}
+		return 0;
+	};
+
+	/*!
+	Offsets of the arrays from the beginning of the file.
+	\param offset offset[i] is the start of array i, offset[END] is the file size
+	*/
+	void layout( unsigned long long offset[END+1] ) const
+	{
+		unsigned long long pos = sizeof( CMBHeader );
+		for( int i = 0; i < END; i ++ )
+		{
+			pos = ( pos + 7 ) & ~7ull;
+			offset[i] = pos;
+			pos += size( i );
+		}
+		offset[END] = pos;
+	};
+};
+
+}//name space MeshLib
+
+#endif //_MESHLIB_BINARY_FORMAT_H_ defined
@@ -0,0 +1,182 @@
+/*!
+*      \file MappedFile.h
+*      \brief Read only memory mapped file
+*
+*		The whole file is mapped into the address space, the parsers scan it in place
+*		without copying the lines.
+*/
+
+#ifndef _MESHLIB_MAPPED_FILE_H_
+#define _MESHLIB_MAPPED_FILE_H_
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace MeshLib{
+
+/*!
+*	\brief CMappedFile, read only view of a whole file
+*/
+class CMappedFile
+{
+public:
+	/*! CMappedFile constructor */
+	CMappedFile() { _init(); };
+	/*! CMappedFile destructor, unmap the file */
+	~CMappedFile() { close(); };
+
+	/*!
+	Map a file.
+	\param name file name
+	\return false if the file can not be opened or mapped
+	*/
+	bool open( const char * name );
+	/*! Unmap the file */
+	void close();
+
+	/*! First character of the file */
+	const char * begin() { return m_data; };
+	/*! One past the last character of the file */
+	const char * end()   { return m_data + m_size; };
+	/*! File size in bytes */
+	size_t size()        { return m_size; };
+	/*!
+	Split the file into n parts at line boundaries.
+	\param n      number of parts
+	\param bounds part i is [bounds[i], bounds[i+1]), n+1 entries
+	*/
+	void split( int n, std::vector<const char*> & bounds );
+
+protected:
+	/*! reset to the closed state */
+	void _init();
+
+	/*! mapped view, NULL for an empty file */
+	const char * m_data;
+	/*! file size */
+	size_t       m_size;
+#ifdef _WIN32
+	/*! file handle */
+	HANDLE       m_file;
+	/*! file mapping handle */
+	HANDLE       m_mapping;
+#else
+	/*! file descriptor */
+	int          m_fd;
+#endif
+
+private:
+	CMappedFile( const CMappedFile & );
+	CMappedFile & operator=( const CMappedFile & );
+};
+
+inline void CMappedFile::_init()
+{
+	m_data = NULL;
+	m_size = 0;
+#ifdef _WIN32
+	m_file    = INVALID_HANDLE_VALUE;
+	m_mapping = NULL;
+#else
+	m_fd      = -1;
+#endif
+};
+
+inline void CMappedFile::split( int n, std::vector<const char*> & bounds )
+{
+	bounds.assign( 1, begin() );
+	for( int i = 1; i < n; i ++ )
+	{
+		const char * p = begin() + (size_t)( (unsigned long long) m_size * i / n );
+		if( p < bounds.back() ) p = bounds.back();
+		//move to the start of the next line
+		if( p > begin() && p < end() && p[-1] != '\n' )
+		{
+			const char * eol = (const char*) memchr( p, '\n', end() - p );
+			p = ( eol == NULL )? end() : eol + 1;
+		}
+		bounds.push_back( p );
+	}
+	bounds.push_back( end() );
+};
+
+#ifdef _WIN32
+
+inline bool CMappedFile::open( const char * name )
+{
+	close();
+
+	m_file = CreateFileA( name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+	if( m_file == INVALID_HANDLE_VALUE ) return false;
+
+	LARGE_INTEGER size;
+	if( !GetFileSizeEx( m_file, &size ) ) { close(); return false; }
+	m_size = (size_t) size.QuadPart;
+	//an empty file can not be mapped
+	if( m_size == 0 ) return true;
+
+	m_mapping = CreateFileMappingA( m_file, NULL, PAGE_READONLY, 0, 0, NULL );
+	if( m_mapping == NULL ) { close(); return false; }
+
+	m_data = (const char*) MapViewOfFile( m_mapping, FILE_MAP_READ, 0, 0, 0 );
+	if( m_data == NULL ) { close(); return false; }
+	return true;
+};
+
+inline void CMappedFile::close()
+{
+	if( m_data != NULL ) UnmapViewOfFile( m_data );
+	if( m_mapping != NULL ) CloseHandle( m_mapping );
+	if( m_file != INVALID_HANDLE_VALUE ) CloseHandle( m_file );
+	_init();
+};
+
+#else
+
+inline bool CMappedFile::open( const char * name )
+{
+	close();
+
+	m_fd = ::open( name, O_RDONLY );
+	if( m_fd < 0 ) return false;
+
+	struct stat st;
+	if( fstat( m_fd, &st ) != 0 ) { close(); return false; }
+	m_size = (size_t) st.st_size;
+	if( m_size == 0 ) return true;
+
+	void * p = mmap( NULL, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0 );
+	if( p == MAP_FAILED ) { close(); return false; }
+	m_data = (const char*) p;
+	madvise( p, m_size, MADV_SEQUENTIAL );
+	return true;
+};
+
+inline void CMappedFile::close()
+{
+	if( m_data != NULL ) munmap( (void*) m_data, m_size );
+	if( m_fd >= 0 ) ::close( m_fd );
+	_init();
+};
+
+#endif
+
+}//name space MeshLib
+
+#endif //_MESHLIB_MAPPED_FILE_H_ defined
@@ -0,0 +1,198 @@
+/*!
+*      \file MeshRecord.h
+*      \brief Records of the .m and .obj files
+*
+*		A line is parsed into a record without touching the mesh, so the lines can be
+*		parsed on several threads and applied to the mesh in the file order afterwards.
+*/
+
+#ifndef _MESHLIB_MESH_RECORD_H_
+#define _MESHLIB_MESH_RECORD_H_
+
+#include <vector>
+#include "strutil.h"
+
+namespace MeshLib{
+
+/*!
+*	\brief CMRecord, one Vertex/Face/Edge/Corner line of an .m file
+*/
+struct CMRecord
+{
+	/*! record types */
+	enum { NONE, VERTEX, FACE, EDGE, CORNER };
+
+	/*! record type */
+	int             type;
+	/*! vertex id, face id, the two vertex ids of an edge, or the vertex id and face id of a corner */
+	int             id[2];
+	/*! vertex position */
+	float           point[3];
+	/*! face vertex ids, position in the id buffer */
+	size_t          first;
+	/*! number of face vertex ids */
+	size_t          count;
+	/*! whether the line carries a trait string */
+	bool            has_string;
+	/*! trait string, inside the braces */
+	strutil::StrRef string;
+
+	/*!
+	Parse a trimmed line.
+	\param line the line
+	\param ids  buffer, the face vertex ids are appended to it
+	\return false if the line is not a record
+	*/
+	bool parse( const strutil::StrRef & line, std::vector<int> & ids );
+
+protected:
+	/*! trait string in token, from the first '{' to the first '}' */
+	void _string( const strutil::StrRef & token );
+};
+
+inline void CMRecord::_string( const strutil::StrRef & token )
+{
+	const char * sp = token.find('{');
+	const char * ep = token.find('}');
+
+	if( sp != NULL && ep != NULL )
+	{
+		has_string = true;
+		string = strutil::StrRef( sp+1, ( ep > sp )? ep : token.end() );
+	}
+};
+
+inline bool CMRecord::parse( const strutil::StrRef & line, std::vector<int> & ids )
+{
+	type       = NONE;
+	has_string = false;
+
+	strutil::RangeTokenizer stokenizer( line, " \r\n" );
+
+	if( !stokenizer.nextToken() ) return false;
+	strutil::StrRef token = stokenizer.getToken();
+
+	if( token == "Vertex" )
+	{
+		type = VERTEX;
+		stokenizer.nextToken();
+		id[0] = strutil::parseString<int>( stokenizer.getToken() );
+
+		for( int i = 0 ; i < 3; i ++ )
+		{
+			stokenizer.nextToken();
+			point[i] = strutil::parseString<float>( stokenizer.getToken() );
+		}
+
+		if( stokenizer.nextToken("\t\r\n") ) _string( stokenizer.getToken() );
+		return true;
+	}
+
+	if( token == "Face" )
+	{
+		type = FACE;
+		stokenizer.nextToken();
+		id[0] = strutil::parseString<int>( stokenizer.getToken() );
+
+		first = ids.size();
+		while( stokenizer.nextToken() )
+		{
+			token = stokenizer.getToken();
+			if( strutil::startsWith( token, "{" ) ) break;
+			ids.push_back( strutil::parseString<int>( token ) );
+		}
+		count = ids.size() - first;
+
+		//the face string is searched in the whole line
+		if( stokenizer.nextToken("\t\r\n") ) _string( line );
+		return true;
+	}
+
+	if( token == "Edge" || token == "Corner" )
+	{
+		type = ( token == "Edge" )? EDGE : CORNER;
+		for( int i = 0; i < 2; i ++ )
+		{
+			stokenizer.nextToken();
+			id[i] = strutil::parseString<int>( stokenizer.getToken() );
+		}
+
+		if( stokenizer.nextToken("\t\r\n") ) _string( stokenizer.getToken() );
+		return true;
+	}
+
+	return false;
+};
+
+/*!
+*	\brief CObjRecord, one v/vt/vn/f line of an .obj file
+*/
+struct CObjRecord
+{
+	/*! record types */
+	enum { NONE, VERTEX, UV, NORMAL, FACE };
+
+	/*! record type */
+	int   type;
+	/*! position, uv or normal */
+	float value[3];
+	/*! vertex/uv/normal indices of the three corners of a face, 0 if missing */
+	int   corner[3][3];
+
+	/*!
+	Parse a trimmed line.
+	\return false if the line is not a record
+	*/
+	bool parse( const strutil::StrRef & line );
+	/*! same as parse( line ), the id buffer is not used */
+	bool parse( const strutil::StrRef & line, std::vector<int> & ) { return parse( line ); };
+};
+
+inline bool CObjRecord::parse( const strutil::StrRef & line )
+{
+	type = NONE;
+
+	strutil::RangeTokenizer stokenizer( line, " \t\r\n" );
+
+	if( !stokenizer.nextToken() ) return false;
+	strutil::StrRef token = stokenizer.getToken();
+
+	int n = 0;
+	if( token == "v"  ) { type = VERTEX; n = 3; }
+	if( token == "vt" ) { type = UV;     n = 2; }
+	if( token == "vn" ) { type = NORMAL; n = 3; }
+
+	if( n > 0 )
+	{
+		for( int i = 0; i < n; i ++ )
+		{
+			stokenizer.nextToken();
+			value[i] = strutil::parseString<float>( stokenizer.getToken() );
+		}
+		return true;
+	}
+
+	if( token == "f" )
+	{
+		type = FACE;
+		for( int i = 0 ; i < 3; i ++ )
+		{
+			stokenizer.nextToken();
+			strutil::RangeTokenizer tokenizer( stokenizer.getToken(), " /\t\r\n" );
+
+			int k = 0;
+			corner[i][0] = corner[i][1] = corner[i][2] = 0;
+			while( k < 3 && tokenizer.nextToken() )
+			{
+				corner[i][k++] = strutil::parseString<int>( tokenizer.getToken() );
+			}
+		}
+		return true;
+	}
+
+	return false;
+};
+
+}//name space MeshLib
+
+#endif //_MESHLIB_MESH_RECORD_H_ defined
@@ -0,0 +1,144 @@
+/*!
+*      \file TextWriter.h
+*      \brief Buffered text output of the mesh writers
+*
+*		The lines are formatted into large buffers without streams, the doubles with
+*		the shortest text which reads back the same value, and each buffer is written
+*		with a single fwrite.
+*/
+
+#ifndef _MESHLIB_TEXT_WRITER_H_
+#define _MESHLIB_TEXT_WRITER_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#if ( defined(_MSVC_LANG) && _MSVC_LANG >= 201703L ) || __cplusplus >= 201703L
+#if defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+#endif
+
+#include "strutil.h"
+#include "../Parallel/Parallel.h"
+
+namespace MeshLib{
+
+/*!
+*	\brief CTextBuffer, a growing character buffer with number formatting
+*/
+class CTextBuffer
+{
+public:
+	/*! empty the buffer, the memory is kept */
+	void clear() { m_data.clear(); };
+	/*! number of characters */
+	size_t size() const { return m_data.size(); };
+	/*! keep the first n characters */
+	void resize( size_t n ) { m_data.resize( n ); };
+	/*! the characters */
+	const std::string & str() const { return m_data; };
+
+	/*! append a string */
+	CTextBuffer & operator<<( const char * s )        { m_data += s; return *this; };
+	/*! append a string */
+	CTextBuffer & operator<<( const std::string & s ) { m_data += s; return *this; };
+	/*! append a range of characters */
+	CTextBuffer & operator<<( const strutil::StrRef & s ) { m_data.append( s.begin(), s.end() ); return *this; };
+	/*! append a character */
+	CTextBuffer & operator<<( char c )                { m_data += c; return *this; };
+	/*! append an integer */
+	CTextBuffer & operator<<( int v )                 { return _integer( v < 0, v < 0 ? 0ull - (unsigned long long) v : (unsigned long long) v ); };
+	/*! append an integer */
+	CTextBuffer & operator<<( unsigned long long v )  { return _integer( false, v ); };
+	/*! append a double, with the shortest text which reads back the same value */
+	CTextBuffer & operator<<( double v );
+
+	/*!
+	Write the buffer.
+	\param fp the output file
+	\return false if the write failed
+	*/
+	bool write( FILE * fp ) const
+	{
+		return m_data.empty() || fwrite( m_data.data(), 1, m_data.size(), fp ) == m_data.size();
+	};
+
+protected:
+	/*! append the digits of an integer */
+	CTextBuffer & _integer( bool negative, unsigned long long v )
+	{
+		char buffer[24];
+		char * p = buffer + sizeof( buffer );
+		do{
+			*--p = (char)( '0' + v % 10 );
+			v /= 10;
+		}while( v != 0 );
+		if( negative ) *--p = '-';
+		m_data.append( p, buffer + sizeof( buffer ) );
+		return *this;
+	};
+
+	/*! the characters */
+	std::string m_data;
+};
+
+inline CTextBuffer & CTextBuffer::operator<<( double v )
+{
+	char buffer[32];
+#ifdef __cpp_lib_to_chars
+	std::to_chars_result r = std::to_chars( buffer, buffer + sizeof( buffer ), v );
+	m_data.append( buffer, r.ptr );
+#else
+	//the fewest of 15, 16 and 17 significant digits which reads back the same value
+	for( int precision = 15; ; precision ++ )
+	{
+		snprintf( buffer, sizeof( buffer ), "%.*g", precision, v );
+		if( precision == 17 || strtod( buffer, NULL ) == v ) break;
+	}
+	m_data += buffer;
+#endif
+	return *this;
+};
+
+/*!
+	Format n items on several threads and write them in the item order. The items are
+	formatted in rounds of a fixed number of items per thread, each thread into its
+	own buffer, and the buffers are written in order.
+	\param fp      the output file
+	\param n       number of items
+	\param threads number of threads
+	\param format  functor called as format( size_t i, CTextBuffer & buffer )
+	\return false if a write failed
+*/
+template<typename Format>
+bool parallelWrite( FILE * fp, size_t n, int threads, Format format )
+{
+	const size_t block = 1 << 16;
+	std::vector<CTextBuffer> buffers( threads );
+
+	for( size_t b = 0; b < n; b += block * threads )
+	{
+		size_t e = std::min( n, b + block * threads );
+		parallelFor( e - b, threads, [&]( size_t i0, size_t i1, int t )
+		{
+			buffers[t].clear();
+			for( size_t i = i0; i < i1; i ++ ) format( b + i, buffers[t] );
+		});
+
+		for( int t = 0; t < threads; t ++ )
+		{
+			if( !buffers[t].write( fp ) ) return false;
+		}
+	}
+	return true;
+};
+
+}//name space MeshLib
+
+#endif //_MESHLIB_TEXT_WRITER_H_ defined
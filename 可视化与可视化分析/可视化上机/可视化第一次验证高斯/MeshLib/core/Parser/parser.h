@@ -4,6 +4,8 @@
 *	   \author David Gu
 *      \date 10/07/2010
 *
+*		A trait string is a list of tokens separated by blanks, each token is either
+*		a key, or key=(value), e.g. "uv=(0.5 0.5) sharp".
 */
 
 #ifndef _MESHLIB_PARSER_H_
@@ -12,108 +14,256 @@
 #include <string>
 #include <assert.h>
 #include <list>
+#include <deque>
+#include <mutex>
 #include <sstream>
 
+#include "strutil.h"
+#include "../Geometry/Point.h"
+#include "../Geometry/Point2.h"
+
 namespace MeshLib
 {
 
 /*!
- *	\brief CToken  class, key=(value), e.g. uv=(x y)
+ *	\brief CTraitKey class, an interned trait key
+ *
+ *	Keys with the same name share the same id and the same characters. A key is
+ *	meant to be created once, e.g. as a static local, and compared against the
+ *	tokens of many strings.
 */
 
-class CToken
+class CTraitKey
 {
 public:
-	/*! key of the token */
-	std::string m_key;
-	/*! value of the token */
-	std::string m_value;
+	/*!
+	 *	CTraitKey constructor, intern the name
+	 *  \param name key name, without blanks and '='
+	 */
+	explicit CTraitKey( const char * name )
+	{
+		std::lock_guard<std::mutex> lock( _mutex() );
+		std::deque<std::string> & names = _names();
+
+		size_t i = 0;
+		while( i < names.size() && names[i] != name ) i ++;
+		if( i == names.size() ) names.push_back( name );
+
+		m_id   = (int) i;
+		m_name = strutil::StrRef( names[i].data(), names[i].data() + names[i].size() );
+	};
+
+	/*! unique id of the key name, 0, 1, 2 ... in the order of interning */
+	int id() const { return m_id; };
+	/*! interned characters of the key */
+	const strutil::StrRef & name() const { return m_name; };
+
+	/*! whether a key span has this name */
+	bool operator==( const strutil::StrRef & key ) const
+	{
+		return key.size() == m_name.size() && memcmp( key.begin(), m_name.begin(), key.size() ) == 0;
+	};
+
+	/*! number of interned keys */
+	static int count()
+	{
+		std::lock_guard<std::mutex> lock( _mutex() );
+		return (int) _names().size();
+	};
+
+protected:
+	/*! interned names, a deque keeps their addresses */
+	static std::deque<std::string> & _names() { static std::deque<std::string> names; return names; };
+	/*! guards the interned names */
+	static std::mutex & _mutex() { static std::mutex mutex; return mutex; };
+
+	/*! key id */
+	int             m_id;
+	/*! key name */
+	strutil::StrRef m_name;
 };
 
 /*!
- *	\brief CParser class
+ *	\brief CTraitTokenizer class, iterate the key=(value) tokens of a trait string
+ *
+ *	The keys and values refer to the characters of the string, nothing is copied or
+ *	allocated, and there is no length limit. The string must not change while it is
+ *	tokenized.
 */
 
-class CParser
+class CTraitTokenizer
 {
 public:
 	/*!
-	 *	\brief CParser constructor
-	 *  \param str input string
+	 *	CTraitTokenizer constructor
+	 *  \param str trait string
 	 */
-	CParser( const std::string & str)
+	CTraitTokenizer( const std::string & str ) : m_pos( str.data() ), m_end( str.data() + str.size() ) {};
+	/*!
+	 *	CTraitTokenizer constructor
+	 *  \param str trait string
+	 */
+	CTraitTokenizer( const strutil::StrRef & str ) : m_pos( str.begin() ), m_end( str.end() ) {};
+
+	/*!
+	 *	Move to the next token.
+	 *  \return false if there is no more token
+	 */
+	bool next()
 	{
-		//copy string
-		unsigned int i;
-		for(  i = 0; i < str.length(); i ++ )
-		{
-			m_line[i] = str.c_str()[i];
-		}
-		m_line[i] = 0;
+		while( m_pos < m_end && *m_pos == ' ' ) m_pos ++;
+		if( m_pos == m_end ) return false;
 
-		m_pt = m_line;
-		
-		//while not reaching the end
-		while( !end() )
-		{
-			skip_blank();
-			if( end() ) break;
+		const char * k = m_pos;
+		while( m_pos < m_end && *m_pos != ' ' && *m_pos != '=' ) m_pos ++;
+		m_key   = strutil::StrRef( k, m_pos );
+		m_value = strutil::StrRef( m_pos, m_pos );
 
-			//copy key
+		if( m_pos == m_end || *m_pos != '=' ) return true;
 
-			char * pkey = m_key;
-			char   ch = next_char();
+		//the value runs from '(' to the first ')'
+		const char * b = (const char*) memchr( m_pos, '(', m_end - m_pos );
+		if( b == NULL )
+		{
+			m_pos = m_end;
+			return true;
+		}
+		const char * e = (const char*) memchr( b, ')', m_end - b );
+		m_pos   = ( e == NULL )? m_end : e + 1;
+		m_value = strutil::StrRef( b, m_pos );
+		return true;
+	};
 
-			while( ch != ' ' && ch != '=' && !end() )
-			{
-				*pkey ++ = ch;
-				ch = next_char();
-			}
-			if( ch != '=' && ch != ' ')
-				*pkey++ = ch;
+	/*! key of the current token */
+	const strutil::StrRef & key() const { return m_key; };
+	/*! value of the current token with the parentheses, e.g. "(0.5 0.5)", empty if the token has no value */
+	const strutil::StrRef & value() const { return m_value; };
+	/*! value of the current token without the parentheses */
+	strutil::StrRef inner() const
+	{
+		const char * b = m_value.begin();
+		const char * e = m_value.end();
+		while( b < e && ( *b == '(' || *b == ')' ) ) b ++;
+		while( e > b && ( e[-1] == '(' || e[-1] == ')' ) ) e --;
+		return strutil::StrRef( b, e );
+	};
+	/*! whether the current token has the key */
+	bool is( const CTraitKey & key ) const { return key == m_key; };
 
-			*pkey = 0;
+	/*!
+	 *	Parse the numbers of a value.
+	 *  \param value the value, with or without the parentheses
+	 *  \param v     the numbers
+	 *  \param n     at most n numbers are parsed
+	 *  \return the number of parsed numbers
+	 */
+	static int values( const strutil::StrRef & value, double * v, int n )
+	{
+		strutil::RangeTokenizer tokenizer( value, " \t()" );
+		int k = 0;
+		while( k < n && tokenizer.nextToken() )
+		{
+			v[k++] = strutil::parseString<double>( tokenizer.getToken() );
+		}
+		return k;
+	};
 
-			if( ch == ' ' )
-			{
-				skip_blank();
-			}
+	/*!
+	 *	Remove the first token with the key from a trait string, the remaining tokens
+	 *	are separated by single blanks.
+	 *  \param str the trait string
+	 *  \param key the key of the token to be removed
+	 */
+	static void remove( std::string & str, const CTraitKey & key )
+	{
+		std::string out;
+		out.reserve( str.size() );
 
-			if( ch != '=' )
+		bool removed = false;
+		CTraitTokenizer tokenizer( str );
+		while( tokenizer.next() )
+		{
+			if( !removed && tokenizer.is( key ) )
 			{
-				CToken *	tk = new CToken;
-				assert(tk);
-				tk->m_key  = std::string( m_key );
-				
-				m_tokens.push_back( tk );
+				removed = true;
 				continue;
 			}
+			if( !out.empty() ) out += ' ';
+			out.append( tokenizer.key().begin(), tokenizer.key().end() );
+			if( tokenizer.value().empty() ) continue;
+			out += '=';
+			out.append( tokenizer.value().begin(), tokenizer.value().end() );
+		}
+		str.swap( out );
+	};
 
-			if( end() ) break;
+protected:
+	/*! current position */
+	const char *    m_pos;
+	/*! end of the string */
+	const char *    m_end;
+	/*! current key */
+	strutil::StrRef m_key;
+	/*! current value */
+	strutil::StrRef m_value;
+};
 
-			ch = next_char();
+/*! read a point from a trait value "(x y z)" */
+inline void operator>>( const strutil::StrRef & str, CPoint & p )
+{
+	double v[3] = { 0, 0, 0 };
+	CTraitTokenizer::values( str, v, 3 );
+	p = CPoint( v[0], v[1], v[2] );
+};
 
-			while( ch != '(' ) ch = next_char();
+/*! read a 2d point from a trait value "(x y)" */
+inline void operator>>( const strutil::StrRef & str, CPoint2 & p )
+{
+	double v[2] = { 0, 0 };
+	CTraitTokenizer::values( str, v, 2 );
+	p = CPoint2( v[0], v[1] );
+};
 
-			char * pvalue = m_value;
+/*!
+ *	\brief CToken  class, key=(value), e.g. uv=(x y)
+*/
 
-			while( ch != ')' && !end() )
-			{
-				*pvalue ++ = ch;
-				ch = next_char();
-			}
-			*pvalue++ = ch;
-			*pvalue  = 0;
+class CToken
+{
+public:
+	/*! key of the token */
+	std::string m_key;
+	/*! value of the token */
+	std::string m_value;
+};
+
+/*!
+ *	\brief CParser class
+ *
+ *	Copies the tokens of a string into a list, use CTraitTokenizer to read the
+ *	traits without copying.
+*/
+
+class CParser
+{
+public:
+	/*!
+	 *	\brief CParser constructor
+	 *  \param str input string
+	 */
+	CParser( const std::string & str)
+	{
+		CTraitTokenizer tokenizer( str );
 
+		while( tokenizer.next() )
+		{
 			CToken *	tk = new CToken;
 			assert(tk);
-			tk->m_key   = std::string( m_key   );
-			tk->m_value = std::string( m_value );
-			
+			tk->m_key   = tokenizer.key().str();
+			tk->m_value = tokenizer.value().str();
+
 			m_tokens.push_back( tk );
-			
 		}
-
 	};
 
 	/*!
@@ -135,7 +285,7 @@ public:
 	 *	List of tokens extracted from the string
 	 */
 	std::list<CToken*> & tokens() { return m_tokens; };
-	
+
 	/*!
 	 *	Convert the list of tokens to a string
 	 *  \param str the output string
@@ -154,7 +304,7 @@ public:
 			  }
 			  else
 			  {
-				iss << token->m_key << "=" << token->m_value;			  
+				iss << token->m_key << "=" << token->m_value;
 			  }
 		}
 
@@ -164,7 +314,7 @@ public:
 	 *	Remove the token key=(...) from the current string
 	 *  \param key the key to the token to be removed
 	 */
-	void _removeToken( const std::string & key )	
+	void _removeToken( const std::string & key )
 	{
 		for( std::list<CToken*>::iterator iter = m_tokens.begin() ; iter != m_tokens.end(); ++ iter )
 		{
@@ -172,59 +322,19 @@ public:
 			  if( token->m_key == key )
 			  {
 				  m_tokens.erase( iter );
+				  delete token;
 				  return;
 			  }
 		}
 	};
 
 private:
-
-	/*!
-	 *	get the next char in the current string
-	 */
-	char next_char()
-	{
-		char ch= *m_pt;
-		m_pt++;
-		return ch;
-	};
-	/*!
-	 *	skip blank spaces
-	 */
-	void skip_blank()
-	{
-		while( *m_pt == ' ' ) m_pt++;
-	};
-	/*!
-	 *	verify if we 
-	 */
-	bool end()
-	{
-		return ( (*m_pt) == 0 );
-	};
 	/*!
 	 *	list of tokens
 	 */
 	std::list<CToken*> m_tokens;
-	
-	/*!
-	 * The buffer to contain the string
-	 */
-	char m_line[1024];
-	/*!
-	 *	current key
-	 */
-	char m_key[1024];
-	/*!
-	 *	current value
-	 */
-	char m_value[1024];
-	/*!
-	 *	current pointer to the char buffer
-	 */
-	char * m_pt;
 };
 
 
-}; //namespace 
-#endif
\ No newline at end of file
+}; //namespace
+#endif
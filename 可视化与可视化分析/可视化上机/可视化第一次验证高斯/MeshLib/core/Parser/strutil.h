@@ -12,6 +12,10 @@
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <float.h>
 
 // declaration
 namespace strutil {
@@ -203,6 +207,182 @@ inline std::vector<std::string> split(const std::string& str, const std::string&
 };
 
 };
+
+// Allocation free tokenizer over a character range
+namespace strutil {
+
+	/*!
+	*	\brief Reference to a range of characters
+	*
+	*	The characters are not copied, the range must stay alive while the reference is used.
+	*/
+	class StrRef
+	{
+	public:
+		StrRef() : m_begin(NULL), m_end(NULL) {};
+		StrRef(const char * b, const char * e) : m_begin(b), m_end(e) {};
+
+		const char * begin() const { return m_begin; };
+		const char * end()   const { return m_end; };
+		size_t size()  const { return (size_t)(m_end - m_begin); };
+		bool   empty() const { return m_end == m_begin; };
+
+		/*! compare with a null terminated string */
+		bool operator==(const char * s) const
+		{
+			size_t n = strlen(s);
+			return n == size() && memcmp(m_begin, s, n) == 0;
+		};
+		/*! first occurrence of c, NULL if there is none */
+		const char * find(char c) const
+		{
+			for (const char * p = m_begin; p < m_end; p++)
+				if (*p == c) return p;
+			return NULL;
+		};
+		/*! copy to a std::string */
+		std::string str() const { return std::string(m_begin, m_end); };
+
+	protected:
+		const char * m_begin;
+		const char * m_end;
+	};
+
+	inline bool isOneOf(char c, const char * set)
+	{
+		for (; *set; set++)
+			if (*set == c) return true;
+		return false;
+	};
+
+	inline StrRef trim(const StrRef& str)
+	{
+		const char * b = str.begin();
+		const char * e = str.end();
+		while (b < e && isOneOf(*b, " \t\n\r")) b++;
+		while (e > b && isOneOf(e[-1], " \t\n\r")) e--;
+		return StrRef(b, e);
+	};
+
+	inline bool startsWith(const StrRef& str, const char * substr)
+	{
+		size_t n = strlen(substr);
+		return str.size() >= n && memcmp(str.begin(), substr, n) == 0;
+	};
+
+	/*!
+	*	Read the line starting at pos, without the '\n'.
+	*	\return the start of the next line
+	*/
+	inline const char * getLine(const char * pos, const char * end, StrRef& line)
+	{
+		const char * eol = (const char *)memchr(pos, '\n', end - pos);
+		if (eol == NULL) {
+			line = StrRef(pos, end);
+			return end;
+		}
+		line = StrRef(pos, eol);
+		return eol + 1;
+	};
+
+	/*!
+	*	\brief Tokenizer over a StrRef
+	*
+	*	Same behavior as Tokenizer, the tokens refer to the input characters instead of
+	*	being copied.
+	*/
+	class RangeTokenizer
+	{
+	public:
+		RangeTokenizer(const StrRef& str, const char * delimiters)
+		: m_String(str), m_Offset(str.begin()), m_Delimiters(delimiters) {};
+
+		bool nextToken() { return nextToken(m_Delimiters); };
+
+		bool nextToken(const char * delimiters)
+		{
+			const char * e = m_String.end();
+			const char * i = m_Offset;
+			while (i < e && isOneOf(*i, delimiters)) i++;
+			if (i == e) {
+				m_Offset = e;
+				return false;
+			}
+			const char * j = i;
+			while (j < e && !isOneOf(*j, delimiters)) j++;
+			m_Token  = StrRef(i, j);
+			m_Offset = j;
+			return true;
+		};
+
+		const StrRef& getToken() const { return m_Token; };
+
+		void reset() { m_Offset = m_String.begin(); };
+
+	protected:
+		StrRef       m_String;
+		const char * m_Offset;
+		StrRef       m_Token;
+		const char * m_Delimiters;
+	};
+
+	template<class T> T parseString(const StrRef& str) {
+		return parseString<T>(str.str());
+	};
+
+	/*!
+	*	Parse an int in place, the same result as the stream version:
+	*	leading white spaces are skipped, 0 if there is no digit, saturated on overflow.
+	*/
+	template<> inline int parseString<int>(const StrRef& str) {
+		const char * p = str.begin();
+		const char * e = str.end();
+		while (p < e && isOneOf(*p, " \t\n\r\v\f")) p++;
+		bool neg = false;
+		if (p < e && (*p == '-' || *p == '+')) { neg = (*p == '-'); p++; }
+		long long v = 0;
+		for (; p < e && *p >= '0' && *p <= '9'; p++) {
+			v = v * 10 + (*p - '0');
+			if (v > (long long)INT_MAX + 1) break;
+		}
+		if (neg) v = -v;
+		if (v > INT_MAX) return INT_MAX;
+		if (v < INT_MIN) return INT_MIN;
+		return (int)v;
+	};
+
+	/*!
+	*	Parse a float in place. The characters a stream would accept are copied to a
+	*	stack buffer and converted by strtod, so the rounding is the same as the stream version.
+	*/
+	template<> inline double parseString<double>(const StrRef& str) {
+		char buffer[64];
+		const char * p = str.begin();
+		const char * e = str.end();
+		while (p < e && isOneOf(*p, " \t\n\r\v\f")) p++;
+		size_t n = 0;
+		while (p < e && n + 1 < sizeof(buffer) && isOneOf(*p, "0123456789+-.eE")) buffer[n++] = *p++;
+		buffer[n] = 0;
+		double v = strtod(buffer, NULL);
+		if (v > DBL_MAX) return DBL_MAX;
+		if (v < -DBL_MAX) return -DBL_MAX;
+		return v;
+	};
+
+	template<> inline float parseString<float>(const StrRef& str) {
+		char buffer[64];
+		const char * p = str.begin();
+		const char * e = str.end();
+		while (p < e && isOneOf(*p, " \t\n\r\v\f")) p++;
+		size_t n = 0;
+		while (p < e && n + 1 < sizeof(buffer) && isOneOf(*p, "0123456789+-.eE")) buffer[n++] = *p++;
+		buffer[n] = 0;
+		float v = strtof(buffer, NULL);
+		if (v > FLT_MAX) return FLT_MAX;
+		if (v < -FLT_MAX) return -FLT_MAX;
+		return v;
+	};
+};
 /*
 struct string_token_iterator 
   : public std::iterator<std::input_iterator_tag, std::string>
@@ -3,6 +3,9 @@
  *  \author David Gu
  *  \date   documented on 6/23/2011
  *
+ *  The traits go through the trait columns of the mesh, see Mesh/TraitColumns.h:
+ *  the writers fill the column of the key, the readers take the column if one is
+ *  registered and parse the trait strings otherwise.
  */
 
 #ifndef _TRAITS_IO_H_
@@ -10,6 +13,7 @@
 
 #include <map>
 #include <vector>
+#include <complex>
 
 #include "Mesh/BaseMesh.h"
 #include "Mesh/Vertex.h"
@@ -40,138 +44,99 @@
 namespace MeshLib
 {
 
-template<typename M, typename V, typename E, typename F, typename H>
-void _read_vertex_target_k( M * pMesh )
+/*!
+	Read a trait of the elements into their members: from the trait column of the key if
+	one is registered, the loaders have parsed the tokens into it, else from the trait strings.
+	\param traits the trait columns of the element kind, e.g. pMesh->vertexTraits()
+	\param iter   iterator over the elements
+	\param name   the key
+	\param set    functor called as set( element, value ) for the elements with the trait only,
+	              the members of the others are left as they are
+*/
+template<typename T, typename I, typename Set>
+void _read_trait_column( CTraitColumns & traits, I iter, const char * name, Set set )
 {
-	for( M::MeshVertexIterator viter( pMesh ); !viter.end(); viter ++ )
+	CTraitColumn<T> * column = traits.find<T>( name );
+	const CTraitKey key( name );
+
+	for( ; !iter.end(); iter ++ )
 	{
-		V * pV = *viter;
-		CParser parser( pV->string() );
-		
-		for( std::list<CToken*>::iterator iter = parser.tokens().begin() ; iter != parser.tokens().end(); ++ iter )
+		auto pE = *iter;
+		if( column != NULL )
+		{
+			if( column->present( pE->slot() ) ) set( pE, (T) column->value( pE->slot() ) );
+			continue;
+		}
+
+		CTraitTokenizer tokenizer( pE->string() );
+		while( tokenizer.next() )
 		{
-		  CToken * token = *iter;
-		  if( token->m_key == "k" )
+		  if( tokenizer.is( key ) )
 		  {
-			  std::string line = strutil::trim( token->m_value, "()");
-			  pV->target_k() = strutil::parseString<double>( line );	
+			  T value = T();
+			  traitRead( tokenizer.value(), value );
+			  set( pE, value );
 		  }
 		}
 	}
 };
 
+/*!
+	Write a trait of the elements from their members into the trait column of the key,
+	registered if needed. The column owns the key, a token with the key left in the
+	trait strings is not written.
+	\param traits the trait columns of the element kind, e.g. pMesh->vertexTraits()
+	\param iter   iterator over the elements
+	\param name   the key
+	\param get    functor called as get( element ), the value of the element
+*/
+template<typename T, typename I, typename Get>
+void _write_trait_column( CTraitColumns & traits, I iter, const char * name, Get get )
+{
+	CTraitColumn<T> & column = traits.add<T>( name );
+
+	for( ; !iter.end(); iter ++ )
+	{
+		auto pE = *iter;
+		column( pE ) = get( pE );
+	}
+};
+
+template<typename M, typename V, typename E, typename F, typename H>
+void _read_vertex_target_k( M * pMesh )
+{
+	_read_trait_column<double>( pMesh->vertexTraits(), M::MeshVertexIterator( pMesh ), "k", []( V * pV, double k ){ pV->target_k() = k; } );
+};
+
 
 template<typename M, typename V, typename E, typename F, typename H>
 void _write_vertex_uv( M * pMesh )
 {
-	for( M::MeshVertexIterator viter( pMesh ); !viter.end(); viter ++ )
-	{
-		V * pV = *viter;
-		CPoint2 uv = pV->uv();
-
-		CParser parser( pV->string() );
-		parser._removeToken( "uv" );
-		
-		parser._toString( pV->string() );
-		
-		std::stringstream iss;
-		
-		iss << "uv=(" << uv[0] << " " << uv[1] << ")";
-
-		if( pV->string().size() > 0 )
-		{
-		  pV->string() += " ";
-		}
-		pV->string() += iss.str();
-	}
+	_write_trait_column<CPoint2>( pMesh->vertexTraits(), M::MeshVertexIterator( pMesh ), "uv", []( V * pV ){ return pV->uv(); } );
 };
 
 template<typename M>
 void _write_vertex_huv( M * pMesh )
 {
-	for( M::MeshVertexIterator viter( pMesh ); !viter.end(); viter ++ )
-	{
-		M::CVertex * pV = *viter;
-		CPoint2 uv = pV->huv();
-
-		CParser parser( pV->string() );
-		parser._removeToken( "uv" );
-		
-		parser._toString( pV->string() );
-		
-		std::stringstream iss;
-		
-		iss << "uv=(" << uv[0] << " " << uv[1] << ")";
-
-		if( pV->string().size() > 0 )
-		{
-		  pV->string() += " ";
-		}
-		pV->string() += iss.str();
-	}
+	_write_trait_column<CPoint2>( pMesh->vertexTraits(), M::MeshVertexIterator( pMesh ), "uv", []( M::CVertex * pV ){ return CPoint2( pV->huv()[0], pV->huv()[1] ); } );
 };
 
 template<typename M, typename V, typename E, typename F, typename H>
 void _read_vertex_uv( M * pMesh )
 {
-	for( M::MeshVertexIterator viter( pMesh ); !viter.end(); viter ++ )
-	{
-		V * pV = *viter;
-		CParser parser( pV->string() );
-		
-		for( std::list<CToken*>::iterator iter = parser.tokens().begin() ; iter != parser.tokens().end(); ++ iter )
-		{
-		  CToken * token = *iter;
-		  if( token->m_key == "uv" )
-		  {
-			  CPoint2 uv;
-			  token->m_value >> uv;
-			  pV->uv() = uv;
-		  }
-		}
-	}
+	_read_trait_column<CPoint2>( pMesh->vertexTraits(), M::MeshVertexIterator( pMesh ), "uv", []( V * pV, const CPoint2 & uv ){ pV->uv() = uv; } );
 };
 
 template<typename M>
 void __read_vertex_uv( M * pMesh )
 {
-	for( M::MeshVertexIterator viter( pMesh ); !viter.end(); viter ++ )
-	{
-		M::CVertex * pV = *viter;
-		CParser parser( pV->string() );
-		
-		for( std::list<CToken*>::iterator iter = parser.tokens().begin() ; iter != parser.tokens().end(); ++ iter )
-		{
-		  CToken * token = *iter;
-		  if( token->m_key == "uv" )
-		  {
-			  CPoint2 uv;
-			  token->m_value >> uv;
-			  pV->uv() = uv;
-		  }
-		}
-	}
+	_read_trait_column<CPoint2>( pMesh->vertexTraits(), M::MeshVertexIterator( pMesh ), "uv", []( M::CVertex * pV, const CPoint2 & uv ){ pV->uv() = uv; } );
 };
 
 template<typename M, typename V, typename E, typename F, typename H>
 void _read_vertex_z( M * pMesh )
 {
-	for( M::MeshVertexIterator viter( pMesh ); !viter.end(); viter ++ )
-	{
-		V * pV = *viter;
-		CParser parser( pV->string() );
-		
-		for( std::list<CToken*>::iterator iter = parser.tokens().begin() ; iter != parser.tokens().end(); ++ iter )
-		{
-		  CToken * token = *iter;
-		  if( token->m_key == "z" )
-		  {
-			  CPoint2 uv;
-			  token->m_value >> uv;
-			  pV->z() = std::complex<double>( uv[0], uv[1] );
-		  }
-		}
-	}
+	_read_trait_column<CPoint2>( pMesh->vertexTraits(), M::MeshVertexIterator( pMesh ), "z", []( V * pV, const CPoint2 & uv ){ pV->z() = std::complex<double>( uv[0], uv[1] ); } );
 };
 
 
@@ -179,190 +144,57 @@ void _read_vertex_z( M * pMesh )
 template<typename M>
 void _read_vertex_huv( M * pMesh )
 {
-	for( M::MeshVertexIterator viter( pMesh ); !viter.end(); viter ++ )
-	{
-		M::CVertex * pV = *viter;
-		CParser parser( pV->string() );
-		
-		for( std::list<CToken*>::iterator iter = parser.tokens().begin() ; iter != parser.tokens().end(); ++ iter )
-		{
-		  CToken * token = *iter;
-		  if( token->m_key == "uv" )
-		  {
-			  CPoint2 uv;
-			  token->m_value >> uv;
-			  pV->huv() = uv;
-		  }
-		}
-	}
+	_read_trait_column<CPoint2>( pMesh->vertexTraits(), M::MeshVertexIterator( pMesh ), "uv", []( M::CVertex * pV, const CPoint2 & uv ){ pV->huv() = uv; } );
 };
 
 template<typename M, typename V, typename E, typename F, typename H>
 void _read_vertex_father( M * pMesh )
 {
-	for( M::MeshVertexIterator viter( pMesh ); !viter.end(); viter ++ )
-	{
-		V * pV = *viter;
-		CParser parser( pV->string() );
-		
-		for( std::list<CToken*>::iterator iter = parser.tokens().begin() ; iter != parser.tokens().end(); ++ iter )
-		{
-		  CToken * token = *iter;
-		  if( token->m_key == "father" )
-		  {
-			  std::string line = strutil::trim( token->m_value, "()");
-			  pV->father() = strutil::parseString<int>( line );	
-		  }
-		}
-	}
+	_read_trait_column<int>( pMesh->vertexTraits(), M::MeshVertexIterator( pMesh ), "father", []( V * pV, int father ){ pV->father() = father; } );
 };
 
 template<typename M>
 void _read_vertex_father_trait( M * pMesh )
 {
-	for( M::MeshVertexIterator viter( pMesh ); !viter.end(); viter ++ )
-	{
-		M::CVertex * pV = *viter;
-		CParser parser( pV->string() );
-		
-		for( std::list<CToken*>::iterator iter = parser.tokens().begin() ; iter != parser.tokens().end(); ++ iter )
-		{
-		  CToken * token = *iter;
-		  if( token->m_key == "father" )
-		  {
-			  std::string line = strutil::trim( token->m_value, "()");
-			  pV->father() = strutil::parseString<int>( line );	
-		  }
-		}
-	}
+	_read_trait_column<int>( pMesh->vertexTraits(), M::MeshVertexIterator( pMesh ), "father", []( M::CVertex * pV, int father ){ pV->father() = father; } );
 };
 
 
 template<typename M, typename V, typename E, typename F, typename H>
 void _read_vertex_mu( M * pMesh )
 {
-	for( M::MeshVertexIterator viter( pMesh ); !viter.end(); viter ++ )
-	{
-		V * pV = *viter;
-		CParser parser( pV->string() );
-		
-		for( std::list<CToken*>::iterator iter = parser.tokens().begin() ; iter != parser.tokens().end(); ++ iter )
-		{
-		  CToken * token = *iter;
-		  if( token->m_key == "mu" )
-		  {
-			  CPoint2 uv;
-			  token->m_value >> uv;
-			  pV->mu() = std::complex<double>( uv[0], uv[1] );
-		  }
-		}
-	}
+	_read_trait_column<CPoint2>( pMesh->vertexTraits(), M::MeshVertexIterator( pMesh ), "mu", []( V * pV, const CPoint2 & uv ){ pV->mu() = std::complex<double>( uv[0], uv[1] ); } );
 };
 
 template<typename M, typename V, typename E, typename F, typename H>
 void _read_vertex_normal( M * pMesh )
 {
-	for( M::MeshVertexIterator viter( pMesh ); !viter.end(); viter ++ )
-	{
-		V * pV = *viter;
-		CParser parser( pV->string() );
-		
-		for( std::list<CToken*>::iterator iter = parser.tokens().begin() ; iter != parser.tokens().end(); ++ iter )
-		{
-		  CToken * token = *iter;
-		  if( token->m_key == "normal" )
-		  {
-			  CPoint normal;
-			  token->m_value >> normal;
-			  pV->normal() = normal;
-		  }
-		}
-	}
+	_read_trait_column<CPoint>( pMesh->vertexTraits(), M::MeshVertexIterator( pMesh ), "normal", []( V * pV, const CPoint & normal ){ pV->normal() = normal; } );
 };
 
 
 template<typename M, typename V, typename E, typename F, typename H>
 void _read_vertex_rgb( M * pMesh )
 {
-	for( M::MeshVertexIterator viter( pMesh ); !viter.end(); viter ++ )
-	{
-		V * pV = *viter;
-		CParser parser( pV->string() );
-		
-		for( std::list<CToken*>::iterator iter = parser.tokens().begin() ; iter != parser.tokens().end(); ++ iter )
-		{
-		  CToken * token = *iter;
-		  if( token->m_key == "rgb" )
-		  {
-			  CPoint rgb;
-			  token->m_value >> rgb;
-			  pV->rgb() = rgb;
-		  }
-		}
-	}
+	_read_trait_column<CPoint>( pMesh->vertexTraits(), M::MeshVertexIterator( pMesh ), "rgb", []( V * pV, const CPoint & rgb ){ pV->rgb() = rgb; } );
 };
 
 template<typename M>
 void _read_vertex_rgb_trait( M * pMesh )
 {
-	for( M::MeshVertexIterator viter( pMesh ); !viter.end(); viter ++ )
-	{
-		M::CVertex * pV = *viter;
-		CParser parser( pV->string() );
-		
-		for( std::list<CToken*>::iterator iter = parser.tokens().begin() ; iter != parser.tokens().end(); ++ iter )
-		{
-		  CToken * token = *iter;
-		  if( token->m_key == "rgb" )
-		  {
-			  CPoint rgb;
-			  token->m_value >> rgb;
-			  pV->rgb() = rgb;
-		  }
-		}
-	}
+	_read_trait_column<CPoint>( pMesh->vertexTraits(), M::MeshVertexIterator( pMesh ), "rgb", []( M::CVertex * pV, const CPoint & rgb ){ pV->rgb() = rgb; } );
 };
 
 template<typename M, typename V, typename E, typename F, typename H>
 void _read_edge_length( M * pMesh )
 {
-	for( M::MeshEdgeIterator eiter( pMesh ); !eiter.end(); eiter ++ )
-	{
-		E * pE = *eiter;
-
-		CParser parser( pE->string() );
-
-		for( std::list<CToken*>::iterator iter = parser.tokens().begin() ; iter != parser.tokens().end(); ++ iter )
-		{
-		  CToken * token = *iter;
-		  if( token->m_key == "l" )
-		  {
-			 std::string line = strutil::trim( token->m_value, "()");
-			 pE->length() = strutil::parseString<double>(line) ;		
-		  }
-		}
-	}
+	_read_trait_column<double>( pMesh->edgeTraits(), M::MeshEdgeIterator( pMesh ), "l", []( E * pE, double l ){ pE->length() = l; } );
 };
 
 template<typename M>
 void _read_edge_length_trait( M * pMesh )
 {
-	for( M::MeshEdgeIterator eiter( pMesh ); !eiter.end(); eiter ++ )
-	{
-		M::CEdge * pE = *eiter;
-
-		CParser parser( pE->string() );
-
-		for( std::list<CToken*>::iterator iter = parser.tokens().begin() ; iter != parser.tokens().end(); ++ iter )
-		{
-		  CToken * token = *iter;
-		  if( token->m_key == "l" )
-		  {
-			 std::string line = strutil::trim( token->m_value, "()");
-			 pE->length() = strutil::parseString<double>(line) ;		
-		  }
-		}
-	}
+	_read_trait_column<double>( pMesh->edgeTraits(), M::MeshEdgeIterator( pMesh ), "l", []( M::CEdge * pE, double l ){ pE->length() = l; } );
 };
 
 template<typename M, typename V, typename E, typename F, typename H>
@@ -371,166 +203,48 @@ void _read_edge_sharp( M * pMesh )
 	for( M::MeshEdgeIterator eiter( pMesh ); !eiter.end(); eiter ++ )
 	{
 		E * pE = *eiter;
-
-		CParser parser( pE->string() );
 		pE->sharp() = false;
-
-		for( std::list<CToken*>::iterator iter = parser.tokens().begin() ; iter != parser.tokens().end(); ++ iter )
-		{
-		  CToken * token = *iter;
-		  if( token->m_key == "sharp" )
-		  {
-			  pE->sharp() = true;
-		  }
-		}
 	}
+	_read_trait_column<bool>( pMesh->edgeTraits(), M::MeshEdgeIterator( pMesh ), "sharp", []( E * pE, bool sharp ){ pE->sharp() = sharp; } );
 };
 
 template<typename M, typename V, typename E, typename F, typename H>
 void _write_vertex_z( M * pMesh )
 {
-	for( M::MeshVertexIterator viter( pMesh ); !viter.end(); viter ++ )
-	{
-		V * pV = *viter;
-		CParser parser( pV->string() );
-		parser._removeToken( "z" );
-
-		parser._toString( pV->string() );
-
-		std::stringstream iss;
-
-		iss << "z=(" << pV->z().real() << " " << pV->z().imag() << ")";
-
-		if( pV->string().size() > 0 )
-		{
-		  pV->string() += " ";
-		}
-		pV->string() += iss.str();
-	}
+	_write_trait_column<CPoint2>( pMesh->vertexTraits(), M::MeshVertexIterator( pMesh ), "z", []( V * pV ){ return CPoint2( pV->z().real(), pV->z().imag() ); } );
 };
 
 
 template<typename M, typename V, typename E, typename F, typename H>
 void _write_vertex_mu( M * pMesh )
 {
-	for( M::MeshVertexIterator viter( pMesh ); !viter.end(); viter ++ )
-	{
-		V * pV = *viter;
-		CParser parser( pV->string() );
-		parser._removeToken( "mu" );
-
-		parser._toString( pV->string() );
-
-		std::stringstream iss;
-
-		iss << "mu=(" << pV->mu().real() << " " << pV->mu().imag() << ")";
-
-		if( pV->string().size() > 0 )
-		{
-		  pV->string() += " ";
-		}
-		pV->string() += iss.str();
-	}
+	_write_trait_column<CPoint2>( pMesh->vertexTraits(), M::MeshVertexIterator( pMesh ), "mu", []( V * pV ){ return CPoint2( pV->mu().real(), pV->mu().imag() ); } );
 };
 
 template<typename M, typename V, typename E, typename F, typename H>
 void _write_vertex_u( M * pMesh )
 {
-	for( M::MeshVertexIterator viter( pMesh ); !viter.end(); viter ++ )
-	{
-		V * pV = *viter;
-		CPoint rgb = pV->rgb();
-
-		CParser parser( pV->string() );
-		parser._removeToken( "u" );
-		parser._toString( pV->string() );
-		CPoint u = pV->u();
-		std::stringstream iss;
-		iss << "u=(" << u[0] << " " << u[1] << " " << u[2] << ")";
-
-		if( pV->string().size() > 0 )
-		{
-		  pV->string() += " ";
-		}
-		pV->string() += iss.str();
-	}
+	_write_trait_column<CPoint>( pMesh->vertexTraits(), M::MeshVertexIterator( pMesh ), "u", []( V * pV ){ return pV->u(); } );
 };
 
 
 template<typename M, typename V, typename E, typename F, typename H>
 void _write_vertex_rgb( M * pMesh )
 {
-	for( M::MeshVertexIterator viter( pMesh ); !viter.end(); viter ++ )
-	{
-		V * pV = *viter;
-		CPoint rgb = pV->rgb();
-
-		CParser parser( pV->string() );
-		parser._removeToken( "rgb" );
-		
-		parser._toString( pV->string() );
-		
-		std::stringstream iss;
-		
-		iss << "rgb=(" << rgb[0] << " " << rgb[1] << " " << rgb[2] << ")";
-
-		if( pV->string().size() > 0 )
-		{
-		  pV->string() += " ";
-		}
-		pV->string() += iss.str();
-	}
+	_write_trait_column<CPoint>( pMesh->vertexTraits(), M::MeshVertexIterator( pMesh ), "rgb", []( V * pV ){ return pV->rgb(); } );
 };
 
 template<typename M>
 void _write_vertex_rgb_trait( M * pMesh )
 {
-	for( M::MeshVertexIterator viter( pMesh ); !viter.end(); viter ++ )
-	{
-		M::CVertex * pV = *viter;
-		CPoint rgb = pV->rgb();
-
-		CParser parser( pV->string() );
-		parser._removeToken( "rgb" );
-		
-		parser._toString( pV->string() );
-		
-		std::stringstream iss;
-		
-		iss << "rgb=(" << rgb[0] << " " << rgb[1] << " " << rgb[2] << ")";
-
-		if( pV->string().size() > 0 )
-		{
-		  pV->string() += " ";
-		}
-		pV->string() += iss.str();
-	}
+	_write_trait_column<CPoint>( pMesh->vertexTraits(), M::MeshVertexIterator( pMesh ), "rgb", []( M::CVertex * pV ){ return pV->rgb(); } );
 };
 
 
 template<typename M, typename V, typename E, typename F, typename H>
 void _write_edge_sharp( M * pMesh )
 {
-	for( M::MeshEdgeIterator eiter( pMesh ); !eiter.end(); eiter ++ )
-	{
-		E * pE = *eiter;
-		CParser parser( pE->string() );
-		parser._removeToken( "sharp" );
-		parser._toString( pE->string() );
-		
-		std::string line;
-		std::stringstream iss(line);
-		if( pE->sharp() )
-		{
-			iss << "sharp";
-		}
-		if( pE->string().length() > 0 )
-		{
-			pE->string() += " ";
-		}
-		pE->string() += iss.str();
-
-	};
+	_write_trait_column<bool>( pMesh->edgeTraits(), M::MeshEdgeIterator( pMesh ), "sharp", []( E * pE ){ return pE->sharp(); } );
 };
 
 
@@ -539,24 +253,7 @@ void _write_edge_sharp( M * pMesh )
 template<typename M, typename V, typename E, typename F, typename H>
 void _write_edge_du( M * pMesh )
 {
-	for( M::MeshEdgeIterator eiter( pMesh ); !eiter.end(); eiter ++ )
-	{
-		E * pE = *eiter;
-		CParser parser( pE->string() );
-		parser._removeToken( "du" );
-
-		parser._toString( pE->string() );
-
-		std::stringstream iss;
-
-		iss << "du=(" << pE->du() << ")";
-
-		if( pE->string().size() > 0 )
-		{
-		  pE->string() += " ";
-		}
-		pE->string() += iss.str();
-	}
+	_write_trait_column<double>( pMesh->edgeTraits(), M::MeshEdgeIterator( pMesh ), "du", []( E * pE ){ return pE->du(); } );
 };
 
 
@@ -628,92 +325,27 @@ void _output_traits( M * pMesh )
 template<typename M>
 void _write_edge_length_trait( M * pMesh )
 {
-	for( M::MeshEdgeIterator eiter( pMesh ); !eiter.end(); eiter ++ )
-	{
-		M::CEdge * pE = *eiter;
-		CParser parser( pE->string() );
-		parser._removeToken( "l" );
-		parser._toString( pE->string() );
-
-		std::stringstream iss;
-		iss << "l=("<< std::setprecision(12) << pE->length() << ")";
-		if( pE->string().size() > 0 )
-		{
-			pE->string() += " ";
-		}
-		pE->string() += iss.str();
-	}
+	_write_trait_column<double>( pMesh->edgeTraits(), M::MeshEdgeIterator( pMesh ), "l", []( M::CEdge * pE ){ return pE->length(); } );
 };
 
 
 template<typename M>
 void _write_edge_sharp_trait( M * pMesh )
 {
-	for( M::MeshEdgeIterator eiter( pMesh ); !eiter.end(); eiter ++ )
-	{
-		M::CEdge * pE = *eiter;
-		CParser parser( pE->string() );
-		parser._removeToken( "sharp" );
-		parser._toString( pE->string() );
-		
-		std::string line;
-		std::stringstream iss(line);
-		if( pE->sharp() )
-		{
-			iss << "sharp";
-		}
-		if( pE->string().length() > 0 )
-		{
-			pE->string() += " ";
-		}
-		pE->string() += iss.str();
-
-	};
+	_write_trait_column<bool>( pMesh->edgeTraits(), M::MeshEdgeIterator( pMesh ), "sharp", []( M::CEdge * pE ){ return pE->sharp(); } );
 };
 
 
 template<typename M>
 void _read_face_mu( M * pMesh )
 {
-	for( M::MeshFaceIterator fiter( pMesh ); !fiter.end(); fiter ++ )
-	{
-		M::CFace * pF = *fiter;
-		CParser parser( pF->string() );
-		
-		for( std::list<CToken*>::iterator iter = parser.tokens().begin() ; iter != parser.tokens().end(); ++ iter )
-		{
-		  CToken * token = *iter;
-		  if( token->m_key == "mu" )
-		  {
-			  CPoint2 uv;
-			  token->m_value >> uv;
-			  pF->mu() = std::complex<double>( uv[0], uv[1] );
-		  }
-		}
-	}
+	_read_trait_column<CPoint2>( pMesh->faceTraits(), M::MeshFaceIterator( pMesh ), "mu", []( M::CFace * pF, const CPoint2 & uv ){ pF->mu() = std::complex<double>( uv[0], uv[1] ); } );
 };
 
 template<typename M>
 void _write_face_mu( M * pMesh )
 {
-	for( M::MeshFaceIterator fiter( pMesh ); !fiter.end(); fiter ++ )
-	{
-		M::CFace * pF = *fiter;
-		CParser parser( pF->string() );
-		parser._removeToken( "mu" );
-
-		parser._toString( pF->string() );
-
-		std::stringstream iss;
-
-		iss << "mu=(" << pF->mu().real() << " " << pF->mu().imag() << ")";
-
-		if( pF->string().size() > 0 )
-		{
-		  pF->string() += " ";
-		}
-		pF->string() += iss.str();
-	}
+	_write_trait_column<CPoint2>( pMesh->faceTraits(), M::MeshFaceIterator( pMesh ), "mu", []( M::CFace * pF ){ return CPoint2( pF->mu().real(), pF->mu().imag() ); } );
 };
 
 }
@@ -0,0 +1,255 @@
+/*!
+*      \file LaplaceMatrix.h
+*      \brief Assemble the Laplace matrix of a mesh from its edge weights
+*
+*		The free vertices are the unknowns, numbered in the order of the vertex list;
+*		the fixed vertices are numbered separately. Row i of a free vertex v reads
+*
+*			sum_{u ~ v} w(uv) x_v  -  sum_{u ~ v, u free} w(uv) x_u  =  b_v  +  sum_{u ~ v, u fixed} w(uv) x_u
+*
+*		matrix() holds the left side, symmetric and positive definite as soon as one
+*		vertex of each component is fixed, boundary() the coupling with the fixed
+*		vertices ( the negative weights ), so the right side is b - boundary() x_fixed.
+*
+*		build() computes the numbering and the sparsity pattern once, assemble()
+*		only rewrites the values and can be called again whenever the weights change.
+*/
+
+#ifndef _MESHLIB_LAPLACE_MATRIX_H_
+#define _MESHLIB_LAPLACE_MATRIX_H_
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <climits>
+
+#include "SparseMatrix.h"
+#include "../Mesh/iterators.h"
+#include "../Parallel/Parallel.h"
+
+namespace MeshLib{
+
+/*! no vertex is fixed */
+struct CLaplaceNoFixed
+{
+	template<typename V>
+	bool operator()( V * ) const { return false; };
+};
+
+/*! the edge weight is e->weight(), as set by COperator::_angle_2_Laplace or _combinatorial_Laplace */
+struct CLaplaceEdgeWeight
+{
+	template<typename E>
+	double operator()( E * e ) const { return e->weight(); };
+};
+
+/*!
+*	\brief CLaplaceMatrix, the Laplace matrix of a mesh in CSR form
+*	\tparam M a CBaseMesh
+*/
+template<typename M>
+class CLaplaceMatrix
+{
+public:
+	/*! CLaplaceMatrix constructor */
+	CLaplaceMatrix( M * pMesh ) { m_pMesh = pMesh; };
+
+	/*!
+	Number the vertices and build the sparsity pattern.
+	\param fixed   functor called as fixed( CVertex * ), true for the fixed vertices,
+	               e.g. [](CToolVertex * v){ return v->fixed(); }
+	\param threads number of threads, 0 for all the hardware threads
+	*/
+	template<typename Fixed>
+	void build( Fixed fixed, int threads = 0 );
+
+	/*!
+	Compute the values from the edge weights, the pattern of build() is reused.
+	\param weight  functor called as weight( CEdge * ), e.g. CLaplaceEdgeWeight()
+	\param threads number of threads, 0 for all the hardware threads
+	*/
+	template<typename Weight>
+	void assemble( Weight weight, int threads = 0 );
+
+	/*! matrix of the free vertices */
+	CSparseMatrix & matrix()	{ return m_matrix; };
+	/*! coupling of the free vertices with the fixed ones */
+	CSparseMatrix & boundary()	{ return m_boundary; };
+
+	/*! the free vertices, by row */
+	std::vector<typename M::CVertex*> & freeVertices()	{ return m_free; };
+	/*! the fixed vertices, by column of boundary() */
+	std::vector<typename M::CVertex*> & fixedVertices()	{ return m_fixed; };
+	/*! row of a free vertex, -1 for a fixed vertex or a vertex added after build() */
+	int row( typename M::CVertex * v )		{ int i = _index( v ); return ( i >= 0 )? i : -1; };
+	/*! column of a fixed vertex in boundary(), -1 for a free vertex or a vertex added after build() */
+	int fixedIndex( typename M::CVertex * v )	{ int i = _index( v ); return ( i < 0 && i != INT_MIN )? -1 - i : -1; };
+
+protected:
+	/*! m_index of the vertex, INT_MIN if its slot is not numbered or numbers another vertex, e.g. a deleted one */
+	int _index( typename M::CVertex * v )
+	{
+		int slot = v->slot();
+		return ( slot >= 0 && slot < (int) m_index.size() && m_id[slot] == v->id() )? m_index[slot] : INT_MIN;
+	};
+	/*! the mesh */
+	M *                                 m_pMesh;
+	/*! free vertices */
+	std::vector<typename M::CVertex*>   m_free;
+	/*! fixed vertices */
+	std::vector<typename M::CVertex*>   m_fixed;
+	/*! by vertex slot, the row i >= 0 of a free vertex, -1-k for the fixed vertex k */
+	std::vector<int>                    m_index;
+	/*! by vertex slot, the id of the numbered vertex, a reused slot holds a new id */
+	std::vector<int>                    m_id;
+	/*! matrix of the free vertices */
+	CSparseMatrix                       m_matrix;
+	/*! coupling with the fixed vertices */
+	CSparseMatrix                       m_boundary;
+	/*! edge slot of each entry of m_matrix, -1 on the diagonal */
+	std::vector<int>                    m_matrix_edge;
+	/*! edge slot of each entry of m_boundary */
+	std::vector<int>                    m_boundary_edge;
+	/*! edge weights, by edge slot */
+	std::vector<double>                 m_weight;
+};
+
+template<typename M>
+template<typename Fixed>
+void CLaplaceMatrix<M>::build( Fixed fixed, int threads )
+{
+	threads = parallelThreads( threads );
+
+	m_free.clear();
+	m_fixed.clear();
+	m_index.assign( m_pMesh->vertexTraits().size(), INT_MIN );
+	m_id.assign( m_pMesh->vertexTraits().size(), INT_MIN );
+	for( std::list<M::CVertex*>::iterator viter = m_pMesh->vertices().begin(); viter != m_pMesh->vertices().end(); viter ++ )
+	{
+		M::CVertex * v = *viter;
+		m_id[v->slot()] = v->id();
+		if( fixed( v ) )
+		{
+			m_index[v->slot()] = -1 - (int) m_fixed.size();
+			m_fixed.push_back( v );
+		}
+		else
+		{
+			m_index[v->slot()] = (int) m_free.size();
+			m_free.push_back( v );
+		}
+	}
+	int n = (int) m_free.size();
+
+	//count the entries of each row
+	std::vector<size_t> mstart( n + 1, 0 );
+	std::vector<size_t> bstart( n + 1, 0 );
+	parallelFor( (size_t) n, threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ )
+		{
+			mstart[i+1] = 1;
+			for( M::VertexEdgeIterator veiter( m_free[i] ); !veiter.end(); veiter ++ )
+			{
+				M::CEdge * pE = *veiter;
+				M::CVertex * u = ( m_pMesh->edgeVertex1( pE ) == m_free[i] )? m_pMesh->edgeVertex2( pE ) : m_pMesh->edgeVertex1( pE );
+				if( m_index[u->slot()] >= 0 ) mstart[i+1] ++;
+				else bstart[i+1] ++;
+			}
+		}
+	});
+	for( int i = 0; i < n; i ++ )
+	{
+		mstart[i+1] += mstart[i];
+		bstart[i+1] += bstart[i];
+	}
+
+	//fill the rows, sorted by column
+	std::vector<int> mcolumn( mstart[n] ), bcolumn( bstart[n] );
+	m_matrix_edge.resize( mstart[n] );
+	m_boundary_edge.resize( bstart[n] );
+	parallelFor( (size_t) n, threads, [&]( size_t b, size_t e, int )
+	{
+		std::vector< std::pair<int,int> > mrow, brow;
+		for( size_t i = b; i < e; i ++ )
+		{
+			mrow.clear();
+			brow.clear();
+			mrow.push_back( std::make_pair( (int) i, -1 ) );
+			for( M::VertexEdgeIterator veiter( m_free[i] ); !veiter.end(); veiter ++ )
+			{
+				M::CEdge * pE = *veiter;
+				M::CVertex * u = ( m_pMesh->edgeVertex1( pE ) == m_free[i] )? m_pMesh->edgeVertex2( pE ) : m_pMesh->edgeVertex1( pE );
+				int k = m_index[u->slot()];
+				if( k >= 0 ) mrow.push_back( std::make_pair( k, pE->slot() ) );
+				else brow.push_back( std::make_pair( -1 - k, pE->slot() ) );
+			}
+			std::sort( mrow.begin(), mrow.end() );
+			std::sort( brow.begin(), brow.end() );
+
+			for( size_t k = 0; k < mrow.size(); k ++ )
+			{
+				mcolumn[mstart[i]+k]       = mrow[k].first;
+				m_matrix_edge[mstart[i]+k] = mrow[k].second;
+			}
+			for( size_t k = 0; k < brow.size(); k ++ )
+			{
+				bcolumn[bstart[i]+k]         = brow[k].first;
+				m_boundary_edge[bstart[i]+k] = brow[k].second;
+			}
+		}
+	});
+
+	m_matrix.setPattern( n, n, mstart, mcolumn );
+	m_boundary.setPattern( n, (int) m_fixed.size(), bstart, bcolumn );
+};
+
+template<typename M>
+template<typename Weight>
+void CLaplaceMatrix<M>::assemble( Weight weight, int threads )
+{
+	threads = parallelThreads( threads );
+
+	//each weight is evaluated once
+	std::vector<M::CEdge*> edges( m_pMesh->edges().begin(), m_pMesh->edges().end() );
+	m_weight.resize( m_pMesh->edgeTraits().size() );
+	parallelFor( edges.size(), threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ ) m_weight[edges[i]->slot()] = weight( edges[i] );
+	});
+
+	std::vector<size_t> & mstart = m_matrix.rowStart();
+	std::vector<size_t> & bstart = m_boundary.rowStart();
+	std::vector<double> & mvalue = m_matrix.values();
+	std::vector<double> & bvalue = m_boundary.values();
+	parallelFor( (size_t) m_matrix.rows(), threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ )
+		{
+			double d = 0;
+			size_t diag = mstart[i];
+			for( size_t k = mstart[i]; k < mstart[i+1]; k ++ )
+			{
+				if( m_matrix_edge[k] < 0 )
+				{
+					diag = k;
+					continue;
+				}
+				double w = m_weight[m_matrix_edge[k]];
+				mvalue[k] = -w;
+				d += w;
+			}
+			for( size_t k = bstart[i]; k < bstart[i+1]; k ++ )
+			{
+				double w = m_weight[m_boundary_edge[k]];
+				bvalue[k] = -w;
+				d += w;
+			}
+			mvalue[diag] = d;
+		}
+	});
+};
+
+}//name space MeshLib
+
+#endif //_MESHLIB_LAPLACE_MATRIX_H_ defined
@@ -0,0 +1,441 @@
+/*!
+*      \file PCGSolver.h
+*      \brief Preconditioned conjugate gradient for symmetric positive definite CSR matrices
+*
+*		Several right hand sides are solved together, e.g. u and v of a
+*		parameterization: the iterations run in lockstep and each matrix product
+*		reads the matrix once for all of them. The products and the vector updates
+*		run on several threads, the dot products are deterministic sums, so the
+*		iterates do not depend on the thread count.
+*
+*		The preconditioner is the diagonal ( Jacobi ), or the incomplete Cholesky
+*		factorization with the pattern of the matrix ( IC(0) ), whose triangular
+*		solves are sequential but run on one thread per right hand side.
+*/
+
+#ifndef _MESHLIB_PCG_SOLVER_H_
+#define _MESHLIB_PCG_SOLVER_H_
+
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+
+#include "SparseMatrix.h"
+#include "../Parallel/Parallel.h"
+#include "../Parallel/Reduce.h"
+
+namespace MeshLib{
+
+/*!
+*	\brief CPCGReport, the outcome of the solve of one right hand side
+*/
+struct CPCGReport
+{
+	/*! number of iterations */
+	int    iterations;
+	/*! final residual |b - Ax| / |b| */
+	double residual;
+	/*! whether the residual reached the tolerance */
+	bool   converged;
+};
+
+/*!
+*	\brief CPCGSolver, preconditioned conjugate gradient
+*/
+class CPCGSolver
+{
+public:
+	/*! preconditioners */
+	enum { NONE, JACOBI, INCOMPLETE_CHOLESKY };
+
+	/*!
+	CPCGSolver constructor, Jacobi preconditioner
+	\param A symmetric positive ( semi ) definite matrix, with both triangles stored;
+	         it must outlive the solver
+	*/
+	CPCGSolver( const CSparseMatrix & A ) : m_A( A )
+	{
+		m_max_iterations = 10000;
+		m_tolerance      = 1e-10;
+		m_threads        = 0;
+		m_verbose        = false;
+		setPreconditioner( JACOBI );
+	};
+
+	/*! maximal number of iterations */
+	int    & maxIterations()	{ return m_max_iterations; };
+	/*! relative residual |b - Ax| / |b| to reach */
+	double & tolerance()		{ return m_tolerance; };
+	/*! number of threads, 0 for all the hardware threads */
+	int    & threads()			{ return m_threads; };
+	/*! print the residuals of each iteration */
+	bool   & verbose()			{ return m_verbose; };
+
+	/*!
+	Choose the preconditioner and compute it from the matrix. Call it again after
+	the values of the matrix change.
+	\param type NONE, JACOBI or INCOMPLETE_CHOLESKY
+	*/
+	void setPreconditioner( int type );
+
+	/*!
+	Solve A x[c] = b[c] for all c.
+	\param b the right hand sides
+	\param x the initial guesses ( warm start ), the solutions on return; a
+	         vector of the wrong size starts from zero
+	\return the reports, one per right hand side
+	*/
+	const std::vector<CPCGReport> & solve( const std::vector< std::vector<double> > & b, std::vector< std::vector<double> > & x );
+
+	/*! solve A x = b, x is the initial guess */
+	CPCGReport solve( const std::vector<double> & b, std::vector<double> & x )
+	{
+		std::vector< std::vector<double> > bs( 1, b ), xs( 1 );
+		xs[0].swap( x );
+		solve( bs, xs );
+		x.swap( xs[0] );
+		return m_reports[0];
+	};
+
+	/*! the reports of the last solve */
+	const std::vector<CPCGReport> & reports() const { return m_reports; };
+
+protected:
+	/*! the matrix */
+	const CSparseMatrix &   m_A;
+	/*! the preconditioner */
+	int                     m_type;
+	/*! inverse diagonal, for JACOBI */
+	std::vector<double>     m_inv_diag;
+	/*! lower triangle of the incomplete Cholesky factor, for INCOMPLETE_CHOLESKY */
+	CSparseMatrix           m_L;
+	/*! maximal number of iterations */
+	int                     m_max_iterations;
+	/*! relative residual to reach */
+	double                  m_tolerance;
+	/*! number of threads */
+	int                     m_threads;
+	/*! print the residuals */
+	bool                    m_verbose;
+	/*! the reports of the last solve */
+	std::vector<CPCGReport> m_reports;
+
+	/*! factorize A + shift diag(A), false if a pivot is not positive */
+	bool _factorize( double shift );
+	/*! z = M^-1 r */
+	void _precondition( const std::vector<double> & r, std::vector<double> & z, int threads );
+	/*! x . y */
+	static double _dot( const std::vector<double> & x, const std::vector<double> & y, int threads )
+	{
+		return parallelSum( x.size(), threads, 0.0, [&]( size_t i ) { return x[i] * y[i]; } );
+	};
+};
+
+inline void CPCGSolver::setPreconditioner( int type )
+{
+	m_type = type;
+	m_inv_diag.clear();
+	m_L = CSparseMatrix();
+
+	if( type == INCOMPLETE_CHOLESKY )
+	{
+		//IC(0) breaks down on matrices which are not diagonally dominant enough, shift the diagonal until it succeeds
+		double shift = 0;
+		while( !_factorize( shift ) )
+		{
+			shift = ( shift == 0 )? 1e-3 : shift * 2;
+			if( shift > 1 )
+			{
+				fprintf( stderr, "CPCGSolver: incomplete Cholesky failed, using Jacobi\n" );
+				m_type = JACOBI;
+				break;
+			}
+		}
+	}
+
+	if( m_type == JACOBI )
+	{
+		m_A.diagonal( m_inv_diag );
+		for( size_t i = 0; i < m_inv_diag.size(); i ++ ) m_inv_diag[i] = ( m_inv_diag[i] != 0 )? 1.0 / m_inv_diag[i] : 1.0;
+	}
+};
+
+inline bool CPCGSolver::_factorize( double shift )
+{
+	const std::vector<size_t> & start  = m_A.rowStart();
+	const std::vector<int>    & column = m_A.columns();
+	const std::vector<double> & value  = m_A.values();
+	int n = m_A.rows();
+
+	//pattern of the lower triangle, the diagonal last in each row
+	std::vector<size_t> lstart( n + 1, 0 );
+	for( int i = 0; i < n; i ++ )
+	{
+		size_t c = 0;
+		for( size_t k = start[i]; k < start[i+1]; k ++ ) if( column[k] <= i ) c ++;
+		lstart[i+1] = lstart[i] + c;
+	}
+	std::vector<int>    lcolumn( lstart[n] );
+	std::vector<double> lvalue( lstart[n], 0.0 );
+
+	for( int i = 0; i < n; i ++ )
+	{
+		size_t p = lstart[i];
+		bool diagonal = false;
+		for( size_t k = start[i]; k < start[i+1] && column[k] <= i; k ++ )
+		{
+			lcolumn[p] = column[k];
+			lvalue[p]  = value[k];
+			if( column[k] == i )
+			{
+				lvalue[p] *= 1 + shift;
+				diagonal = true;
+			}
+			p ++;
+		}
+		if( !diagonal ) return false;
+	}
+
+	//L(i,j) = ( A(i,j) - sum_m L(i,m) L(j,m) ) / L(j,j), over the pattern
+	for( int i = 0; i < n; i ++ )
+	{
+		size_t ie = lstart[i+1] - 1;
+		for( size_t k = lstart[i]; k < ie; k ++ )
+		{
+			int j = lcolumn[k];
+			size_t a = lstart[i], b = lstart[j], be = lstart[j+1] - 1;
+			double s = lvalue[k];
+			while( a < k && b < be )
+			{
+				if( lcolumn[a] < lcolumn[b] ) a ++;
+				else if( lcolumn[a] > lcolumn[b] ) b ++;
+				else s -= lvalue[a++] * lvalue[b++];
+			}
+			lvalue[k] = s / lvalue[be];
+		}
+
+		double d = lvalue[ie];
+		for( size_t k = lstart[i]; k < ie; k ++ ) d -= lvalue[k] * lvalue[k];
+		if( !( d > 0 ) ) return false;
+		lvalue[ie] = sqrt( d );
+	}
+
+	m_L.setPattern( n, n, lstart, lcolumn );
+	m_L.values().swap( lvalue );
+	return true;
+};
+
+inline void CPCGSolver::_precondition( const std::vector<double> & r, std::vector<double> & z, int threads )
+{
+	size_t n = r.size();
+
+	if( m_type == NONE )
+	{
+		z = r;
+		return;
+	}
+
+	if( m_type == JACOBI )
+	{
+		parallelFor( n, threads, [&]( size_t b, size_t e, int )
+		{
+			for( size_t i = b; i < e; i ++ ) z[i] = r[i] * m_inv_diag[i];
+		});
+		return;
+	}
+
+	//L y = r, then L^T z = y
+	const std::vector<size_t> & start  = m_L.rowStart();
+	const std::vector<int>    & column = m_L.columns();
+	const std::vector<double> & value  = m_L.values();
+
+	for( size_t i = 0; i < n; i ++ )
+	{
+		double s = r[i];
+		size_t d = start[i+1] - 1;
+		for( size_t k = start[i]; k < d; k ++ ) s -= value[k] * z[column[k]];
+		z[i] = s / value[d];
+	}
+	for( size_t i = n; i -- > 0; )
+	{
+		size_t d = start[i+1] - 1;
+		z[i] /= value[d];
+		for( size_t k = start[i]; k < d; k ++ ) z[column[k]] -= value[k] * z[i];
+	}
+};
+
+inline const std::vector<CPCGReport> & CPCGSolver::solve( const std::vector< std::vector<double> > & b, std::vector< std::vector<double> > & x )
+{
+	int    threads = parallelThreads( m_threads );
+	int    nrhs    = (int) b.size();
+	size_t n       = (size_t) m_A.rows();
+
+	x.resize( nrhs );
+	m_reports.assign( nrhs, CPCGReport() );
+
+	std::vector< std::vector<double> > r( nrhs ), z( nrhs ), p( nrhs ), q( nrhs );
+	std::vector<double> rz( nrhs ), bnorm( nrhs );
+	std::vector<bool>   active( nrhs, true );
+
+	for( int c = 0; c < nrhs; c ++ )
+	{
+		if( x[c].size() != n ) x[c].assign( n, 0.0 );
+		r[c].resize( n );
+		z[c].resize( n );
+		q[c].resize( n );
+		m_reports[c].iterations = 0;
+		m_reports[c].converged  = false;
+	}
+
+	//products of the matrix with the active vectors, the matrix is read once for all of them
+	std::vector<const double*> in( nrhs );
+	std::vector<double*>       out( nrhs );
+	const std::vector<size_t> & start  = m_A.rowStart();
+	const std::vector<int>    & column = m_A.columns();
+	const std::vector<double> & value  = m_A.values();
+	auto multiply = [&]( int count )
+	{
+		parallelFor( n, threads, [&]( size_t ib, size_t ie, int )
+		{
+			//up to four vectors per pass, summed in registers
+			for( int c0 = 0; c0 < count; c0 += 4 )
+			{
+				int cn = std::min( 4, count - c0 );
+				for( size_t i = ib; i < ie; i ++ )
+				{
+					double sum[4] = { 0, 0, 0, 0 };
+					for( size_t k = start[i]; k < start[i+1]; k ++ )
+					{
+						for( int c = 0; c < cn; c ++ ) sum[c] += value[k] * in[c0+c][column[k]];
+					}
+					for( int c = 0; c < cn; c ++ ) out[c0+c][i] = sum[c];
+				}
+			}
+		});
+	};
+	//the preconditioner of each active vector, the triangular solves of IC(0) on their own threads
+	auto precondition = [&]()
+	{
+		if( m_type != INCOMPLETE_CHOLESKY )
+		{
+			for( int c = 0; c < nrhs; c ++ ) if( active[c] ) _precondition( r[c], z[c], threads );
+			return;
+		}
+		parallelFor( (size_t) nrhs, nrhs, [&]( size_t cb, size_t ce, int )
+		{
+			for( size_t c = cb; c < ce; c ++ ) if( active[c] ) _precondition( r[c], z[c], 1 );
+		});
+	};
+
+	//r = b - A x
+	for( int c = 0; c < nrhs; c ++ )
+	{
+		in[c]  = x[c].data();
+		out[c] = q[c].data();
+	}
+	multiply( nrhs );
+	for( int c = 0; c < nrhs; c ++ )
+	{
+		std::vector<double> & rc = r[c];
+		const std::vector<double> & bc = b[c];
+		const std::vector<double> & qc = q[c];
+		parallelFor( n, threads, [&]( size_t ib, size_t ie, int )
+		{
+			for( size_t i = ib; i < ie; i ++ ) rc[i] = bc[i] - qc[i];
+		});
+		bnorm[c] = sqrt( _dot( b[c], b[c], threads ) );
+		if( bnorm[c] == 0 )
+		{
+			//the solution of A x = 0
+			x[c].assign( n, 0.0 );
+			m_reports[c].residual  = 0;
+			m_reports[c].converged = true;
+			active[c] = false;
+			continue;
+		}
+		m_reports[c].residual = sqrt( _dot( r[c], r[c], threads ) ) / bnorm[c];
+		if( m_reports[c].residual <= m_tolerance )
+		{
+			m_reports[c].converged = true;
+			active[c] = false;
+		}
+	}
+
+	precondition();
+	for( int c = 0; c < nrhs; c ++ )
+	{
+		if( !active[c] ) continue;
+		p[c]  = z[c];
+		rz[c] = _dot( r[c], z[c], threads );
+	}
+
+	for( int it = 0; it < m_max_iterations; it ++ )
+	{
+		int count = 0;
+		std::vector<int> index;
+		for( int c = 0; c < nrhs; c ++ )
+		{
+			if( !active[c] ) continue;
+			in[count]  = p[c].data();
+			out[count] = q[c].data();
+			index.push_back( c );
+			count ++;
+		}
+		if( count == 0 ) break;
+		multiply( count );
+
+		for( int a = 0; a < count; a ++ )
+		{
+			int c = index[a];
+			double pq = _dot( p[c], q[c], threads );
+			double alpha = ( pq != 0 )? rz[c] / pq : 0;
+
+			std::vector<double> & xc = x[c];
+			std::vector<double> & rc = r[c];
+			std::vector<double> & pc = p[c];
+			std::vector<double> & qc = q[c];
+			parallelFor( n, threads, [&]( size_t ib, size_t ie, int )
+			{
+				for( size_t i = ib; i < ie; i ++ )
+				{
+					xc[i] += alpha * pc[i];
+					rc[i] -= alpha * qc[i];
+				}
+			});
+
+			m_reports[c].iterations = it + 1;
+			m_reports[c].residual   = sqrt( _dot( rc, rc, threads ) ) / bnorm[c];
+			if( m_verbose ) printf( "PCG rhs %d iteration %d residual %g\n", c, it + 1, m_reports[c].residual );
+			if( m_reports[c].residual <= m_tolerance || pq == 0 )
+			{
+				m_reports[c].converged = m_reports[c].residual <= m_tolerance;
+				active[c] = false;
+			}
+		}
+
+		precondition();
+		for( int a = 0; a < count; a ++ )
+		{
+			int c = index[a];
+			if( !active[c] ) continue;
+
+			double rz_new = _dot( r[c], z[c], threads );
+			double beta   = rz_new / rz[c];
+			rz[c] = rz_new;
+
+			std::vector<double> & pc = p[c];
+			std::vector<double> & zc = z[c];
+			parallelFor( n, threads, [&]( size_t ib, size_t ie, int )
+			{
+				for( size_t i = ib; i < ie; i ++ ) pc[i] = zc[i] + beta * pc[i];
+			});
+		}
+	}
+
+	return m_reports;
+};
+
+}//name space MeshLib
+
+#endif //_MESHLIB_PCG_SOLVER_H_ defined
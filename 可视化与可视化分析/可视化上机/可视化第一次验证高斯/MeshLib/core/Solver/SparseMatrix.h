@@ -0,0 +1,109 @@
+/*!
+*      \file SparseMatrix.h
+*      \brief Sparse matrix in compressed sparse row ( CSR ) form
+*
+*		The entries of row i are columns()[k], values()[k] for k in
+*		[ rowStart()[i], rowStart()[i+1] ), sorted by column.
+*/
+
+#ifndef _MESHLIB_SPARSE_MATRIX_H_
+#define _MESHLIB_SPARSE_MATRIX_H_
+
+#include <assert.h>
+#include <vector>
+
+#include "../Parallel/Parallel.h"
+
+namespace MeshLib{
+
+/*!
+*	\brief CSparseMatrix, a CSR matrix of doubles
+*/
+class CSparseMatrix
+{
+public:
+	/*! CSparseMatrix constructor, an empty matrix */
+	CSparseMatrix() { m_rows = m_cols = 0; m_start.push_back( 0 ); };
+
+	/*! number of rows */
+	int    rows() const		{ return m_rows; };
+	/*! number of columns */
+	int    cols() const		{ return m_cols; };
+	/*! number of stored entries */
+	size_t nonZeros() const	{ return m_column.size(); };
+
+	/*! first entry of each row, rows() + 1 offsets */
+	std::vector<size_t> & rowStart()	{ return m_start; };
+	/*! column of each entry */
+	std::vector<int>    & columns()		{ return m_column; };
+	/*! value of each entry */
+	std::vector<double> & values()		{ return m_value; };
+	/*! first entry of each row */
+	const std::vector<size_t> & rowStart() const	{ return m_start; };
+	/*! column of each entry */
+	const std::vector<int>    & columns() const		{ return m_column; };
+	/*! value of each entry */
+	const std::vector<double> & values() const		{ return m_value; };
+
+	/*!
+	Set the size and the pattern: the row starts and the columns are taken over,
+	the values are set to zero.
+	*/
+	void setPattern( int rows, int cols, std::vector<size_t> & start, std::vector<int> & column )
+	{
+		assert( (int) start.size() == rows + 1 && start[rows] == column.size() );
+		m_rows = rows;
+		m_cols = cols;
+		m_start.swap( start );
+		m_column.swap( column );
+		m_value.assign( m_column.size(), 0.0 );
+	};
+
+	/*!
+	y = A x
+	\param x cols() values
+	\param y rows() values
+	\param threads number of threads
+	*/
+	void multiply( const double * x, double * y, int threads = 1 ) const
+	{
+		parallelFor( (size_t) m_rows, threads, [&]( size_t b, size_t e, int )
+		{
+			for( size_t i = b; i < e; i ++ )
+			{
+				double s = 0;
+				for( size_t k = m_start[i]; k < m_start[i+1]; k ++ ) s += m_value[k] * x[m_column[k]];
+				y[i] = s;
+			}
+		});
+	};
+
+	/*! the diagonal entries, zero where there is none */
+	void diagonal( std::vector<double> & d ) const
+	{
+		d.assign( m_rows, 0.0 );
+		for( int i = 0; i < m_rows; i ++ )
+		{
+			for( size_t k = m_start[i]; k < m_start[i+1]; k ++ )
+			{
+				if( m_column[k] == i ) d[i] = m_value[k];
+			}
+		}
+	};
+
+protected:
+	/*! number of rows */
+	int                 m_rows;
+	/*! number of columns */
+	int                 m_cols;
+	/*! first entry of each row */
+	std::vector<size_t> m_start;
+	/*! column of each entry */
+	std::vector<int>    m_column;
+	/*! value of each entry */
+	std::vector<double> m_value;
+};
+
+}//name space MeshLib
+
+#endif //_MESHLIB_SPARSE_MATRIX_H_ defined
@@ -0,0 +1,747 @@
+/*!
+*      \file BVH.h
+*      \brief Bounding volume hierarchy over the faces of a triangle mesh
+*
+*		The tree is built top-down with a binned surface area heuristic ( SAH ):
+*		the centroids of a node are sorted into BVH_BINS bins along each axis and the
+*		split minimizing the SAH cost is taken, or the node becomes a leaf when that
+*		is cheaper. The levels are built one after the other, the nodes of a level
+*		on several threads, the large nodes of the first levels with the binning
+*		itself split over the threads.
+*
+*		The nodes are flattened into an array of 32 bytes nodes, float boxes rounded
+*		outwards, the two children of a node next to each other. The triangles are
+*		stored in the leaf order, as a vertex and two edge vectors.
+*
+*		The queries, ray intersection and closest point, give the face, the distance
+*		and the barycentric coordinates of the hit, with respect to the vertices of
+*		the face in the FaceVertexIterator order. The batched queries run on several
+*		threads; the tree is read only, so single queries may be run concurrently.
+*/
+
+#ifndef _MESHLIB_BVH_H_
+#define _MESHLIB_BVH_H_
+
+#include <float.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+
+#include "../Geometry/Point.h"
+#include "../Mesh/iterators.h"
+#include "../Parallel/Parallel.h"
+#include "../Parallel/Reduce.h"
+
+namespace MeshLib{
+
+/*! number of bins of the SAH */
+const int BVH_BINS      = 16;
+/*! a node with at most this number of faces is always a leaf */
+const int BVH_LEAF_SIZE = 2;
+/*! a node with more faces is always split, whatever the SAH */
+const int BVH_MAX_LEAF  = 16;
+/*! below this depth the SAH is used, deeper nodes are split at the median */
+const int BVH_SAH_DEPTH = 64;
+/*! size of the traversal stacks, the depth is at most BVH_SAH_DEPTH + log2( faces ) */
+const int BVH_STACK     = 160;
+
+/*!
+*	\brief CBVHNode, a node of the flattened tree, 32 bytes
+*
+*	A leaf has count > 0 faces, starting at first in the leaf order. An inner
+*	node has count == 0, its children are first and first + 1.
+*/
+struct CBVHNode
+{
+	/*! lower corner of the box */
+	float lo[3];
+	/*! first face of a leaf, or first child */
+	int   first;
+	/*! upper corner of the box */
+	float hi[3];
+	/*! number of faces of a leaf, 0 for an inner node */
+	int   count;
+};
+
+/*!
+*	\brief CBVH, bounding volume hierarchy of the faces of a triangle mesh
+*	\tparam M a CBaseMesh of triangles
+*/
+template<typename M>
+class CBVH
+{
+public:
+	/*!
+	*	\brief CHit, the result of a query
+	*/
+	struct CHit
+	{
+		/*! the face, NULL if there is no hit */
+		typename M::CFace * face;
+		/*! ray parameter of the hit, or distance to the closest point */
+		double              t;
+		/*! barycentric coordinates of the point in the face */
+		double              bary[3];
+		/*! the point */
+		CPoint              point;
+	};
+
+	/*! CBVH constructor, call build() before the queries */
+	CBVH( M * pMesh ) { m_pMesh = pMesh; m_depth = 0; };
+
+	/*!
+	Build the tree from the current positions.
+	\param threads number of threads, 0 for all the hardware threads
+	*/
+	void build( int threads = 0 );
+
+	/*!
+	First intersection of a ray with the faces.
+	\param origin    origin of the ray
+	\param direction direction of the ray, need not be normalized
+	\param hit       the hit, t is in units of direction
+	\param tmax      only the hits with 0 <= t <= tmax count
+	\return true if there is a hit
+	*/
+	bool intersect( const CPoint & origin, const CPoint & direction, CHit & hit, double tmax = DBL_MAX ) const;
+	/*!
+	First intersections of several rays, on several threads; a ray without hit gets face NULL.
+	*/
+	void intersect( const std::vector<CPoint> & origins, const std::vector<CPoint> & directions, std::vector<CHit> & hits, int threads = 0 ) const;
+
+	/*!
+	Closest point of the faces to a point.
+	\param p           the point
+	\param hit         the closest point, t is its distance to p
+	\param maxDistance only the points closer than maxDistance count
+	\return true if there is such a point
+	*/
+	bool closest( const CPoint & p, CHit & hit, double maxDistance = DBL_MAX ) const;
+	/*!
+	Closest points to several points, on several threads.
+	*/
+	void closest( const std::vector<CPoint> & points, std::vector<CHit> & hits, int threads = 0 ) const;
+
+	/*! the nodes, the root first */
+	const std::vector<CBVHNode> & nodes() const	{ return m_nodes; };
+	/*! depth of the tree, 1 for a single leaf */
+	int depth() const							{ return m_depth; };
+
+protected:
+	/*! a box, lo[3] and hi[3] */
+	struct CBox
+	{
+		double lo[3], hi[3];
+		/*! the empty box */
+		static CBox empty() { CBox b; for( int k = 0; k < 3; k ++ ) { b.lo[k] = DBL_MAX; b.hi[k] = -DBL_MAX; } return b; };
+		/*! grow to contain the box a */
+		void add( const CBox & a ) { for( int k = 0; k < 3; k ++ ) { b_min( lo[k], a.lo[k] ); b_max( hi[k], a.hi[k] ); } };
+		/*! grow to contain the point p */
+		void add( const double * p ) { for( int k = 0; k < 3; k ++ ) { b_min( lo[k], p[k] ); b_max( hi[k], p[k] ); } };
+		/*! half of the surface area */
+		double area() const
+		{
+			if( lo[0] > hi[0] ) return 0;
+			double d[3] = { hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2] };
+			return d[0] * d[1] + d[1] * d[2] + d[2] * d[0];
+		};
+		static void b_min( double & a, double b ) { if( b < a ) a = b; };
+		static void b_max( double & a, double b ) { if( b > a ) a = b; };
+	};
+
+	/*! a face during the build, partitioned in place so that the passes are sequential */
+	struct CPrim
+	{
+		/*! box of the face */
+		CBox box;
+		/*! the face */
+		int  index;
+		/*! coordinate k of the centroid of the box */
+		double centroid( int k ) const { return 0.5 * ( box.lo[k] + box.hi[k] ); };
+	};
+
+	/*! a bin of the SAH */
+	struct CBin
+	{
+		CBox box;
+		int  count;
+	};
+
+	/*! a node to split, the faces m_prim[begin,end) */
+	struct CItem
+	{
+		int node, begin, end, depth;
+	};
+
+	/*! the mesh */
+	M *                               m_pMesh;
+	/*! the nodes */
+	std::vector<CBVHNode>             m_nodes;
+	/*! the faces, in the leaf order */
+	std::vector<typename M::CFace*>   m_faces;
+	/*! the triangles in the leaf order, p0, p1 - p0, p2 - p0 */
+	std::vector<double>               m_tri;
+	/*! depth of the tree */
+	int                               m_depth;
+
+	/*! build: the faces, partitioned by the nodes */
+	std::vector<CPrim>                m_prim;
+
+	/*!
+	Split a node, the faces are partitioned at mid.
+	\return false if the node is a leaf
+	*/
+	bool _split( const CItem & item, const CBox & box, int threads, int & mid, CBox child[2] );
+	/*! box of the faces m_prim[b,e), or of their centroids */
+	CBox _bounds( int b, int e, bool centroids, int threads ) const;
+	/*! set the box of a node, rounded outwards to floats */
+	static void _set_box( CBVHNode & node, const CBox & box );
+	/*! ray triangle intersection of the face k in the leaf order */
+	bool _intersect_triangle( int k, const double o[3], const double d[3], double tmax, double & t, double & u, double & v ) const;
+	/*! closest point of the face k in the leaf order, returns the squared distance */
+	double _closest_triangle( int k, const double p[3], double q[3], double b[3] ) const;
+	/*! entry parameter of the ray in the box of a node, false if it misses or enters after tmax */
+	static bool _hit_box( const CBVHNode & node, const double o[3], const double inv[3], double tmax, double & tnear );
+	/*! squared distance from a point to the box of a node */
+	static double _box_distance2( const CBVHNode & node, const double p[3] );
+};
+
+template<typename M>
+void CBVH<M>::_set_box( CBVHNode & node, const CBox & box )
+{
+	for( int k = 0; k < 3; k ++ )
+	{
+		float lo = (float) box.lo[k];
+		float hi = (float) box.hi[k];
+		if( (double) lo > box.lo[k] ) lo = nextafterf( lo, -FLT_MAX );
+		if( (double) hi < box.hi[k] ) hi = nextafterf( hi, FLT_MAX );
+		node.lo[k] = lo;
+		node.hi[k] = hi;
+	}
+};
+
+template<typename M>
+void CBVH<M>::build( int threads )
+{
+	threads = parallelThreads( threads );
+
+	std::vector<M::CFace*> faces( m_pMesh->faces().begin(), m_pMesh->faces().end() );
+	int n = (int) faces.size();
+
+	m_nodes.clear();
+	m_faces.clear();
+	m_tri.clear();
+	m_depth = 0;
+	if( n == 0 ) return;
+
+	//boxes and centroids of the faces
+	std::vector<double> tri( 9 * (size_t) n );
+	m_prim.resize( n );
+	parallelFor( (size_t) n, threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ )
+		{
+			double * p = &tri[9*i];
+			int k = 0;
+			for( M::FaceVertexIterator fviter( faces[i] ); !fviter.end() && k < 3; ++ fviter, k ++ )
+			{
+				CPoint & q = (*fviter)->point();
+				for( int j = 0; j < 3; j ++ ) p[3*k+j] = q[j];
+			}
+			CBox box = CBox::empty();
+			for( k = 0; k < 3; k ++ ) box.add( p + 3 * k );
+			m_prim[i].box   = box;
+			m_prim[i].index = (int) i;
+		}
+	});
+
+	CBox root = parallelReduce( (size_t) n, threads, CBox::empty(),
+		[&]( size_t i ) { return m_prim[i].box; },
+		[]( CBox a, const CBox & b ) { a.add( b ); return a; } );
+
+	//the levels one after the other
+	std::vector<CBox> boxes( 1, root );
+	m_nodes.resize( 1 );
+	_set_box( m_nodes[0], root );
+
+	std::vector<CItem> level;
+	CItem top = { 0, 0, n, 1 };
+	level.push_back( top );
+	while( !level.empty() )
+	{
+		size_t L = level.size();
+		std::vector<char> split( L );
+		std::vector<int>  mid( L );
+		std::vector<CBox> child( 2 * L );
+
+		if( L < (size_t) threads )
+		{
+			//few large nodes, the binning of each one is split over the threads
+			for( size_t i = 0; i < L; i ++ ) split[i] = _split( level[i], boxes[level[i].node], threads, mid[i], &child[2*i] );
+		}
+		else
+		{
+			parallelFor( L, threads, [&]( size_t b, size_t e, int )
+			{
+				for( size_t i = b; i < e; i ++ ) split[i] = _split( level[i], boxes[level[i].node], 1, mid[i], &child[2*i] );
+			});
+		}
+
+		std::vector<CItem> next;
+		for( size_t i = 0; i < L; i ++ )
+		{
+			const CItem & item = level[i];
+			m_depth = std::max( m_depth, item.depth );
+			CBVHNode & node = m_nodes[item.node];
+			if( !split[i] )
+			{
+				node.first = item.begin;
+				node.count = item.end - item.begin;
+				continue;
+			}
+			int c = (int) m_nodes.size();
+			node.first = c;
+			node.count = 0;
+			m_nodes.resize( c + 2 );
+			boxes.resize( c + 2 );
+			for( int k = 0; k < 2; k ++ )
+			{
+				boxes[c+k] = child[2*i+k];
+				_set_box( m_nodes[c+k], child[2*i+k] );
+			}
+			CItem left  = { c,     item.begin, mid[i],   item.depth + 1 };
+			CItem right = { c + 1, mid[i],     item.end, item.depth + 1 };
+			next.push_back( left );
+			next.push_back( right );
+		}
+		level.swap( next );
+	}
+
+	//the faces and the triangles in the leaf order
+	m_faces.resize( n );
+	m_tri.resize( 9 * (size_t) n );
+	parallelFor( (size_t) n, threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ )
+		{
+			int f = m_prim[i].index;
+			m_faces[i] = faces[f];
+			const double * p = &tri[9*(size_t)f];
+			double * q = &m_tri[9*i];
+			for( int j = 0; j < 3; j ++ )
+			{
+				q[j]   = p[j];
+				q[3+j] = p[3+j] - p[j];
+				q[6+j] = p[6+j] - p[j];
+			}
+		}
+	});
+
+	std::vector<CPrim>().swap( m_prim );
+};
+
+template<typename M>
+typename CBVH<M>::CBox CBVH<M>::_bounds( int b, int e, bool centroids, int threads ) const
+{
+	if( threads <= 1 || e - b < (int) PARALLEL_REDUCE_BLOCK )
+	{
+		CBox box = CBox::empty();
+		for( int i = b; i < e; i ++ )
+		{
+			if( !centroids ) { box.add( m_prim[i].box ); continue; }
+			double c[3] = { m_prim[i].centroid( 0 ), m_prim[i].centroid( 1 ), m_prim[i].centroid( 2 ) };
+			box.add( c );
+		}
+		return box;
+	}
+	return parallelReduce( (size_t)( e - b ), threads, CBox::empty(),
+		[&]( size_t i )
+		{
+			const CPrim & f = m_prim[b+i];
+			if( !centroids ) return f.box;
+			CBox c;
+			for( int k = 0; k < 3; k ++ ) c.lo[k] = c.hi[k] = f.centroid( k );
+			return c;
+		},
+		[]( CBox x, const CBox & y ) { x.add( y ); return x; } );
+};
+
+template<typename M>
+bool CBVH<M>::_split( const CItem & item, const CBox & box, int threads, int & mid, CBox child[2] )
+{
+	int b = item.begin, e = item.end;
+	int count = e - b;
+	if( count <= BVH_LEAF_SIZE ) return false;
+
+	CBox cb = _bounds( b, e, true, threads );
+	int axis = 0;
+	for( int k = 1; k < 3; k ++ ) if( cb.hi[k] - cb.lo[k] > cb.hi[axis] - cb.lo[axis] ) axis = k;
+	bool flat = !( cb.hi[axis] > cb.lo[axis] );
+	if( flat && count <= BVH_MAX_LEAF ) return false;
+
+	int bin = -1;
+	if( !flat && item.depth < BVH_SAH_DEPTH )
+	{
+		//bin the faces along the three axes, one set of bins per thread
+		CBin local[3*BVH_BINS];
+		std::vector<CBin> shared;
+		CBin * bins = local;
+		if( threads > 1 )
+		{
+			shared.resize( (size_t) threads * 3 * BVH_BINS );
+			bins = &shared[0];
+		}
+		for( int i = 0; i < threads * 3 * BVH_BINS; i ++ ) { bins[i].box = CBox::empty(); bins[i].count = 0; }
+
+		double scale[3];
+		for( int k = 0; k < 3; k ++ ) scale[k] = ( cb.hi[k] > cb.lo[k] )? BVH_BINS / ( cb.hi[k] - cb.lo[k] ) : 0;
+
+		auto binning = [&]( size_t s, size_t t, int th )
+		{
+			CBin * tb = bins + (size_t) th * 3 * BVH_BINS;
+			for( size_t i = s; i < t; i ++ )
+			{
+				const CPrim & f = m_prim[b+i];
+				for( int k = 0; k < 3; k ++ )
+				{
+					int j = (int)( ( f.centroid( k ) - cb.lo[k] ) * scale[k] );
+					j = std::min( std::max( j, 0 ), BVH_BINS - 1 );
+					tb[k*BVH_BINS+j].box.add( f.box );
+					tb[k*BVH_BINS+j].count ++;
+				}
+			}
+		};
+		if( threads > 1 ) parallelFor( (size_t) count, threads, binning );
+		else binning( 0, (size_t) count, 0 );
+		for( int th = 1; th < threads; th ++ )
+		{
+			for( int j = 0; j < 3 * BVH_BINS; j ++ )
+			{
+				bins[j].box.add( bins[(size_t) th * 3 * BVH_BINS + j].box );
+				bins[j].count += bins[(size_t) th * 3 * BVH_BINS + j].count;
+			}
+		}
+
+		//sweep the split planes, cost relative to the intersection of one face
+		double best = DBL_MAX;
+		for( int k = 0; k < 3; k ++ )
+		{
+			if( scale[k] == 0 ) continue;
+			CBin * kb = &bins[k*BVH_BINS];
+			CBox   right[BVH_BINS];
+			int    right_count[BVH_BINS];
+			right[BVH_BINS-1]       = kb[BVH_BINS-1].box;
+			right_count[BVH_BINS-1] = kb[BVH_BINS-1].count;
+			for( int j = BVH_BINS - 2; j > 0; j -- )
+			{
+				right[j] = right[j+1];
+				right[j].add( kb[j].box );
+				right_count[j] = right_count[j+1] + kb[j].count;
+			}
+			CBox l = CBox::empty();
+			int  lc = 0;
+			for( int j = 0; j < BVH_BINS - 1; j ++ )
+			{
+				l.add( kb[j].box );
+				lc += kb[j].count;
+				if( lc == 0 || right_count[j+1] == 0 ) continue;
+				double cost = lc * l.area() + right_count[j+1] * right[j+1].area();
+				if( cost < best )
+				{
+					best = cost;
+					axis = k;
+					bin  = j;
+					child[0] = l;
+					child[1] = right[j+1];
+				}
+			}
+		}
+
+		double area = box.area();
+		if( bin >= 0 && area > 0 ) best = 1.0 + best / area;
+		if( count <= BVH_MAX_LEAF && ( bin < 0 || best >= (double) count ) ) return false;
+	}
+
+	if( bin >= 0 )
+	{
+		double lo = cb.lo[axis], s = BVH_BINS / ( cb.hi[axis] - cb.lo[axis] );
+		CPrim * p = std::partition( &m_prim[b], &m_prim[0] + e, [&]( const CPrim & f )
+		{
+			int j = (int)( ( f.centroid( axis ) - lo ) * s );
+			return std::min( std::max( j, 0 ), BVH_BINS - 1 ) <= bin;
+		});
+		mid = (int)( p - &m_prim[0] );
+	}
+	if( bin < 0 || mid == b || mid == e )
+	{
+		//median split along the longest axis of the centroids
+		mid = b + count / 2;
+		std::nth_element( &m_prim[b], &m_prim[mid], &m_prim[0] + e, [&]( const CPrim & f, const CPrim & g )
+		{
+			double cf = f.centroid( axis ), cg = g.centroid( axis );
+			return ( cf < cg ) || ( cf == cg && f.index < g.index );
+		});
+		child[0] = _bounds( b, mid, false, threads );
+		child[1] = _bounds( mid, e, false, threads );
+	}
+	return true;
+};
+
+template<typename M>
+bool CBVH<M>::_hit_box( const CBVHNode & node, const double o[3], const double inv[3], double tmax, double & tnear )
+{
+	double t0 = 0, t1 = tmax;
+	for( int k = 0; k < 3; k ++ )
+	{
+		double a = ( node.lo[k] - o[k] ) * inv[k];
+		double b = ( node.hi[k] - o[k] ) * inv[k];
+		if( a > b ) std::swap( a, b );
+		if( a > t0 ) t0 = a;
+		if( b < t1 ) t1 = b;
+		if( t0 > t1 ) return false;
+	}
+	tnear = t0;
+	return true;
+};
+
+template<typename M>
+double CBVH<M>::_box_distance2( const CBVHNode & node, const double p[3] )
+{
+	double d2 = 0;
+	for( int k = 0; k < 3; k ++ )
+	{
+		double d = 0;
+		if( p[k] < node.lo[k] ) d = node.lo[k] - p[k];
+		else if( p[k] > node.hi[k] ) d = p[k] - node.hi[k];
+		d2 += d * d;
+	}
+	return d2;
+};
+
+//Moller-Trumbore
+template<typename M>
+bool CBVH<M>::_intersect_triangle( int k, const double o[3], const double d[3], double tmax, double & t, double & u, double & v ) const
+{
+	const double * p0 = &m_tri[9*(size_t)k];
+	const double * e1 = p0 + 3;
+	const double * e2 = p0 + 6;
+
+	double pv[3] = { d[1] * e2[2] - d[2] * e2[1], d[2] * e2[0] - d[0] * e2[2], d[0] * e2[1] - d[1] * e2[0] };
+	double det = e1[0] * pv[0] + e1[1] * pv[1] + e1[2] * pv[2];
+	if( det == 0 ) return false;
+	double inv = 1.0 / det;
+
+	double tv[3] = { o[0] - p0[0], o[1] - p0[1], o[2] - p0[2] };
+	u = ( tv[0] * pv[0] + tv[1] * pv[1] + tv[2] * pv[2] ) * inv;
+	if( u < 0 || u > 1 ) return false;
+
+	double qv[3] = { tv[1] * e1[2] - tv[2] * e1[1], tv[2] * e1[0] - tv[0] * e1[2], tv[0] * e1[1] - tv[1] * e1[0] };
+	v = ( d[0] * qv[0] + d[1] * qv[1] + d[2] * qv[2] ) * inv;
+	if( v < 0 || u + v > 1 ) return false;
+
+	t = ( e2[0] * qv[0] + e2[1] * qv[1] + e2[2] * qv[2] ) * inv;
+	return t >= 0 && t <= tmax;
+};
+
+template<typename M>
+bool CBVH<M>::intersect( const CPoint & origin, const CPoint & direction, CHit & hit, double tmax ) const
+{
+	hit.face = NULL;
+	if( m_nodes.empty() ) return false;
+
+	double o[3], d[3], inv[3];
+	for( int k = 0; k < 3; k ++ )
+	{
+		o[k]   = origin[k];
+		d[k]   = direction[k];
+		inv[k] = 1.0 / ( ( fabs( d[k] ) > 1e-300 )? d[k] : ( ( d[k] < 0 )? -1e-300 : 1e-300 ) );
+	}
+
+	double tnear;
+	if( !_hit_box( m_nodes[0], o, inv, tmax, tnear ) ) return false;
+
+	int    stack[BVH_STACK];
+	double entry[BVH_STACK];
+	int    sp = 0;
+	stack[sp] = 0;
+	entry[sp++] = tnear;
+
+	double best = tmax, bu = 0, bv = 0;
+	int    bk = -1;
+	while( sp > 0 )
+	{
+		sp --;
+		if( entry[sp] > best ) continue;
+		const CBVHNode & node = m_nodes[stack[sp]];
+		if( node.count > 0 )
+		{
+			for( int k = node.first; k < node.first + node.count; k ++ )
+			{
+				double t, u, v;
+				if( _intersect_triangle( k, o, d, best, t, u, v ) )
+				{
+					best = t;
+					bu = u;
+					bv = v;
+					bk = k;
+				}
+			}
+			continue;
+		}
+
+		//the nearer child is visited first
+		double t0, t1;
+		bool h0 = _hit_box( m_nodes[node.first],     o, inv, best, t0 );
+		bool h1 = _hit_box( m_nodes[node.first + 1], o, inv, best, t1 );
+		if( h0 && h1 )
+		{
+			int nearer = ( t0 <= t1 )? 0 : 1;
+			stack[sp] = node.first + 1 - nearer; entry[sp++] = ( nearer == 0 )? t1 : t0;
+			stack[sp] = node.first + nearer;     entry[sp++] = ( nearer == 0 )? t0 : t1;
+		}
+		else if( h0 ) { stack[sp] = node.first;     entry[sp++] = t0; }
+		else if( h1 ) { stack[sp] = node.first + 1; entry[sp++] = t1; }
+	}
+
+	if( bk < 0 ) return false;
+	hit.face    = m_faces[bk];
+	hit.t       = best;
+	hit.bary[0] = 1 - bu - bv;
+	hit.bary[1] = bu;
+	hit.bary[2] = bv;
+	hit.point   = origin + direction * best;
+	return true;
+};
+
+template<typename M>
+void CBVH<M>::intersect( const std::vector<CPoint> & origins, const std::vector<CPoint> & directions, std::vector<CHit> & hits, int threads ) const
+{
+	hits.resize( origins.size() );
+	parallelFor( origins.size(), parallelThreads( threads ), [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ ) intersect( origins[i], directions[i], hits[i] );
+	});
+};
+
+//Ericson, Real-Time Collision Detection, 5.1.5
+template<typename M>
+double CBVH<M>::_closest_triangle( int k, const double p[3], double q[3], double bc[3] ) const
+{
+	const double * a  = &m_tri[9*(size_t)k];
+	const double * ab = a + 3;
+	const double * ac = a + 6;
+	double ap[3] = { p[0] - a[0], p[1] - a[1], p[2] - a[2] };
+
+	double d1 = ab[0] * ap[0] + ab[1] * ap[1] + ab[2] * ap[2];
+	double d2 = ac[0] * ap[0] + ac[1] * ap[1] + ac[2] * ap[2];
+	double u, v;
+	if( d1 <= 0 && d2 <= 0 ) { u = 0; v = 0; }
+	else
+	{
+		//bp = ap - ab, cp = ap - ac
+		double d3 = d1 - ( ab[0] * ab[0] + ab[1] * ab[1] + ab[2] * ab[2] );
+		double d4 = d2 - ( ac[0] * ab[0] + ac[1] * ab[1] + ac[2] * ab[2] );
+		double d5 = d1 - ( ab[0] * ac[0] + ab[1] * ac[1] + ab[2] * ac[2] );
+		double d6 = d2 - ( ac[0] * ac[0] + ac[1] * ac[1] + ac[2] * ac[2] );
+		double vc = d1 * d4 - d3 * d2;
+		double vb = d5 * d2 - d1 * d6;
+		double va = d3 * d6 - d5 * d4;
+
+		if( d3 >= 0 && d4 <= d3 ) { u = 1; v = 0; }
+		else if( d6 >= 0 && d5 <= d6 ) { u = 0; v = 1; }
+		else if( vc <= 0 && d1 >= 0 && d3 <= 0 ) { u = d1 / ( d1 - d3 ); v = 0; }
+		else if( vb <= 0 && d2 >= 0 && d6 <= 0 ) { u = 0; v = d2 / ( d2 - d6 ); }
+		else if( va <= 0 && ( d4 - d3 ) >= 0 && ( d5 - d6 ) >= 0 )
+		{
+			double w = ( d4 - d3 ) / ( ( d4 - d3 ) + ( d5 - d6 ) );
+			u = 1 - w;
+			v = w;
+		}
+		else
+		{
+			double denom = 1.0 / ( va + vb + vc );
+			u = vb * denom;
+			v = vc * denom;
+		}
+	}
+
+	bc[0] = 1 - u - v;
+	bc[1] = u;
+	bc[2] = v;
+	double d = 0;
+	for( int j = 0; j < 3; j ++ )
+	{
+		q[j] = a[j] + u * ab[j] + v * ac[j];
+		d += ( q[j] - p[j] ) * ( q[j] - p[j] );
+	}
+	return d;
+};
+
+template<typename M>
+bool CBVH<M>::closest( const CPoint & point, CHit & hit, double maxDistance ) const
+{
+	hit.face = NULL;
+	if( m_nodes.empty() ) return false;
+
+	double p[3] = { point[0], point[1], point[2] };
+	double best = ( maxDistance < sqrt( DBL_MAX ) )? maxDistance * maxDistance : DBL_MAX;
+	double bq[3], bb[3];
+	int    bk = -1;
+
+	int    stack[BVH_STACK];
+	double dist[BVH_STACK];
+	int    sp = 0;
+	stack[sp] = 0;
+	dist[sp++] = _box_distance2( m_nodes[0], p );
+
+	while( sp > 0 )
+	{
+		sp --;
+		if( dist[sp] > best ) continue;
+		const CBVHNode & node = m_nodes[stack[sp]];
+		if( node.count > 0 )
+		{
+			for( int k = node.first; k < node.first + node.count; k ++ )
+			{
+				double q[3], b[3];
+				double d = _closest_triangle( k, p, q, b );
+				if( d <= best )
+				{
+					best = d;
+					bk = k;
+					for( int j = 0; j < 3; j ++ ) { bq[j] = q[j]; bb[j] = b[j]; }
+				}
+			}
+			continue;
+		}
+
+		//the nearer child is visited first
+		double d0 = _box_distance2( m_nodes[node.first], p );
+		double d1 = _box_distance2( m_nodes[node.first + 1], p );
+		int nearer = ( d0 <= d1 )? 0 : 1;
+		double dn = ( nearer == 0 )? d0 : d1, df = ( nearer == 0 )? d1 : d0;
+		if( df <= best ) { stack[sp] = node.first + 1 - nearer; dist[sp++] = df; }
+		if( dn <= best ) { stack[sp] = node.first + nearer;     dist[sp++] = dn; }
+	}
+
+	if( bk < 0 ) return false;
+	hit.face  = m_faces[bk];
+	hit.t     = sqrt( best );
+	hit.point = CPoint( bq[0], bq[1], bq[2] );
+	for( int j = 0; j < 3; j ++ ) hit.bary[j] = bb[j];
+	return true;
+};
+
+template<typename M>
+void CBVH<M>::closest( const std::vector<CPoint> & points, std::vector<CHit> & hits, int threads ) const
+{
+	hits.resize( points.size() );
+	parallelFor( points.size(), parallelThreads( threads ), [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ ) closest( points[i], hits[i] );
+	});
+};
+
+}//name space MeshLib
+
+#endif //_MESHLIB_BVH_H_ defined
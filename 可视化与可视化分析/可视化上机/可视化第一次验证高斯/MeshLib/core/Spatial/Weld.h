@@ -0,0 +1,143 @@
+/*!
+*      \file Weld.h
+*      \brief Weld the points closer than an epsilon with a spatial hash
+*
+*		The points are put into the cells of a uniform grid of size epsilon, the
+*		cells are hashed into buckets, and the buckets are laid out as in a CSR
+*		matrix by a counting sort, so the grid is built in O(n). Each point then
+*		looks at the 27 cells around it for the smallest point within epsilon, on
+*		several threads, in O(n) expected time.
+*
+*		Each point joins the cluster of the smallest index point within epsilon of it,
+*		the clusters are given by their smallest point. The result depends neither on
+*		the number of threads nor on the hash.
+*/
+
+#ifndef _MESHLIB_WELD_H_
+#define _MESHLIB_WELD_H_
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#include "../Geometry/Point.h"
+#include "../Parallel/Parallel.h"
+
+namespace MeshLib{
+
+/*! hash of a grid cell */
+inline unsigned long long _weldHash( const long long c[3] )
+{
+	unsigned long long h = (unsigned long long) c[0] * 0x9E3779B97F4A7C15ULL;
+	h ^= (unsigned long long) c[1] * 0xC2B2AE3D27D4EB4FULL + ( h << 6 ) + ( h >> 2 );
+	h ^= (unsigned long long) c[2] * 0x165667B19E3779F9ULL + ( h << 6 ) + ( h >> 2 );
+	return h ^ ( h >> 29 );
+};
+
+/*! grid cell of a point, the bits of the coordinates for epsilon 0 */
+inline void _weldCell( const CPoint & p, double epsilon, long long c[3] )
+{
+	for( int k = 0; k < 3; k ++ )
+	{
+		if( epsilon > 0 )
+		{
+			double x = floor( p[k] / epsilon );
+			//far or not finite coordinates share the border cells, the distance test sorts them out
+			if( !( x > -4.0e18 ) ) x = -4.0e18;
+			if( !( x <  4.0e18 ) ) x =  4.0e18;
+			c[k] = (long long) x;
+		}
+		else
+		{
+			double x = p[k] + 0.0;	//-0 and +0 are the same point
+			memcpy( &c[k], &x, sizeof( double ) );
+		}
+	}
+};
+
+/*!
+	Weld the points closer than epsilon.
+	\param points  the points
+	\param epsilon the welding distance, 0 welds the equal points only
+	\param threads number of threads, 0 for all the hardware threads
+	\param rep     the smallest point of the cluster of each point, rep[i] <= i
+	\return number of clusters
+*/
+inline int weldPoints( const std::vector<CPoint> & points, double epsilon, int threads, std::vector<int> & rep )
+{
+	size_t n = points.size();
+	rep.resize( n );
+	if( n == 0 ) return 0;
+	threads = parallelThreads( threads );
+	if( !( epsilon > 0 ) ) epsilon = 0;
+
+	size_t size = 1;
+	while( size < 2 * n ) size <<= 1;
+	const unsigned long long mask = size - 1;
+
+	//cell and bucket of every point
+	std::vector<long long> cell( 3 * n );
+	std::vector<size_t>    bucket( n );
+	parallelFor( n, threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ )
+		{
+			_weldCell( points[i], epsilon, &cell[3*i] );
+			bucket[i] = (size_t)( _weldHash( &cell[3*i] ) & mask );
+		}
+	});
+
+	//counting sort of the points by bucket, in the index order inside a bucket
+	std::vector<size_t> first( size + 1, 0 );
+	for( size_t i = 0; i < n; i ++ ) first[ bucket[i] + 1 ] ++;
+	for( size_t k = 0; k < size; k ++ ) first[k+1] += first[k];
+	std::vector<int> order( n );
+	{
+		std::vector<size_t> next( first.begin(), first.end() - 1 );
+		for( size_t i = 0; i < n; i ++ ) order[ next[ bucket[i] ] ++ ] = (int) i;
+	}
+
+	const double eps2  = epsilon * epsilon;
+	const int    range = ( epsilon > 0 )? 1 : 0;
+
+	parallelFor( n, threads, [&]( size_t b, size_t e, int )
+	{
+		for( size_t i = b; i < e; i ++ )
+		{
+			const CPoint & p = points[i];
+			const long long * c = &cell[3*i];
+			int best = (int) i;
+
+			for( int dx = -range; dx <= range; dx ++ )
+			for( int dy = -range; dy <= range; dy ++ )
+			for( int dz = -range; dz <= range; dz ++ )
+			{
+				long long d[3] = { c[0] + dx, c[1] + dy, c[2] + dz };
+				size_t k = (size_t)( _weldHash( d ) & mask );
+				for( size_t m = first[k]; m < first[k+1]; m ++ )
+				{
+					int j = order[m];
+					if( j >= best ) break;
+					const long long * cj = &cell[3*j];
+					if( cj[0] != d[0] || cj[1] != d[1] || cj[2] != d[2] ) continue;
+					CPoint q = points[j] - p;
+					if( q * q <= eps2 ) { best = j; break; }
+				}
+			}
+			rep[i] = best;
+		}
+	});
+
+	//rep[i] <= i, in the index order the representatives are already final
+	int clusters = 0;
+	for( size_t i = 0; i < n; i ++ )
+	{
+		rep[i] = rep[ rep[i] ];
+		if( rep[i] == (int) i ) clusters ++;
+	}
+	return clusters;
+};
+
+}//name space MeshLib
+
+#endif //_MESHLIB_WELD_H_ defined
@@ -6,6 +6,8 @@
 #include<vector>
 
 #include "ToolMesh.h"
+#include "../MeshLib/core/Operator/Curvature.h"
+#include "../MeshLib/core/Operator/ComplexMap.h"
 
 #ifndef PI
 #define PI 3.1415926535
@@ -42,32 +44,17 @@ namespace MeshLib
 		cout << "бߵ " << m_pMesh->numEdges() << endl;//ŷʾE
 		cout << "" << m_pMesh->numFaces() << endl;//ŷʾF
 		cout << "EulersʾV+F-E" << m_pMesh->numFaces() + m_pMesh->numVertices() - m_pMesh->numEdges() << endl;
-		double ang = 0;//˹֮ ɢ
-		for (M::MeshVertexIterator mv(m_pMesh); !mv.end(); mv++)//mesh.mļеÿб
-		{
-			double temp = 0;
-			M::CVertex* pVertex = mv.value();
-			for (M::VertexInHalfedgeIterator vih(m_pMesh, pVertex); !vih.end(); vih++)//ݱĵҳǰӦа߽ṹ ߽ṹ洢һСƬߵϢ
-			{
-				M::CHalfEdge* pHF = vih.value();//õǰ߽ṹ
-				double a = m_pMesh->edgeLength((CToolEdge*)pHF->he_next()->edge());//Ƭĵһ
-				double b = m_pMesh->edgeLength((CToolEdge*)pHF->he_prev()->edge());//Ƭĵڶ
-				double c = m_pMesh->edgeLength((CToolEdge*)pHF->edge());//Ƭĵ
-				double cos = (a * a + b * b - c * c) / (2 * a * b);//Ҷcosֵ
-				temp += acos(cos);//ݷǺ
-			}
-			if (m_pMesh->isBoundary(pVertex)) {
-				ang += (PI - temp);//ݿϽԭ ǱԵpi-
-			}
-			else
-			{
-				ang += (2 * PI - temp);//ǱԵ2pi-
-			}
-		}
+
+		//ÿֻ߳һΣÿֻһΣٰǿɢ˹ʣ߳
+		//ÿĸ˹ʴ curvature.k() УдCIndexMesh ߾ӿ
+		CCurvature<M> curvature(m_pMesh);
+		curvature.compute();
+
 		cout << endl;
-		double a1 = (m_pMesh->numFaces() + m_pMesh->numVertices() - m_pMesh->numEdges()) * 2 * PI;
+		double a1 = curvature.euler() * 2 * PI;
 		cout << "2*Pi*EulersʾV+F-E " << a1 << endl;
-		cout << "˹֮ͣ " << ang << endl;
+		cout << "˹֮ͣ " << curvature.total() << endl;
+		cout << " " << curvature.error() << endl;
 	}
 
 
@@ -79,45 +66,32 @@ namespace MeshLib
 
 
 
-	void f(double x, double y, double &u, double &v, int n, double a[], double b[]) {
-		complex<double> S(x,y);
-		for (int i = 0; i < n; i++)
-		{
-			complex<double> temp(a[i], b[i]);
-			if (i == 0)
-				S = (S- temp);
-			else
-				S *= (S - temp);
-		}
-		u = S.real();
-		v = S.imag();
-		return;
-	}
-
 	template<typename M>
 	void CTool<M>::homework2()
 	{
 		int n;
-		double a[100], b[100];
 		cout << "" << endl;
-		cin >> n;
-		//n = 1;
+		if (!(cin >> n) || n < 0)
+		{
+			cerr << "ǷǸ" << endl;
+			return;
+		}
+		vector< complex<double> > roots(n);
 		cout << "" << endl;
 		for (int i = 0; i < n; i++)
 		{
 			if(i!=0)
 			cout << "һ" << endl;
-			cin >> a[i] >> b[i];
-		/*	a[i] = 1;
-			b[i] = 1;*/
-		}
-		for (M::MeshVertexIterator mv(m_pMesh); !mv.end(); mv++)
-		{
-			M::CVertex* pVertex = mv.value();
-			//double ax = mv.begin().value()->point()[0];
-			//double ay = mv.begin().value()->point()[1];
-			f(pVertex->point()[0], pVertex->point()[1], pVertex->huv()[0], pVertex->huv()[1], n,a,b);
+			double a, b;
+			if (!(cin >> a >> b))
+			{
+				cerr << "ʵ" << endl;
+				return;
+			}
+			roots[i] = complex<double>(a, b);
 		}
+		//f(z) = (z-z0)(z-z1)...(z-z[n-1])SIMD̼߳㣨ʹȫӲ̣߳дhuv
+		CComplexMap::roots(roots).apply(m_pMesh, CComplexMapHuv(), 0);
 	}
 
 	void ff(double x, double y, double& u, double& v) {
@@ -0,0 +1,127 @@
+/*!
+*      \file benchmark.cpp
+*      \brief Compare the list based kernel CBaseMesh with the index based kernel CIndexMesh
+*
+*		Not part of MeshlibTest.vcxproj, build it as a separate console program:
+*		benchmark.exe input.m [repeat]
+*/
+
+#include <iostream>
+#include <time.h>
+#include "ToolMesh.h"
+#include "../MeshLib/core/Mesh/IndexMesh.h"
+#include "../MeshLib/core/Geometry/SimdMath.h"
+
+#ifndef PI
+#define PI 3.14159265358979323846
+#endif
+
+using namespace std;
+using namespace MeshLib;
+
+/*! sum of the vertex positions, a pure vertex scan */
+template<typename M>
+double _vertex_scan( M * pMesh )
+{
+	double s = 0;
+	for( M::MeshVertexIterator viter( pMesh ); !viter.end(); viter ++ )
+	{
+		M::CVertex * pV = *viter;
+		s += pV->point()[0] + pV->point()[1] + pV->point()[2];
+	}
+	return s;
+}
+
+/*! total Gaussian curvature through the pointer interface, the corner angle at each vertex from its in-halfedges */
+template<typename M>
+double _total_curvature( M * pMesh )
+{
+	double total = 0;
+	for( M::MeshVertexIterator viter( pMesh ); !viter.end(); viter ++ )
+	{
+		M::CVertex * pV = *viter;
+		double angle = 0;
+		for( M::VertexInHalfedgeIterator vih( pMesh, pV ); !vih.end(); vih ++ )
+		{
+			//the angle at the target is opposite to the previous edge
+			M::CHalfEdge * pH = *vih;
+			double a = pMesh->edgeLength( (M::CEdge*)pH->edge() );
+			double b = pMesh->edgeLength( (M::CEdge*)pH->he_next()->edge() );
+			double c = pMesh->edgeLength( (M::CEdge*)pH->he_prev()->edge() );
+			angle += cosineLawFast( a, b, c );
+		}
+		total += ( pMesh->isBoundary( pV ) ? PI : 2 * PI ) - angle;
+	}
+	return total;
+}
+
+/*! total Gaussian curvature through the handle interface of CIndexMesh */
+double _total_curvature_handle( CIndexMesh * pMesh )
+{
+	std::vector<double> angle( pMesh->numVertices(), 0.0 );
+	for( tIndex he = 0; he < pMesh->numHalfEdges(); he ++ )
+	{
+		double a = pMesh->e_length( pMesh->he_edge( he ) );
+		double b = pMesh->e_length( pMesh->he_edge( pMesh->he_next( he ) ) );
+		double c = pMesh->e_length( pMesh->he_edge( pMesh->he_prev( he ) ) );
+		angle[pMesh->he_target( he )] += cosineLawFast( a, b, c );
+	}
+	double total = 0;
+	for( tIndex v = 0; v < (tIndex) angle.size(); v ++ )
+	{
+		total += ( pMesh->v_boundary( v ) ? PI : 2 * PI ) - angle[v];
+	}
+	return total;
+}
+
+/*! elapsed seconds since t */
+static double _seconds( clock_t t )
+{
+	return double( clock() - t ) / CLOCKS_PER_SEC;
+}
+
+void main( int argc, char ** argv )
+{
+	if( argc < 2 )
+	{
+		cout << "Usage: benchmark input.m [repeat]" << endl;
+		return;
+	}
+	int repeat = ( argc > 2 )? atoi( argv[2] ) : 5;
+
+	clock_t t = clock();
+	CTMesh mesh;
+	mesh.read_m( argv[1] );
+	cout << "CBaseMesh  read_m   " << _seconds( t ) << " s" << endl;
+
+	t = clock();
+	CIndexMesh imesh;
+	imesh.read_m( argv[1] );
+	cout << "CIndexMesh read_m   " << _seconds( t ) << " s" << endl;
+
+	cout << "V " << mesh.numVertices() << "/" << imesh.numVertices()
+		 << " E " << mesh.numEdges() << "/" << imesh.numEdges()
+		 << " F " << mesh.numFaces() << "/" << imesh.numFaces() << endl;
+
+	double s0 = 0, s1 = 0;
+	t = clock();
+	for( int i = 0; i < repeat; i ++ ) s0 = _vertex_scan( &mesh );
+	cout << "CBaseMesh  vertex scan      " << _seconds( t ) / repeat << " s" << endl;
+	t = clock();
+	for( int i = 0; i < repeat; i ++ ) s1 = _vertex_scan( &imesh );
+	cout << "CIndexMesh vertex scan      " << _seconds( t ) / repeat << " s  (" << s0 << " / " << s1 << ")" << endl;
+
+	t = clock();
+	for( int i = 0; i < repeat; i ++ ) s0 = _total_curvature( &mesh );
+	cout << "CBaseMesh  curvature        " << _seconds( t ) / repeat << " s" << endl;
+	t = clock();
+	for( int i = 0; i < repeat; i ++ ) s1 = _total_curvature( &imesh );
+	cout << "CIndexMesh curvature        " << _seconds( t ) / repeat << " s" << endl;
+	double s2 = 0;
+	t = clock();
+	for( int i = 0; i < repeat; i ++ ) s2 = _total_curvature_handle( &imesh );
+	cout << "CIndexMesh curvature handle " << _seconds( t ) / repeat << " s" << endl;
+
+	cout << "total curvature " << s0 << " / " << s1 << " / " << s2 << endl;
+	cout << "2*PI*Euler " << 2 * PI * ( mesh.numVertices() + mesh.numFaces() - mesh.numEdges() ) << endl;
+}